@@ -24,6 +24,7 @@ extern "C" {
 #include <dtg-utils.h>
 }
 #include "MyDTG.h"
+#include "MyDTS.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -174,6 +175,24 @@ void dt_free( void *dtID, struct DTGError *error )
 	return;
 }
 
+DL_EXPORT_FTN
+void dt_thread_begin()
+{
+#ifdef DEBUG
+	fprintf( useLog(), "dt_thread_begin()\n" );
+#endif
+	MyDTS::thread_begin();
+}
+
+DL_EXPORT_FTN
+void dt_thread_end()
+{
+#ifdef DEBUG
+	fprintf( useLog(), "dt_thread_end()\n" );
+#endif
+	MyDTS::thread_end();
+}
+
 DL_EXPORT_FTN
 const char *dt_get_server_version( void *dtID, struct DTGError *error )
 {
@@ -335,6 +354,62 @@ struct DTGStrList *proj_list_changed_defects( void *projID,
 			mod_date_field, mod_by_field, exclude_user, error );
 }
 
+DL_EXPORT_FTN
+void *proj_open_changed_defects( void *projID,
+					int page_size,
+					struct DTGDate *since,
+					const char *mod_date_field,
+					const char *mod_by_field,
+					const char *exclude_user,
+					struct DTGError *error )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "proj_open_changed_defects(%d)\n", page_size );
+#endif
+	MyDTGProj *mydtproj = MyDTGProj::convert( projID );
+	if( !mydtproj )
+	{
+	    set_DTGError( error, "proj_open_changed_defects:Unknown projID" );
+	    return NULL;
+	}
+
+	return mydtproj->open_changed_defects( page_size, since, error );
+}
+
+DL_EXPORT_FTN
+struct DTGStrList *cursor_next_defects( void *cursorID, 
+					struct DTGError *error )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "cursor_next_defects()\n" );
+#endif
+	MyDTGCursor *mycursor = MyDTGCursor::convert( cursorID );
+	if( !mycursor )
+	{
+	    set_DTGError( error, "cursor_next_defects: Unknown cursorID" );
+	    return NULL;
+	}
+
+	return mycursor->next_page( error );
+}
+
+DL_EXPORT_FTN
+void cursor_free( void *cursorID, struct DTGError *error )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "cursor_free()\n" );
+#endif
+	MyDTGCursor *mycursor = MyDTGCursor::convert( cursorID );
+	if( !mycursor )
+	{
+	    set_DTGError( error, "cursor_free: Unknown cursorID" );
+	    return;
+	}
+
+	delete mycursor;
+	clear_DTGError( error );
+}
+
 DL_EXPORT_FTN
 void proj_segment_filters( void *projID, struct DTGFieldDesc *filters )
 {
@@ -366,6 +441,23 @@ void *proj_get_defect( void *projID, const char *defect, struct DTGError *error
 	return mydtproj->get_defect( defect, error );
 }
 
+DL_EXPORT_FTN
+int proj_get_defects( void *projID, struct DTGStrList *defects, 
+			void **defectIDs, struct DTGError *error )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "proj_get_defects()\n" );
+#endif
+	MyDTGProj *mydtproj = MyDTGProj::convert( projID );
+	if( !mydtproj )
+	{
+	    set_DTGError( error, "proj_get_defects: Unknown projID" );
+	    return 0;
+	}
+
+	return mydtproj->get_defects( defects, defectIDs, error );
+}
+
 DL_EXPORT_FTN
 void *proj_new_defect( void *projID, struct DTGError *error )
 {
@@ -469,6 +561,24 @@ char *defect_save( void *defectID, struct DTGError *error )
 	return mydtdefect->save( error );
 }
 
+DL_EXPORT_FTN
+int proj_save_defects( void *projID, int count, void **defectIDs,
+			char **ids, struct DTGError *errors )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "proj_save_defects()\n" );
+#endif
+	MyDTGProj *mydtproj = MyDTGProj::convert( projID );
+	if( !mydtproj )
+	{
+	    for( int i = 0; i < count; i++ )
+	        set_DTGError( &errors[i], "proj_save_defects: Unknown projID" );
+	    return 0;
+	}
+
+	return mydtproj->save_defects( count, defectIDs, ids, errors );
+}
+
 DL_EXPORT_FTN
 void free_char( char *obj )
 {
@@ -26,6 +26,7 @@ extern "C" {
 class MyDTS;
 class MyDTGProj;
 class MyDTGDefect;
+class MyDTGCursor;
 
 class MyDTG {
     public:
@@ -102,6 +103,13 @@ class MyDTGProj {
 						const char *exclude_user,
 	                                        struct DTGError *error );
 	MyDTGDefect *get_defect( const char *defect, struct DTGError *error );
+	MyDTGCursor *open_changed_defects( int page_size,
+						struct DTGDate *since,
+						struct DTGError *error );
+	int get_defects( struct DTGStrList *defects, void **results,
+					struct DTGError *error );
+	int save_defects( int cnt, void **defects, char **ids,
+					struct DTGError *errors );
 	MyDTGDefect *new_defect( struct DTGError *error );
 	void segment_filters( struct DTGFieldDesc *filters );
 };
@@ -120,6 +128,10 @@ class MyDTGDefect {
 	MyDTGDefect( MyDTGProj *proj, 
 			const char *defect, 
 			struct DTGError *error );
+	MyDTGDefect( MyDTGProj *proj, 
+			const char *defect, 
+			struct DTGField *fields,
+			struct DTGError *error );
 	~MyDTGDefect();
 
 	static MyDTGDefect *convert( void *obj )
@@ -138,4 +150,29 @@ class MyDTGDefect {
 	char *save( struct DTGError *error );
 };
 
+class MyDTGCursor {
+    public:
+	static const char *MyDTGMagic;
+	const char *magic;
+	MyDTGProj *in_proj;
+	struct DTGDate *since;
+	int page_size;
+	char *last;
+	int done;
+
+	MyDTGCursor( MyDTGProj *proj, int page_size, struct DTGDate *since );
+	~MyDTGCursor();
+
+	static MyDTGCursor *convert( void *obj )
+	{
+	    MyDTGCursor *me = (MyDTGCursor *)obj;
+	    if( me && me->magic == MyDTGMagic )
+	        return me;
+	    else
+	        return NULL;
+	};
+
+	struct DTGStrList *next_page( struct DTGError *error );
+};
+
 #endif
@@ -223,6 +223,77 @@ struct DTGStrList *MyDTGProj::list_changed_defects( int max_rows,
 	return list;
 }
 
+MyDTGCursor *MyDTGProj::open_changed_defects( int page_size,
+						struct DTGDate *since,
+						struct DTGError *error )
+{
+	clear_DTGError( error );
+	return new MyDTGCursor( this, page_size, since );
+}
+
+/*
+	Pages through the changed bugs in bug_id order, each page starting
+	after the last bug_id returned, so a bug saved meanwhile is at worst
+	returned again.
+*/
+
+const char *MyDTGCursor::MyDTGMagic = "MyDTGCursorClass";
+
+MyDTGCursor::MyDTGCursor( MyDTGProj *proj, int size, struct DTGDate *date )
+{
+	magic = MyDTGMagic;
+	in_proj = proj;
+	since = copy_DTGDate( date );
+	page_size = size > 0 ? size : 1;
+	last = cp_string( "" );
+	done = 0;
+}
+
+MyDTGCursor::~MyDTGCursor()
+{
+	magic = NULL;
+	delete_DTGDate( since );
+	delete[] last;
+}
+
+struct DTGStrList *MyDTGCursor::next_page( struct DTGError *error )
+{
+	clear_DTGError( error );
+	if( done )
+	    return NULL;
+	if( in_proj->testing ) 
+	{
+	    done = 1;
+	    return new_DTGStrList( "*defect*" );
+	}
+
+	char *err = NULL;
+	struct DTGStrList *list = in_proj->in_dt->dts->list_jobs( page_size, 
+					since, NULL, NULL, NULL, 
+					in_proj->seg_filters, err, last );
+	if( err )
+	{
+	    set_DTGError( error, err );
+	    error->can_continue = in_proj->in_dt->dts->is_valid();
+	    delete[] err;
+	    delete_DTGStrList( list );
+	    return NULL;
+	}
+
+	int cnt = 0;
+	struct DTGStrList *l = list;
+	for( ; l && l->next; l = l->next, cnt++ );
+	if( l )
+	{
+	    delete[] last;
+	    last = cp_string( l->value );
+	    cnt++;
+	}
+	if( cnt < page_size )
+	    done = 1;
+	return list;
+}
+
 MyDTGDefect *MyDTGProj::get_defect( const char *defect, struct DTGError *error )
 {
 	MyDTGDefect *item = new MyDTGDefect( this, defect, error );
@@ -234,6 +305,128 @@ MyDTGDefect *MyDTGProj::get_defect( const char *defect, struct DTGError *error )
 	return item;
 }
 
+int MyDTGProj::get_defects( struct DTGStrList *defects, void **results,
+					struct DTGError *error )
+{
+	int cnt = 0;
+	for( struct DTGStrList *d = defects; d; d = d->next )
+	    results[cnt++] = NULL;
+	clear_DTGError( error );
+	if( testing || !cnt )
+	    return 0;
+
+	struct DTGField **rows = new struct DTGField *[cnt];
+	memset( rows, 0, sizeof(struct DTGField *) * cnt );
+	char *err = NULL;
+	in_dt->dts->get_defects( defects, rows, err );
+	if( err )
+	{
+	    set_DTGError( error, err );
+	    error->can_continue = in_dt->dts->is_valid();
+	    delete[] err;
+	    for( int i = 0; i < cnt; i++ )
+	        delete_DTGField( rows[i] );
+	    delete[] rows;
+	    return 0;
+	}
+
+	int loaded = 0;
+	struct DTGStrList *d = defects;
+	for( int i = 0; i < cnt; i++, d = d->next )
+	    if( rows[i] )
+	    {
+	        results[i] = new MyDTGDefect( this, d->value, rows[i], error );
+	        loaded++;
+	    }
+	clear_DTGError( error );
+	delete[] rows;
+	return loaded;
+}
+
+/*
+	Saves the defects in one transaction, undoing any defect which fails
+	alone. If the commit fails none are saved, so each is given the error
+	and left dirty.
+*/
+
+int MyDTGProj::save_defects( int cnt, void **defects, char **ids,
+					struct DTGError *errors )
+{
+	MyDTS *dts = in_dt->dts;
+	char *err = NULL;
+	int batch = !testing && dts->begin_batch( err );
+	if( err )
+	{
+	    // Saved one at a time
+	    delete[] err;
+	    err = NULL;
+	}
+
+	int saved = 0;
+	int i;
+	for( i = 0; i < cnt; i++ )
+	{
+	    ids[i] = NULL;
+	    MyDTGDefect *defect = MyDTGDefect::convert( defects[i] );
+	    if( !defect )
+	    {
+	        set_DTGError( &errors[i], "proj_save_defects: Unknown defectID" );
+	        continue;
+	    }
+	    if( batch && defect->dirty )
+	        dts->mark_batch( err );
+	    if( err )
+	    {
+	        set_DTGError( &errors[i], err );
+	        errors[i].can_continue = dts->is_valid();
+	        delete[] err;
+	        err = NULL;
+	        continue;
+	    }
+	    ids[i] = defect->save( &errors[i] );
+	    if( !errors[i].message )
+	    {
+	        saved++;
+	        continue;
+	    }
+	    if( batch )
+	    {
+	        dts->undo_batch( err );
+	        if( err )
+	            delete[] err;
+	        err = NULL;
+	    }
+	    if( !errors[i].can_continue )
+	        break;
+	}
+	for( int j = i + 1; j < cnt; j++ )
+	{
+	    ids[j] = NULL;
+	    set_DTGError( &errors[j], errors[i].message );
+	    errors[j].can_continue = 0;
+	}
+
+	if( batch && !dts->end_batch( err ) )
+	{
+	    for( i = 0; i < cnt; i++ )
+	    {
+	        if( errors[i].message )
+	            continue;
+	        set_DTGError( &errors[i], err );
+	        errors[i].can_continue = dts->is_valid();
+	        if( ids[i] )
+	            free( ids[i] );
+	        ids[i] = NULL;
+	        MyDTGDefect *defect = MyDTGDefect::convert( defects[i] );
+	        if( defect )
+	            defect->dirty = 1;
+	    }
+	    delete[] err;
+	    saved = 0;
+	}
+	return saved;
+}
+
 MyDTGDefect *MyDTGProj::new_defect( struct DTGError *error )
 {
 	const char *err = mk_string( "The ", in_dt->get_name( error ),
@@ -257,8 +450,6 @@ MyDTGDefect *MyDTGProj::new_defect( struct DTGError *error )
 */
 static char *extract_filter_string( MyDTG *in_dt, struct DTGFieldDesc *f )
 {
-	struct DTGField *field_names = in_dt->dts->field_names(),
-	                *products = in_dt->dts->product_names();
 	char *query = NULL, *tmp = NULL;
 
 	for( ; f; f = f->next )
@@ -266,8 +457,6 @@ static char *extract_filter_string( MyDTG *in_dt, struct DTGFieldDesc *f )
 	    if( !f->select_values )
 	    {
 	        delete[] query;
-	        delete_DTGField( field_names );
-	        delete_DTGField( products );
 	        return NULL;
 	    }
 
@@ -291,10 +480,10 @@ static char *extract_filter_string( MyDTG *in_dt, struct DTGFieldDesc *f )
 	                *idx = '\0';
 	                res_val = idx + 1;
 	            }
-	            const char *res_tab = in_dt->dts->find_value( field_names,
-	                                                          "Resolution");
-	            const char *stat_tab = in_dt->dts->find_value( field_names,
-	                                                           "Status" );
+	            const char *res_tab = 
+				in_dt->dts->field_column( "Resolution" );
+	            const char *stat_tab = 
+				in_dt->dts->field_column( "Status" );
 	            tmp1 = mk_string( "`", stat_tab, "` = '", stat_val, "'",
 	                              " AND `", res_tab, "` = '", res_val, "'");
 	            tmp = mk_string( tmp, tmp1 );
@@ -316,8 +505,8 @@ static char *extract_filter_string( MyDTG *in_dt, struct DTGFieldDesc *f )
 	            const char *prod_tab = "product_id";
 	            const char *comp_tab = "component_id";
 
-	            const char *prod_val = in_dt->dts->find_value( products,
-	                                                           prod_name );
+	            const char *prod_val = 
+				in_dt->dts->product_id( prod_name );
 	                  char *comp_val = in_dt->dts->component_name(
 	                                                 comp_name, prod_val );
 	            tmp1 = mk_string( "`", prod_tab, "` = ", prod_val, " AND `",
@@ -331,8 +520,8 @@ static char *extract_filter_string( MyDTG *in_dt, struct DTGFieldDesc *f )
 	        else if( !strcmp( f->name, "Product" ) )
 	        {
 	            // These aren't in the field map, so hard-code them.
-	            const char *prod_val = in_dt->dts->find_value( products,
-	                                                           i->value );
+	            const char *prod_val = 
+				in_dt->dts->product_id( i->value );
 	            tmp1 = mk_string( tmp, "`product_id` = ", prod_val );
 	            delete[] tmp;
 	            tmp = tmp1;
@@ -341,8 +530,8 @@ static char *extract_filter_string( MyDTG *in_dt, struct DTGFieldDesc *f )
 	        {
 	            // These fields are more free-form, so we escape them.
 	            char *esc = in_dt->dts->esc_field( i->value );
-	            tmp1 = mk_string( tmp, "`", in_dt->dts->find_value(
-	                             field_names, f->name ), "` = '", esc, "'");
+	            tmp1 = mk_string( tmp, "`", in_dt->dts->field_column(
+	                             f->name ), "` = '", esc, "'");
 	            delete[] tmp;
 	            tmp = tmp1;
 	            free( esc );
@@ -363,8 +552,6 @@ static char *extract_filter_string( MyDTG *in_dt, struct DTGFieldDesc *f )
 	    delete[] query;
 	    query = tmp;
 	}
-	delete_DTGField( field_names );
-	delete_DTGField( products );
 	return query;
 }
 
@@ -21,6 +21,7 @@
 #include <string.h>
 #include <time.h>
 #include "MyDTS.h"
+#include "NameMap.h"
 extern "C" {
 #include "dtg-utils.h"
 }
@@ -91,15 +92,6 @@ struct DTGField *get_field( struct DTGField *fields, const char *id )
 	return fields;
 }
 
-const char *MyDTS::find_value( struct DTGField *fields, const char *id )
-{
-	if( !id )
-	    return NULL;
-	while( fields && strcmp( fields->value, id ) )
-	    fields = fields->next;
-	return fields ? fields->name : id;
-}
-
 const char *find_field( struct DTGField *fields, const char *id )
 {
 	fields = get_field( fields, id );
@@ -138,8 +130,7 @@ DTGField *MyDTS::single_row( const char *query, char *&err )
 	    MYSQL_ROW row = mysql_fetch_row( res );
 	    for( unsigned int i = 0; row && i < f; i++ )
 	        fields = append_DTGField( fields, new_DTGField(
-	                        find_field( field_map, cols[i].name ),
-	                        row[i] ) );
+	                        field_label( cols[i].name ), row[i] ) );
 	    mysql_free_result( res );
 	}
 	else
@@ -159,8 +150,12 @@ MyDTS::single_col( const char *query, char *&err )
 	    if( !res )
 	        return values;
 	    MYSQL_ROW row;
+	    struct DTGStrList **last = &values;
 	    while( ( row = mysql_fetch_row( res ) ) )
-	        values = append_DTGStrList( values, row[0] );
+	    {
+	        *last = new_DTGStrList( row[0] );
+	        last = &(*last)->next;
+	    }
 	    mysql_free_result( res );
 	}
 	else
@@ -170,6 +165,23 @@ MyDTS::single_col( const char *query, char *&err )
 	return values;
 }
 
+/* Appends a comment to a description as the Description field shows it */
+
+static void add_comment( char *&desc, int &cnt, const char *text,
+			const char *who, const char *when )
+{
+	char cnttxt[11];
+	sprintf( cnttxt, "%d", cnt++ );
+	char *tmp = mk_string( text, "\n",
+				"--- Comment ", cnttxt,
+				": From ", who,
+				" at ", when );
+	char *tmp2 = mk_string( desc, tmp, "\n\n" );
+	delete[] tmp;
+	delete[] desc;
+	desc = tmp2;
+}
+
 char *MyDTS::get_description( const char *bugid, char *&err )
 {
 	char *query = mk_string(
@@ -186,20 +198,8 @@ char *MyDTS::get_description( const char *bugid, char *&err )
 	        return NULL;
 	    MYSQL_ROW row;
 	    int cnt = 0;
-	    char cnttxt[11];
 	    while( ( row = mysql_fetch_row( res ) ) )
-	    {
-	        sprintf( cnttxt, "%d", cnt++ );
-	        char *tmp = mk_string( row[4], "\n",
-					"--- Comment ", cnttxt,
-					": From ",
-					find_field( profile_map, row[0] ),
-					" at ", row[1] );
-	        char *tmp2 = mk_string( desc, tmp, "\n\n" );
-	        delete[] tmp;
-	        delete[] desc;
-	        desc = tmp2;
-	    }
+	        add_comment( desc, cnt, row[4], user_name( row[0] ), row[1] );
 	    mysql_free_result( res );
 	}
 	else
@@ -241,6 +241,28 @@ int MyDTS::no_privs( char *&err )
 	return 0;
 }
 
+/*
+	The client library is set up once as the plug-in loads, before any
+	thread can connect. Threads other than the one a connection was
+	made on set up their own state with thread_begin().
+*/
+
+static class MySQLLibrary {
+	public:
+	    MySQLLibrary() { mysql_library_init( 0, NULL, NULL ); };
+	    ~MySQLLibrary() { mysql_library_end(); };
+} mysql_library;
+
+void MyDTS::thread_begin()
+{
+	mysql_thread_init();
+}
+
+void MyDTS::thread_end()
+{
+	mysql_thread_end();
+}
+
 MyDTS::MyDTS( const char *server,
 		const char *user,
 		const char *pass,
@@ -263,10 +285,13 @@ MyDTS::MyDTS( const char *server,
 	    my_pass = NULL;
 
 	use_profile = NULL;
-	field_map = NULL;
-	profile_map = NULL;
-	product_map = NULL;
-	component_map = NULL;
+	field_map = new NameMap( "fielddefs", "name", "description", 0 );
+	field_ids = new NameMap( "fielddefs", "id", "description" );
+	profile_map = new NameMap( "profiles", "userid", "login_name" );
+	product_map = new NameMap( "products", "id", "name" );
+	component_map = new NameMap( "components", "id", "name" );
+	fix_stmt = stamp_stmt = NULL;
+	in_batch = 0;
 
 	mysql = NULL;
 	if( err )
@@ -368,29 +393,29 @@ MyDTS::MyDTS( const char *server,
 	delete[] uq;
 
 	if( valid )
-	    profile_map = two_cols( "SELECT userid, login_name FROM profiles" );
+	    profile_map->load( mysql );
 
 	f = get_field( (DTGField*)attrs, "bugz_user" );
 	if( f && strlen( f->value ) )    /* use the supplied bugzilla account */
 	{
-	    const char* pmname = find_value( profile_map, f->value );
-	    if( !strcmp( pmname, f->value ) )
+	    const char* pmname = profile_map->id( mysql, f->value );
+	    if( !pmname )
 	        err = mk_string( "\nFailed to find the supplied Bugzilla user ",
 	                        "account.  Looked for \"", f->value, "\".\n" );
 	    else
-	        use_profile = cp_string( find_value( profile_map, pmname ) );
+	        use_profile = cp_string( pmname );
 	}
 	else    /* no specific bugzilla user name set, so use the sql name */
 	{
-	    const char* pmname = find_value( profile_map, my_user );
-	    if( !pmname || !strcmp( pmname, my_user ) )
+	    const char* pmname = profile_map->id( mysql, my_user );
+	    if( !pmname )
 	        err = mk_string( "\nFailed to find the same Bugzilla user ",
 	            "name as that of your MySQL account.  Looked for ",
 	            "\"", my_user, "\".\n", "\nTry the \"Bugzilla ",
 	            "username\" field under the \"Edit ",
 	            "attributes...\" button.\n" );
 	    else
-	        use_profile = cp_string( find_value( profile_map, my_user ) );
+	        use_profile = cp_string( pmname );
 	}
 }
 
@@ -404,20 +429,18 @@ MyDTS::~MyDTS()
 	    delete[] my_pass;
 	if( use_profile )
 	    delete[] use_profile;
-	if( field_map )
-	    delete_DTGField( field_map );
-	if( profile_map )
-	    delete_DTGField( profile_map );
-	if( product_map )
-	    delete_DTGField( product_map );
-	if( component_map )
-	    delete_DTGField( component_map );
+	delete field_map;
+	delete field_ids;
+	delete profile_map;
+	delete product_map;
+	delete component_map;
 	if( bz_db )
 	  delete[] bz_db;
 	if( bz_cf )
 	  delete[] bz_cf;
 
 	// Close connections
+	close_stmts();
 	if( mysql )
 	    mysql_close( mysql );
 }
@@ -457,6 +480,10 @@ MyDTS::connected( char *&err)
 	if( !mysql )
 	    return valid;
 
+	// Statements do not survive the connection
+	close_stmts();
+	in_batch = 0;
+
 	int arg = MYSQL_PROTOCOL_TCP;
 	mysql_options( mysql, MYSQL_OPT_PROTOCOL, (const char *)(&arg) );
 
@@ -606,37 +633,32 @@ struct DTGStrList *MyDTS::get_prod_components( const char *product, char *&err )
 	return list;
 }
 
-struct DTGField *MyDTS::two_cols( const char *query )
+/* The bugs column of a field label, e.g. 'OS/Version' -> op_sys */
+
+const char *MyDTS::field_column( const char *label )
+{
+	load_maps();
+	const char *column = field_map->id( mysql, label );
+	return column ? column : label;
+}
+
+const char *MyDTS::field_label( const char *column )
 {
-	struct DTGField *list = NULL;
-	if( !mysql_query( mysql, query ) )
-	{
-	    MYSQL_RES *res = mysql_store_result( mysql );
-	    MYSQL_ROW row;
-	    while( ( row = mysql_fetch_row( res ) ) )
-	        list = append_DTGField( list, new_DTGField( row[0], row[1] ) );
-	    mysql_free_result( res );
-	}
-	return list;
+	const char *label = field_map->name( mysql, column );
+	return label ? label : column;
 }
 
-struct DTGField *MyDTS::field_names()
+const char *MyDTS::user_name( const char *userid )
 {
-	struct DTGField *list =
-		two_cols( "SELECT name, description FROM fielddefs" );
-	if( list )
-	{
-	    list = append_DTGField( list,
-				new_DTGField( "product_id", "Product" ) );
-	    list = append_DTGField( list,
-				new_DTGField( "component_id", "Component" ) );
-	}
-	return list;
+	const char *login = profile_map->name( mysql, userid );
+	return login ? login : userid;
 }
 
-struct DTGField *MyDTS::product_names()
+const char *MyDTS::product_id( const char *name )
 {
-	return two_cols( "SELECT id, name FROM products" );
+	load_maps();
+	const char *id = product_map->id( mysql, name );
+	return id ? id : name;
 }
 
 char *MyDTS::component_name( const char *comp_name, const char *prod_id )
@@ -657,8 +679,7 @@ char *MyDTS::component_name( const char *comp_name, const char *prod_id )
 struct DTGFieldDesc *MyDTS::get_field_desc( const char *proj, char *&err )
 {
 	struct DTGFieldDesc *list = NULL;
-	if( !field_map )
-	    field_map = field_names();
+	load_maps();
 	if( !mysql_query( mysql, "describe bugs" ) )
 	{
 	    list = append_DTGFieldDesc( list,
@@ -791,7 +812,7 @@ struct DTGFieldDesc *MyDTS::get_field_desc( const char *proj, char *&err )
 
 	        if( type )
 	            list = append_DTGFieldDesc( list,
-			new_DTGFieldDesc( find_field( field_map, row[0] ),
+			new_DTGFieldDesc( field_label( row[0] ),
 					type, rwflag, options ) );
 	    }
 	    mysql_free_result( res );
@@ -805,7 +826,7 @@ struct DTGStrList *
 MyDTS::list_jobs( int max_rows,
 		struct DTGDate *since, const char *mod_date_field,
 		const char *exclude_user, const char *mod_by_field,
-		const char *seg_filters, char *&err )
+		const char *seg_filters, char *&err, const char *after )
 {
 	if( !connected( err ) )
 	    return NULL;
@@ -818,24 +839,74 @@ MyDTS::list_jobs( int max_rows,
 		since->hour, since->minute, since->second,
 		'"'
 	);
-	char *query = mk_string( q0, seg_filters );
+	char *query;
+	if( after )
+	{
+	    // One page, in bug_id order, of the bugs following after
+	    char limit[32];
+	    sprintf( limit, "%d", max_rows );
+	    char *qafter = esc_field( after );
+	    query = mk_string( q0, seg_filters, 
+			*after ? " AND bug_id > \"" : "", 
+			*after ? qafter : "", *after ? "\"" : "",
+			" ORDER BY bug_id LIMIT ", limit );
+	    free( qafter );
+	}
+	else
+	    query = mk_string( q0, seg_filters );
 	struct DTGStrList *list = single_col( query, err );
 	delete[] query;
 
 	return list;
 }
 
-struct DTGField *MyDTS::get_defect( const char *defect, char *&err )
+void MyDTS::load_maps()
 {
 	// Initialize maps if needed
-	if( !profile_map )
-	    profile_map = two_cols( "SELECT userid, login_name FROM profiles" );
-	if( !field_map )
-	    field_map = field_names();
-	if( !product_map )
-	    product_map = two_cols( "SELECT id, name FROM products" );
-	if( !component_map )
-	    component_map = two_cols( "SELECT id, name FROM components" );
+	if( !profile_map->loaded() )
+	    profile_map->load( mysql );
+	if( !field_map->loaded() && field_map->load( mysql ) )
+	{
+	    field_map->add( "product_id", "Product" );
+	    field_map->add( "component_id", "Component" );
+	}
+	if( !field_ids->loaded() )
+	    field_ids->load( mysql );
+	if( !product_map->loaded() )
+	    product_map->load( mysql );
+	if( !component_map->loaded() )
+	    component_map->load( mysql );
+}
+
+/* Replaces the profile, product and component ids with their names */
+
+static void map_name( MYSQL *mysql, struct DTGField *result, 
+			const char *field, NameMap *map )
+{
+	// QAContact can be null on bugs logged before the QAContact
+	// feature was enabled on the Bugzilla instance.
+	DTGField *f = get_field( result, field );
+	if( !f || !f->value )
+	    return;
+	const char *tmp = map->name( mysql, f->value );
+	if( !tmp )
+	    return; // Left as the id
+	free( f->value );
+	f->value = strdup( tmp );
+}
+
+void MyDTS::map_names( struct DTGField *result )
+{
+	map_name( mysql, result, "AssignedTo", profile_map );
+	map_name( mysql, result, "QAContact", profile_map );
+	map_name( mysql, result, "ReportedBy", profile_map );
+	map_name( mysql, result, "Product", product_map );
+	map_name( mysql, result, "Component", component_map );
+}
+
+struct DTGField *MyDTS::get_defect( const char *defect, char *&err )
+{
+	load_maps();
 
 	// Retrieve specified defect and return the field values
 	char* qdefect = esc_field( defect );
@@ -843,70 +914,237 @@ struct DTGField *MyDTS::get_defect( const char *defect, char *&err )
 		mk_string( "SELECT * FROM bugs WHERE bug_id = ", qdefect );
 	free( qdefect );
 	DTGField *result = single_row( query, err );
-	DTGField *field = get_field( result, "AssignedTo" );
-	if( field && field->value )
+	map_names( result );
+	delete[] query;
+	if( !result )
+	    err = cp_string( "Defect not found" );
+	else
 	{
-	    const char *tmp = find_field( profile_map, field->value );
-	    free( field->value );
-	    if( tmp )
-	        field->value = strdup( tmp );
-	    else
-	        field->value = strdup( "NotFound" );
+	    char *desc = get_description( defect, err );
+	    if( desc )
+	        result = append_DTGField( result,
+				new_DTGField( "Description", desc ) );
+	    delete[] desc;
+	}
+	return result;
+}
+
+/*
+	Retrieves several bugs with a single query, results[i] being set
+	for ids[i] when found, and all their comments with a second one.
+	Both are streamed with mysql_use_result(), so lookups needing the
+	server wait until a result is read. Bugs not returned are left NULL
+	for the caller to load individually.
+*/
+
+int MyDTS::get_defects( struct DTGStrList *ids, struct DTGField **results,
+							char *&err )
+{
+	if( !connected( err ) )
+	    return 0;
+	load_maps();
+
+	int cnt = 0;
+	char *in = NULL;
+	for( struct DTGStrList *id = ids; id; id = id->next, cnt++ )
+	{
+	    char *qdefect = esc_field( id->value );
+	    char *tmp = in ? mk_string( in, ", \"", qdefect, "\"" ) 
+			   : mk_string( "\"", qdefect, "\"" );
+	    free( qdefect );
+	    delete[] in;
+	    in = tmp;
 	}
-	field = get_field( result, "QAContact" );
-	if( field && field->value )
+	if( !in )
+	    return 0;
+	char *query = 
+		mk_string( "SELECT * FROM bugs WHERE bug_id IN ( ", in, " )" );
+
+	int found = 0;
+	if( mysql_query( mysql, query ) )
 	{
-	    // QAContact can be null on bugs logged before the QAContact
-	    // feature was enabled on the Bugzilla instance.
-	    const char *tmp = find_field( profile_map, field->value );
-	    free( field->value );
-	    if( tmp )
-	        field->value = strdup( tmp );
-	    else
-	        field->value = strdup( "NotFound" );
+	    err = mk_string( "Failed to retrieve data: ",
+	                     mysql_error( mysql ) );
+	    delete[] query;
+	    delete[] in;
+	    return 0;
 	}
-	field = get_field( result, "ReportedBy" );
-	if( field && field->value )
+	delete[] query;
+	MYSQL_RES *res = mysql_use_result( mysql );
+	if( !res )
 	{
-	    const char *tmp = find_field( profile_map, field->value );
-	    free( field->value );
-	    if( tmp )
-	        field->value = strdup( tmp );
-	    else
-	        field->value = strdup( "NotFound" );
+	    delete[] in;
+	    return 0;
 	}
-	field = get_field( result, "Product" );
-	if( field && field->value )
+	unsigned int f = mysql_num_fields( res );
+	MYSQL_FIELD *cols = mysql_fetch_fields( res );
+	unsigned int key;
+	for( key = 0; key < f && strcmp( cols[key].name, "bug_id" ); key++ );
+	MYSQL_ROW row;
+	while( ( row = mysql_fetch_row( res ) ) )
 	{
-	    const char *tmp = find_field( product_map, field->value );
-	    free( field->value );
-	    if( tmp )
-	        field->value = strdup( tmp );
-	    else
-	        field->value = strdup( "NotFound" );
+	    int i = 0;
+	    struct DTGStrList *id;
+	    for( id = ids; key < f && id; id = id->next, i++ )
+	        if( !results[i] && row[key] && !strcmp( id->value, row[key] ) )
+	            break;
+	    if( !id )
+	        continue; // read to the end all the same
+
+	    DTGField *fields = NULL;
+	    for( unsigned int c = 0; c < f; c++ )
+	        fields = append_DTGField( fields, new_DTGField(
+	                        field_label( cols[c].name ), row[c] ) );
+	    results[i] = fields;
+	    found++;
 	}
-	field = get_field( result, "Component" );
-	if( field && field->value )
+	int failed = mysql_errno( mysql );
+	mysql_free_result( res );
+	if( failed )
 	{
-	    const char *tmp = find_field( component_map, field->value );
-	    free( field->value );
-	    if( tmp )
-	        field->value = strdup( tmp );
-	    else
-	        field->value = strdup( "NotFound" );
+	    // Left for get_defect to report
+	    for( int i = 0; i < cnt; i++ )
+	        if( results[i] )
+	        {
+	            delete_DTGField( results[i] );
+	            results[i] = NULL;
+	        }
+	    delete[] in;
+	    return 0;
 	}
+	for( int i = 0; i < cnt; i++ )
+	    if( results[i] )
+	        map_names( results[i] );
+
+	// Descriptions, any failure is left to get_defect to report
+	char **descs = new char *[cnt];
+	for( int i = 0; i < cnt; i++ )
+	    descs[i] = results[i] ? cp_string( "" ) : NULL;
+	int *comments = new int[cnt];
+	memset( comments, 0, sizeof(int) * cnt );
+
+	// Commenters added since the profiles were read
+	profile_map->update( mysql );
+
+	query = mk_string( "SELECT bug_id, who, bug_when, thetext FROM ",
+			"longdescs WHERE bug_id IN ( ", in, " ) ",
+			"ORDER BY bug_id, bug_when" );
+	delete[] in;
+	failed = mysql_query( mysql, query );
 	delete[] query;
-	if( !result )
-	    err = cp_string( "Defect not found" );
+	res = failed ? NULL : mysql_use_result( mysql );
+	if( res )
+	{
+	    // Rows come grouped by bug
+	    int i = -1;
+	    char *cur = NULL;
+	    while( ( row = mysql_fetch_row( res ) ) )
+	    {
+	        if( !row[0] )
+	            continue;
+	        if( !cur || strcmp( cur, row[0] ) )
+	        {
+	            delete[] cur;
+	            cur = cp_string( row[0] );
+	            i = 0;
+	            struct DTGStrList *id;
+	            for( id = ids; id && strcmp( id->value, cur ); id = id->next )
+	                i++;
+	            if( !id )
+	                i = -1;
+	        }
+	        if( i < 0 || !descs[i] )
+	            continue;
+	        const char *who = profile_map->name( NULL, row[1] );
+	        add_comment( descs[i], comments[i], row[3], 
+				who ? who : row[1], row[2] );
+	    }
+	    delete[] cur;
+	    failed = mysql_errno( mysql );
+	    mysql_free_result( res );
+	}
 	else
+	    failed = 1;
+
+	for( int i = 0; i < cnt; i++ )
 	{
-	    char *desc = get_description( defect, err );
-	    if( desc )
-	        result = append_DTGField( result,
-				new_DTGField( "Description", desc ) );
-	    delete[] desc;
+	    if( !results[i] )
+	        continue;
+	    if( failed )
+	    {
+	        delete_DTGField( results[i] );
+	        results[i] = NULL;
+	        found--;
+	    }
+	    else
+	        results[i] = append_DTGField( results[i],
+				new_DTGField( "Description", descs[i] ) );
+	    delete[] descs[i];
 	}
-	return result;
+	delete[] descs;
+	delete[] comments;
+	return found;
+}
+
+/*
+	Runs a prepared statement, preparing it on first use, with every
+	parameter bound as a string. Returns the rows affected or -1 with
+	err set.
+*/
+
+long long
+MyDTS::run_stmt( MYSQL_STMT *&stmt, const char *query, 
+			const char **params, int cnt, char *&err )
+{
+	if( !stmt )
+	{
+	    stmt = mysql_stmt_init( mysql );
+	    if( !stmt || mysql_stmt_prepare( stmt, query, strlen( query ) ) )
+	    {
+	        err = mk_string( "Failed to prepare: \"", query, "\", ",
+	                stmt ? mysql_stmt_error( stmt ) : mysql_error( mysql ) );
+	        if( stmt )
+	            mysql_stmt_close( stmt );
+	        stmt = NULL;
+	        return -1;
+	    }
+	}
+
+	MYSQL_BIND *bind = new MYSQL_BIND[cnt];
+	unsigned long *lens = new unsigned long[cnt];
+	memset( bind, 0, sizeof(MYSQL_BIND) * cnt );
+	for( int i = 0; i < cnt; i++ )
+	{
+	    if( !params[i] )
+	    {
+	        bind[i].buffer_type = MYSQL_TYPE_NULL;
+	        continue;
+	    }
+	    lens[i] = strlen( params[i] );
+	    bind[i].buffer_type = MYSQL_TYPE_STRING;
+	    bind[i].buffer = (void *)params[i];
+	    bind[i].buffer_length = lens[i];
+	    bind[i].length = &lens[i];
+	}
+	long long rows = -1;
+	if( mysql_stmt_bind_param( stmt, bind ) || mysql_stmt_execute( stmt ) )
+	    err = mk_string( "Failed to run: \"", query, "\", ",
+	                     mysql_stmt_error( stmt ) );
+	else
+	    rows = mysql_stmt_affected_rows( stmt );
+	delete[] bind;
+	delete[] lens;
+	return rows;
+}
+
+void
+MyDTS::close_stmts()
+{
+	if( fix_stmt )
+	    mysql_stmt_close( fix_stmt );
+	if( stamp_stmt )
+	    mysql_stmt_close( stamp_stmt );
+	fix_stmt = stamp_stmt = NULL;
 }
 
 void
@@ -920,29 +1158,17 @@ MyDTS::append_fix( const char *defect, const char *fix, int stamped,
 	if( fix[0] == '\n' )
 	    fix = &fix[1];
 
-	char* qdefect = esc_field( defect );
-	char* qfix    = esc_field( fix    );
-
 	// append the fix changelist info to the comment field
-	char *query = mk_string(
-		"INSERT INTO longdescs ( bug_id, isprivate, who, bug_when, ",
-		"thetext, already_wrapped ) VALUES ( ", qdefect, ", ", 
-		private_fixes, ", ", use_profile, ", now(), \"",
-		qfix, "\", 1 )" );
-	if( !mysql_query( mysql, query ) )
-	{
-	    int cnt = mysql_affected_rows( mysql );
-	    if( cnt < 0 )
-	        err = mk_string( "INSERT failed:", query );
-	    else if( cnt == 0 )
-	        err = mk_string( "No rows inserted:", query );
-	    else if( cnt > 1 )
-	        err = mk_string( "Too many rows inserted:", query );
-	}
-	else
-	    err = mk_string( "Append fix failed: \"", query, "\", ",
-	                     mysql_error( mysql ) );
-	delete[] query;
+	const char *fix_params[] = { defect, private_fixes, use_profile, fix };
+	long long cnt = run_stmt( fix_stmt, 
+		"INSERT INTO longdescs ( bug_id, isprivate, who, bug_when, "
+		"thetext, already_wrapped ) VALUES ( ?, ?, ?, now(), ?, 1 )",
+		fix_params, 4, err );
+	if( cnt == 0 )
+	    err = mk_string( "Append fix: No rows inserted for bug ", defect );
+	else if( cnt > 1 )
+	    err = mk_string( "Append fix: Too many rows inserted for bug ",
+				defect );
 
 	// a fix might be applied independently of any other updates, so we
 	// have to update the bug's modified-date. if not, the fix's changelist
@@ -950,44 +1176,46 @@ MyDTS::append_fix( const char *defect, const char *fix, int stamped,
 	// not get sent back to the corresponding p4 job.
 	if( !stamped )
 	{
-	    query = mk_string( "UPDATE bugs SET delta_ts = now() WHERE ",
-	                          "bug_id = ", qdefect );
-
-	    if( !mysql_query( mysql, query ) )
-	    {
-	        int cnt = mysql_affected_rows( mysql );
-	        if( cnt < 0 )
-	            err = mk_string( "INSERT failed:", query );
-	        else if( cnt > 1 )
-	            err = mk_string( "Too many rows inserted:", query );
-	        // else if( cnt == 0 )
-	        //   It already is set to the current time, so OK
-	    }
-	    else
-	        err = mk_string( "Append fix failed: \"", query, "\", ",
-	                         mysql_error( mysql ) );
-	    delete[] query;
+	    const char *stamp_params[] = { defect };
+	    cnt = run_stmt( stamp_stmt, 
+		"UPDATE bugs SET delta_ts = now() WHERE bug_id = ?",
+		stamp_params, 1, err );
+	    if( cnt > 1 )
+	        err = mk_string( "Append fix: Too many rows updated for bug ",
+				defect );
+	    // cnt == 0: It already is set to the current time, so OK
 	}
-
-	free( qdefect );
-	free( qfix    );
 }
 	
 
-// passed to split_and_send() to write an entry in the activity table
+// passed to split_and_send() to queue an entry for the activity table
 
 void
 MyDTS::insert_activity(const char *now, const char* qvalue, const char* qdefect, 
-	const char* fieldid, char *&err)
+	const char* fieldid, struct DTGStrList *&rows)
 {
-	const char* q0 = mk_string("INSERT INTO bugs_activity ( bug_id, ",
-		"who, bug_when, fieldid, removed, ",
-		"added ) VALUES ( ", qdefect, ", ", use_profile, ", '", now, "', ");
+	char *row = mk_string("( ", qdefect, ", ", use_profile, ", '", now, "', ");
+	char *tmp = mk_string(row, fieldid, ", '', \"", qvalue, "\" )");
+	rows = append_DTGStrList(rows, tmp);
+	delete[] row;
+	delete[] tmp;
+}
 
+// write the queued activity entries of a defect with a single INSERT
 
-	const char* query = mk_string(q0, fieldid, ", '', \"", qvalue,
-		"\" )");
-	delete[] q0;
+void
+MyDTS::send_activity(struct DTGStrList *rows, char *&err)
+{
+	if (!rows)
+		return;
+
+	int want = 0;
+	for (struct DTGStrList *r = rows; r; r = r->next)
+		want++;
+	char *values = join_DTGStrList(rows, ", ");
+	char *query = mk_string("INSERT INTO bugs_activity ( bug_id, ",
+		"who, bug_when, fieldid, removed, added ) VALUES ", values);
+	free(values);
 
 	if (!mysql_query(mysql, query))
 	{
@@ -996,7 +1224,7 @@ MyDTS::insert_activity(const char *now, const char* qvalue, const char* qdefect,
 			err = mk_string("INSERT failed:", query);
 		else if (cnt == 0)
 			err = mk_string("No rows inserted:", query);
-		else if (cnt > 1)
+		else if (cnt > want)
 			err = mk_string("Too many rows inserted:", query);
 	}
 	else
@@ -1013,7 +1241,8 @@ MyDTS::insert_activity(const char *now, const char* qvalue, const char* qdefect,
 #define MAX_LEN 255
 
 void
-MyDTS::split_and_send(char* val, const char *qdefect, const char *fieldid, char *&err) 
+MyDTS::split_and_send(char* val, const char *qdefect, const char *fieldid,
+	const char *server_time, struct DTGStrList *&rows) 
 {
 	char buffer[MAX_LEN];
 	
@@ -1021,12 +1250,6 @@ MyDTS::split_and_send(char* val, const char *qdefect, const char *fieldid, char
 	char* buf_ptr = buffer;
 	int buf_available = MAX_LEN;
 
-    // get the server date-time, use it for all our sends 
-
-	char *server_time = get_server_date(0, err); 
-
-    // printf("server_time: %s\n",server_time);
-
 	// split value (by \n preferably) into segments
 	// write each segment to the database as a separate entry in the bugs_activity table.
 	// bugs_activity table has a 256 char limit on the "added" field.
@@ -1053,7 +1276,7 @@ MyDTS::split_and_send(char* val, const char *qdefect, const char *fieldid, char
 		if (seg_len > buf_available) {
 			// flush the buffer, to make MAX_LEN room
 			if (buf_available != MAX_LEN) {
-		        insert_activity(server_time, buffer, qdefect, fieldid, err);
+		        insert_activity(server_time, buffer, qdefect, fieldid, rows);
 
 				// reset to start of buffer
 				buf_ptr = buffer;
@@ -1065,7 +1288,7 @@ MyDTS::split_and_send(char* val, const char *qdefect, const char *fieldid, char
 		while (seg_len > buf_available) {
 			strncpy(buffer, esc_ptr, MAX_LEN - 1);
 			buffer[MAX_LEN - 1] = 0;
-		    insert_activity(server_time, buffer, qdefect, fieldid, err);
+		    insert_activity(server_time, buffer, qdefect, fieldid, rows);
 
 			// advance the pointer
 			buf_len = (int)strlen(buffer);
@@ -1109,10 +1332,8 @@ MyDTS::split_and_send(char* val, const char *qdefect, const char *fieldid, char
 	
 	// no more lines, send any buffered left-overs
 	if (buf_available != MAX_LEN) {
-		insert_activity(server_time, buffer, qdefect, fieldid, err);
+		insert_activity(server_time, buffer, qdefect, fieldid, rows);
 	}
- 	delete server_time;
-
 }
 
 
@@ -1122,6 +1343,9 @@ MyDTS::save_defect( const char *defect, struct DTGField *fields, char *&err )
 	if( !fields )
 	    return cp_string( defect );
 
+	// One transaction per defect, or a savepoint of the batch
+	int own_txn = !in_batch && !mysql_query( mysql, "START TRANSACTION" );
+
 	char* qdefect = esc_field( defect );
 
 	/* Build up SET clause list */
@@ -1129,7 +1353,7 @@ MyDTS::save_defect( const char *defect, struct DTGField *fields, char *&err )
 	int fix = 0;
 	for( struct DTGField *f = fields; f; f = f->next )
 	{
-	    const char *rn = find_value( field_map, f->name );
+	    const char *rn = field_column( f->name );
 	    if( !strcmp( f->name, "Fixes" ) )
 	    {
 	        fix = 1;
@@ -1177,31 +1401,92 @@ MyDTS::save_defect( const char *defect, struct DTGField *fields, char *&err )
 	    delete[] query;
 	}
 
-	// get the field id numbers so we can properly update bugs_activity.
-	const char *histquery = "SELECT id,description FROM fielddefs";
-	struct DTGField *histids = two_cols( histquery );
-	if( !histids )
-	    err = mk_string( "save_defect:  unable to run the histquery." );
+	// the field id numbers so we can properly update bugs_activity.
+	if( !field_ids->loaded() )
+	    err = mk_string( "save_defect:  unable to read the fielddefs." );
 	else
-	for( struct DTGField *f = fields; f; f = f->next )
 	{
-	    // fix history is handled in append_fix().
-	    if( strcmp( "Fixes", f->name) == 0 )
-	        continue;
-
-	    const char *fieldid = find_value( histids, f->name );
+	    // get the server date-time, use it for all our entries
+	    char *server_time = get_server_date( 0, err );
+	    struct DTGStrList *rows = NULL;
+	    for( struct DTGField *f = fields; server_time && f; f = f->next )
+	    {
+	        // fix history is handled in append_fix().
+	        if( strcmp( "Fixes", f->name) == 0 )
+	            continue;
 
-	    if( strcmp( fieldid, f->name ) == 0 )
-	        err = cp_string( "save_defect:  field id not found." );
+	        const char *fieldid = field_ids->id( NULL, f->name );
 
-	    split_and_send(f->value, qdefect, fieldid, err);
+	        if( !fieldid )
+	        {
+	            err = cp_string( "save_defect:  field id not found." );
+	            fieldid = f->name;
+	        }
 
+	        split_and_send( f->value, qdefect, fieldid, server_time, rows );
+	    }
+	    send_activity( rows, err );
+	    delete_DTGStrList( rows );
+	    delete[] server_time;
 	}
 
-	delete_DTGField( histids );
 	free( qdefect );
 
 	if( fix )
 	    append_fix( defect, find_field( fields, "Fixes" ), stamped, err );
+
+	if( own_txn )
+	{
+	    if( !err && mysql_query( mysql, "COMMIT" ) )
+	        err = mk_string( "save_defect commit failed: ", 
+				mysql_error( mysql ) );
+	    if( err )
+	        (void)mysql_query( mysql, "ROLLBACK" );
+	}
 	return cp_string( defect );
 }
+
+/*
+	Saves from MyDTGProj::save_defects() run in one transaction, each
+	defect under a savepoint so a failed one can be undone alone.
+*/
+
+int
+MyDTS::begin_batch( char *&err )
+{
+	if( !connected( err ) )
+	    return 0;
+	if( mysql_query( mysql, "START TRANSACTION" ) )
+	{
+	    err = mk_string( "begin_batch failed: ", mysql_error( mysql ) );
+	    return 0;
+	}
+	return in_batch = 1;
+}
+
+void
+MyDTS::mark_batch( char *&err )
+{
+	if( mysql_query( mysql, "SAVEPOINT dtg_save" ) )
+	    err = mk_string( "mark_batch failed: ", mysql_error( mysql ) );
+}
+
+void
+MyDTS::undo_batch( char *&err )
+{
+	if( mysql_query( mysql, "ROLLBACK TO SAVEPOINT dtg_save" ) )
+	    err = mk_string( "undo_batch failed: ", mysql_error( mysql ) );
+}
+
+int
+MyDTS::end_batch( char *&err )
+{
+	in_batch = 0;
+	if( mysql_query( mysql, "COMMIT" ) )
+	{
+	    err = mk_string( "end_batch failed: ", mysql_error( mysql ) );
+	    (void)mysql_query( mysql, "ROLLBACK" );
+	    return 0;
+	}
+	return 1;
+}
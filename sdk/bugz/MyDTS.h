@@ -27,6 +27,7 @@
 
 struct DTGStrList;
 struct DTGDate;
+class NameMap;
 #ifdef _WIN32
 #include <my_global.h>
 #endif
@@ -51,17 +52,31 @@ class MyDTS {
 	    struct DTGStrList *get_options( const char *table, char *&err );
 	    struct DTGField *single_row( const char *query, char *&err );
 	    struct DTGStrList *single_col( const char *query, char *&err );
-	    struct DTGField *two_cols( const char *query );
 	    char *get_description( const char *bugid, char *&err );
+	    void load_maps();
+	    void map_names( struct DTGField *result );
+	    const char *field_label( const char *column );
+	    const char *user_name( const char *userid );
 	    void append_fix( const char *defect, const char *fix, 
 				int stamped, char *&err );
 
+	    // Statements of the save path, prepared once per connection
+	    MYSQL_STMT *fix_stmt;
+	    MYSQL_STMT *stamp_stmt;
+	    long long run_stmt( MYSQL_STMT *&stmt, const char *query,
+				const char **params, int cnt, char *&err );
+	    void close_stmts();
+	    int in_batch;
+
 	    MYSQL *mysql;
 	    char *use_profile;
-	    struct DTGField *field_map;
-	    struct DTGField *profile_map;
-	    struct DTGField *product_map;
-	    struct DTGField *component_map;
+
+	    // Lookup tables, read once per connection
+	    NameMap *field_map;		// fielddefs name <-> description
+	    NameMap *field_ids;		// fielddefs id <-> description
+	    NameMap *profile_map;	// userid <-> login_name
+	    NameMap *product_map;
+	    NameMap *component_map;
 
 	public:
 	    MyDTS( const char *server, 
@@ -73,6 +88,9 @@ class MyDTS {
 		char *&err);
 	    virtual ~MyDTS();
 
+	    static void thread_begin();
+	    static void thread_end();
+
 	    int is_valid() { return valid; };
 	    int valid_project( const char *proj );
 	    int utf8_ok() { return utf8; };
@@ -89,17 +107,24 @@ class MyDTS {
 	    struct DTGStrList *list_jobs( int max_rows, 
 		struct DTGDate *since, const char *mod_date_field,
 		const char *exclude_user, const char *mod_by_field,
-		const char *segment_filters, char *&err );
+		const char *segment_filters, char *&err, 
+		const char *after = NULL );
 	    struct DTGField *get_defect( const char *defect, char *&err );
+	    int get_defects( struct DTGStrList *ids, struct DTGField **results,
+							char *&err );
 
-	    void insert_activity(const char *now, const char *qvalue, const char *qdefect, const char *filedid, char *&err);
-	    void split_and_send(char *val, const char *defect, const char *filedid, char *&err);
+	    void insert_activity(const char *now, const char *qvalue, const char *qdefect, const char *filedid, struct DTGStrList *&rows);
+	    void send_activity(struct DTGStrList *rows, char *&err);
+	    void split_and_send(char *val, const char *defect, const char *filedid, const char *now, struct DTGStrList *&rows);
 	    char *save_defect( const char *defect,
 				struct DTGField *fields, char *&err );
+	    int begin_batch( char *&err );
+	    void mark_batch( char *&err );
+	    void undo_batch( char *&err );
+	    int end_batch( char *&err );
 	    char* esc_field( const char* fld );
-	    struct DTGField *field_names();
-	    const char *find_value( struct DTGField *fields, const char *id );
-	    struct DTGField *product_names();
+	    const char *field_column( const char *label );
+	    const char *product_id( const char *name );
 	    char *component_name( const char * comp_name, const char *prod_id );
 };
 
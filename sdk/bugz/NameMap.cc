@@ -0,0 +1,209 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "NameMap.h"
+#include "dtg-str.h"
+
+NameMap::NameMap( const char *table, const char *id, const char *name,
+			int numeric_id )
+{
+	size = 64;
+	count = 0;
+	read_ok = 0;
+	by_id = new Entry *[size];
+	by_name = new Entry *[size];
+	memset( by_id, 0, sizeof(Entry *) * size );
+	memset( by_name, 0, sizeof(Entry *) * size );
+	query = mk_string( "SELECT ", id, ", ", name, " FROM ", table );
+	id_col = numeric_id ? cp_string( id ) : NULL;
+	max_id = 0;
+}
+
+NameMap::~NameMap()
+{
+	for( int i = 0; i < size; i++ )
+	    while( by_id[i] )
+	    {
+	        Entry *e = by_id[i];
+	        by_id[i] = e->next_id;
+	        delete[] e->id;
+	        delete[] e->name;
+	        delete e;
+	    }
+	delete[] by_id;
+	delete[] by_name;
+	delete[] query;
+	if( id_col )
+	    delete[] id_col;
+}
+
+unsigned int NameMap::hash( const char *key )
+{
+	unsigned int h = 2166136261u;
+	for( ; *key; key++ )
+	    h = ( h ^ (unsigned char)*key ) * 16777619u;
+	return h;
+}
+
+void NameMap::grow()
+{
+	int new_size = size * 2;
+	Entry **ids = new Entry *[new_size];
+	Entry **names = new Entry *[new_size];
+	memset( ids, 0, sizeof(Entry *) * new_size );
+	memset( names, 0, sizeof(Entry *) * new_size );
+	for( int i = 0; i < size; i++ )
+	    while( by_id[i] )
+	    {
+	        Entry *e = by_id[i];
+	        by_id[i] = e->next_id;
+	        unsigned int b = hash( e->id ) % new_size;
+	        e->next_id = ids[b];
+	        ids[b] = e;
+	        if( !e->by_name )
+	            continue;
+	        b = hash( e->name ) % new_size;
+	        e->next_name = names[b];
+	        names[b] = e;
+	    }
+	delete[] by_id;
+	delete[] by_name;
+	by_id = ids;
+	by_name = names;
+	size = new_size;
+}
+
+NameMap::Entry *NameMap::find_id( const char *id )
+{
+	Entry *e = by_id[hash( id ) % size];
+	while( e && strcmp( e->id, id ) )
+	    e = e->next_id;
+	return e;
+}
+
+NameMap::Entry *NameMap::find_name( const char *name )
+{
+	Entry *e = by_name[hash( name ) % size];
+	while( e && strcmp( e->name, name ) )
+	    e = e->next_name;
+	return e;
+}
+
+/* The first id read for a name is the one found for it */
+
+void NameMap::add( const char *id, const char *name )
+{
+	if( !id || !name || find_id( id ) )
+	    return;
+	if( count >= size )
+	    grow();
+	Entry *e = new Entry;
+	e->id = cp_string( id );
+	e->name = cp_string( name );
+	unsigned int b = hash( id ) % size;
+	e->next_id = by_id[b];
+	by_id[b] = e;
+	e->next_name = NULL;
+	e->by_name = !find_name( name );
+	if( e->by_name )
+	{
+	    b = hash( name ) % size;
+	    e->next_name = by_name[b];
+	    by_name[b] = e;
+	}
+	count++;
+	if( id_col && atol( id ) > max_id )
+	    max_id = atol( id );
+}
+
+int NameMap::read( MYSQL *mysql, const char *where )
+{
+	char *q = mk_string( query, where );
+	int failed = mysql_query( mysql, q );
+	delete[] q;
+	if( failed )
+	    return -1;
+	MYSQL_RES *res = mysql_store_result( mysql );
+	if( !res )
+	    return -1;
+	int cnt = 0;
+	MYSQL_ROW row;
+	while( ( row = mysql_fetch_row( res ) ) )
+	    if( row[0] && row[1] )
+	    {
+	        add( row[0], row[1] );
+	        cnt++;
+	    }
+	mysql_free_result( res );
+	return cnt;
+}
+
+/* Returns 0 when the table could not be read */
+
+int NameMap::load( MYSQL *mysql )
+{
+	if( read( mysql, "" ) < 0 )
+	    return 0;
+	return read_ok = 1;
+}
+
+/* Reads the rows with ids above those already held */
+
+int NameMap::read_new( MYSQL *mysql )
+{
+	if( !id_col || !mysql )
+	    return 0;
+	char since[32];
+	sprintf( since, "%ld", max_id );
+	char *where = mk_string( " WHERE ", id_col, " > ", since );
+	int cnt = read( mysql, where );
+	delete[] where;
+	return cnt;
+}
+
+const char *NameMap::name( MYSQL *mysql, const char *id )
+{
+	if( !id )
+	    return NULL;
+	Entry *e = find_id( id );
+	if( e )
+	    return e->name;
+
+	// Only a row added since can have a larger id
+	if( atol( id ) <= max_id || read_new( mysql ) <= 0 )
+	    return NULL;
+	e = find_id( id );
+	return e ? e->name : NULL;
+}
+
+const char *NameMap::id( MYSQL *mysql, const char *name )
+{
+	if( !name )
+	    return NULL;
+	Entry *e = find_name( name );
+	if( e )
+	    return e->id;
+
+	if( read_new( mysql ) <= 0 )
+	    return NULL;
+	e = find_name( name );
+	return e ? e->id : NULL;
+}
@@ -0,0 +1,76 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NAMEMAP_HEADER
+#define NAMEMAP_HEADER
+
+#ifdef _WIN32
+#include <my_global.h>
+#endif
+#include <mysql.h>
+
+/*
+	An id/name table of the Bugzilla database (profiles, products, ...)
+	read once per connection and hashed both ways. With a numeric id
+	column a lookup which misses reads the rows added since the table
+	was loaded, so new users and products are found without reloading.
+*/
+
+class NameMap {
+    protected:
+	struct Entry {
+	    char *id;
+	    char *name;
+	    Entry *next_id;	// hash chains
+	    Entry *next_name;
+	    int by_name;	// first id read for its name
+	};
+
+	Entry **by_id;
+	Entry **by_name;
+	int size;
+	int count;
+	int read_ok;
+
+	char *query;	// SELECT id, name FROM table
+	char *id_col;	// NULL: no incremental reads
+	long max_id;
+
+	unsigned int hash( const char *key );
+	void grow();
+	Entry *find_id( const char *id );
+	Entry *find_name( const char *name );
+	int read( MYSQL *mysql, const char *where );
+	int read_new( MYSQL *mysql );
+
+    public:
+	NameMap( const char *table, const char *id, const char *name,
+		int numeric_id = 1 );
+	~NameMap();
+
+	int load( MYSQL *mysql );
+	int loaded() { return read_ok; };
+	void add( const char *id, const char *name );
+	int update( MYSQL *mysql ) { return read_new( mysql ); };
+
+	// NULL when not found, even after reading new rows
+	const char *name( MYSQL *mysql, const char *id );
+	const char *id( MYSQL *mysql, const char *name );
+};
+
+#endif
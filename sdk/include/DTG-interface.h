@@ -130,6 +130,16 @@
  *    Tells the integration module that the system is done with the specified
  *    server.
  *
+ * void dt_thread_begin();
+ * void dt_thread_end();
+ *
+ *    Optional. The replication engine's worker threads use connections
+ *    made on another thread. Each calls dt_thread_begin before its first
+ *    call to the module and dt_thread_end before it exits, so a module
+ *    whose client library keeps per-thread state (e.g. MySQL) can set it
+ *    up and release it. Every worker has called dt_thread_begin before
+ *    the engine lists the defects they are to process.
+ *
  * const char *dt_get_server_version( void *dtID, struct DTGError *error );
  *
  *    Returns the version number of the server to which the dtID refers
@@ -201,6 +211,26 @@
  *    the results set. If max_rows is < 1, then all changed defects are to 
  *    be returned.
  *
+ * void *proj_open_changed_defects( void *projID, 
+ *                                  int page_size,
+ *                                  struct DTGDate *since, 
+ *                                  const char *mod_date_field,
+ *                                  const char *mod_by_field,
+ *                                  const char *exclude_mod_user,
+ *                                  struct DTGError *error );
+ * struct DTGStrList *cursor_next_defects( void *cursorID, 
+ *                                         struct DTGError *error );
+ * void cursor_free( void *cursorID, struct DTGError *error );
+ *
+ *    This is an optional interface. Returns an opaque pointer (cursorID) 
+ *    over the same defects proj_list_changed_defects would return with
+ *    max_rows of 0. Each cursor_next_defects call returns the next list of
+ *    at most page_size defects, NULL once all have been returned. Defects
+ *    may be saved between calls; a defect may then be returned twice but
+ *    none may be skipped. cursor_free releases the cursor, which can be 
+ *    before the last page has been read. When not defined, the list from
+ *    proj_list_changed_defects is returned a page at a time.
+ *
  * void proj_referenced_fields( void *projID, struct DTGStrList *fields )
  *
  *    This optional interface provides a list of all of the fields which
@@ -227,6 +257,18 @@
  *    Returns an opaque pointer (defectID) to a specific defect within the 
  *    specified project as identified by the defect argument.
  *
+ * int proj_get_defects( void *projID, struct DTGStrList *defects,
+ *                       void **defectIDs, struct DTGError *error );
+ *
+ *    This is an optional interface. Loads several defects with as few
+ *    requests to the server as possible. defectIDs is allocated by the
+ *    caller with one entry per item in defects; the plug-in sets each
+ *    entry to the defectID of that defect, as proj_get_defect would
+ *    return it, or to NULL when it was not loaded. Returns the number of
+ *    defects loaded. Defects left NULL are loaded using proj_get_defect,
+ *    which reports why they could not be retrieved, so the error should
+ *    only be set when the server could not be reached at all.
+ *
  * void *proj_new_defect( void *projID, struct DTGError *error );
  *
  *    Returns an opaque pointer (defectID) to a newly created defect within the
@@ -260,6 +302,17 @@
  *    identifier. The return value is mainly intended for returning the
  *    generated identity for newly created defects.
  *
+ * int proj_save_defects( void *projID, int count, void **defectIDs,
+ *                        char **ids, struct DTGError *errors );
+ *
+ *    This is an optional interface. Saves count defects of the project
+ *    together, as a single transaction where the server allows it. ids
+ *    and errors are allocated by the caller with count entries each,
+ *    the errors cleared. For each defect the plug-in sets ids[i] to what
+ *    defect_save would have returned and errors[i] as defect_save would
+ *    have set its error. A defect which fails to save must not keep the
+ *    others from being saved. Returns the number of defects saved.
+ *
  *
  * Perforce Specific Interface Functions and Types
  * The following functions and types are specific to the Perforce plugin and
@@ -278,6 +331,28 @@
  * 					const char *fixid,
  * 					struct DTGError *error );
  *
+ * int proj_describe_fixes( void *projID, struct DTGStrList *fixids,
+ * 			struct DTGFixDesc **fixes, struct DTGError *error );
+ *
+ *    Optional. Describes several fixes with as few requests to the server
+ *    as possible. fixes is allocated by the caller with one entry per
+ *    item in fixids; the plug-in sets each entry to the description
+ *    proj_describe_fix would return or to NULL when it was not described.
+ *    Returns the number of fixes described. Fixes left NULL are described
+ *    using proj_describe_fix, which reports why, so the error should only
+ *    be set when the server could not be reached at all.
+ *
+ * struct DTGField *proj_find_defect_values( void *projID, 
+ * 					const char *qualification,
+ * 					const char *field,
+ * 					struct DTGError *error );
+ *
+ *    Optional. Returns one DTGField per defect matching the qualification,
+ *    the name being the defect id and the value that of the named field,
+ *    using a single query. Used to rebuild the replication engine's
+ *    DTS issue to job index. When not defined, proj_find_defects and
+ *    proj_get_defect are used instead.
+ *
  */
 
 struct DTGError {
@@ -44,6 +44,8 @@ typedef void *(dt_connect_ftn)( const char *server,
 typedef int (dt_accept_utf8_ftn)( void *dtID, struct DTGError *error );
 typedef int (dt_server_offline_ftn)( void *dtID, struct DTGError *error );
 typedef void (dt_free_ftn)( void *dtID, struct DTGError *error );
+typedef void (dt_thread_begin_ftn)();
+typedef void (dt_thread_end_ftn)();
 typedef struct DTGStrList *(dt_list_projects_ftn)( void *dtID, 
                                                   struct DTGError *error );
 typedef void *(dt_get_project_ftn)( void *dtID, const char *project, 
@@ -58,6 +60,10 @@ typedef struct DTGStrList *(proj_list_fixes_ftn)( void *projID,
 typedef struct DTGFixDesc *(proj_describe_fix_ftn)( void *projID, 
 						const char *fixid,
                                                 struct DTGError *error );
+typedef int (proj_describe_fixes_ftn)( void *projID, 
+						struct DTGStrList *fixids,
+						struct DTGFixDesc **fixes,
+                                                struct DTGError *error );
 typedef struct DTGStrList *(proj_list_changed_defects_ftn)( void *projID, 
 						int max_rows,
 						struct DTGDate *since, 
@@ -65,15 +71,33 @@ typedef struct DTGStrList *(proj_list_changed_defects_ftn)( void *projID,
 						const char *mod_by_field,
 						const char *exclude_mod_user,
 						struct DTGError *error );
+typedef void *(proj_open_changed_defects_ftn)( void *projID, 
+						int page_size,
+						struct DTGDate *since, 
+						const char *mod_date_field,
+						const char *mod_by_field,
+						const char *exclude_mod_user,
+						struct DTGError *error );
+typedef struct DTGStrList *(cursor_next_defects_ftn)( void *cursorID, 
+						struct DTGError *error );
+typedef void (cursor_free_ftn)( void *cursorID, struct DTGError *error );
 typedef struct DTGStrList *(proj_find_defects_ftn)( void *projID, 
 						int max_rows,
 						const char *qualification,
 						struct DTGError *error );
+typedef struct DTGField *(proj_find_defect_values_ftn)( void *projID, 
+						const char *qualification,
+						const char *field,
+						struct DTGError *error );
 typedef void (proj_referenced_fields_ftn)( void *projID, 
 						struct DTGStrList *fields );
 typedef void (proj_segment_filters_ftn)( void *projID, struct DTGFieldDesc *filters );
 typedef void *(proj_get_defect_ftn)( void *projID, const char *defect, 
                                      struct DTGError *error );
+typedef int (proj_get_defects_ftn)( void *projID, 
+						struct DTGStrList *defects,
+						void **defectIDs,
+						struct DTGError *error );
 typedef void *(proj_new_defect_ftn)( void *projID, struct DTGError *error );
 typedef void (defect_free_ftn)( void *defectID, struct DTGError *error );
 
@@ -85,6 +109,10 @@ typedef void (defect_set_field_ftn)( void *defectID,
                                      const char *name, const char *value, 
                                      struct DTGError *error );
 typedef char *(defect_save_ftn)( void *defectID, struct DTGError *error );
+typedef int (proj_save_defects_ftn)( void *projID, int count, 
+						void **defectIDs,
+						char **ids,
+						struct DTGError *errors );
 
 typedef void (free_char_ftn)( char *obj );
 typedef void (free_dtg_error_ftn)( struct DTGError *obj );
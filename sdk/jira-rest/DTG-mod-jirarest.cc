@@ -398,6 +398,41 @@ void *proj_get_defect( void *projID, const char *defect, struct DTGError *error
 	return mydtproj->get_defect( defect, error );
 }
 
+DL_EXPORT_FTN
+int proj_get_defects( void *projID, struct DTGStrList *defects, 
+			void **defectIDs, struct DTGError *error )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "proj_get_defects()\n" );
+#endif
+	MyDTGProj *mydtproj = MyDTGProj::convert( projID );
+	if( !mydtproj )
+	{
+	    set_DTGError( error, "proj_get_defects: Unknown projID" );
+	    return 0;
+	}
+
+	return mydtproj->get_defects( defects, defectIDs, error );
+}
+
+DL_EXPORT_FTN
+int proj_save_defects( void *projID, int count, void **defectIDs,
+			char **ids, struct DTGError *errors )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "proj_save_defects()\n" );
+#endif
+	MyDTGProj *mydtproj = MyDTGProj::convert( projID );
+	if( !mydtproj )
+	{
+	    for( int i = 0; i < count; i++ )
+	        set_DTGError( &errors[i], "proj_save_defects: Unknown projID" );
+	    return 0;
+	}
+
+	return mydtproj->save_defects( count, defectIDs, ids, errors );
+}
+
 DL_EXPORT_FTN
 void *proj_new_defect( void *projID, struct DTGError *error )
 {
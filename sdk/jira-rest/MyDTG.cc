@@ -215,6 +215,17 @@ struct DTGAttribute *MyDTG::list_attrs()
 	        "100",
 	       0 ) );
 
+	in_field = append_DTGAttribute( in_field, new_DTGAttribute(
+	       "pipeline_window",
+	       "Requests in flight",
+	       "The number of issue saves sent to the JIRA plug-in's Java "
+	       "process before waiting for their results, which it then "
+	       "processes concurrently. Use 1 to send one request at a time. "
+	       "Older Java processes always handle one at a time. "
+	       "Default is 8.",
+	        "8",
+	       0 ) );
+
 	return in_field;
 }
 
@@ -281,6 +292,12 @@ char *MyDTG::validate_attr( const struct DTGField *attr )
 	            return NULL;
 	    else
 	        return strdup( "Batch size for issues: Must be a positive integer." );
+	if( !strcmp( attr->name, "pipeline_window" ) )
+	    if( attr->value && is_number( attr->value ) &&
+		atoi( attr->value ) >= 1 && atoi( attr->value ) <= 32 )
+	        return NULL;
+	    else
+	        return strdup( "Requests in flight: Must be between 1 and 32." );
 	if( !strcmp( attr->name, "wait_time" ) )
 	    if( attr->value && is_number( attr->value ) )
 	        if( atoi( attr->value ) == 0 )
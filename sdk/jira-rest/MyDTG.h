@@ -103,6 +103,10 @@ class MyDTGProj {
 						const char *exclude_user,
 	                                        struct DTGError *error );
 	MyDTGDefect *get_defect( const char *defect, struct DTGError *error );
+	int get_defects( struct DTGStrList *defects, void **results,
+					struct DTGError *error );
+	int save_defects( int cnt, void **defects, char **ids,
+					struct DTGError *errors );
 	MyDTGDefect *new_defect( struct DTGError *error );
 	
 	void referenced_fields( struct DTGStrList *fields );
@@ -124,6 +128,10 @@ class MyDTGDefect {
 			const char *defect, 
 			struct DTGStrList *ref_fields, 
 			struct DTGError *error );
+	MyDTGDefect( MyDTGProj *proj, 
+			const char *defect, 
+			struct DTGField *fields, 
+			struct DTGError *error );
 	~MyDTGDefect();
 
 	static MyDTGDefect *convert( void *obj )
@@ -67,6 +67,29 @@ MyDTGDefect::MyDTGDefect( MyDTGProj *proj,
 	clear_DTGError( error );
 }
 
+/* Takes ownership of fields already fetched by MyDTS::get_defects */
+
+MyDTGDefect::MyDTGDefect( MyDTGProj *proj,
+	                const char *in_defect,
+	                struct DTGField *in_fields,
+	                struct DTGError *error  )
+{
+	magic = MyDTGMagic;
+	in_proj = proj;
+	fields = in_fields;
+	changes = NULL;
+	defect = mk_string( in_defect );
+	dirty = 0;
+	testing = 0;
+	if( !proj || !defect || !fields )
+	{
+	    set_DTGError( error,
+			"MyDTGDefect::MyDTGDefect: Undefined arguments");
+	    return;
+	}
+	clear_DTGError( error );
+}
+
 MyDTGDefect::~MyDTGDefect()
 {
 	if( fields )
@@ -146,6 +146,112 @@ MyDTGDefect *MyDTGProj::get_defect( const char *defect, struct DTGError *error )
 	return item;
 }
 
+int MyDTGProj::get_defects( struct DTGStrList *defects, void **results,
+					struct DTGError *error )
+{
+	int cnt = 0;
+	for( struct DTGStrList *d = defects; d; d = d->next )
+	    results[cnt++] = NULL;
+	clear_DTGError( error );
+	if( testing || !cnt )
+	    return 0;
+
+	struct DTGField **rows = new struct DTGField *[cnt];
+	memset( rows, 0, sizeof(struct DTGField *) * cnt );
+	char *err = NULL;
+	in_dt->dts->get_defects( defects, ref_fields, rows, err );
+	if( err )
+	{
+	    set_DTGError( error, err );
+	    error->can_continue = in_dt->dts->is_valid();
+	    delete[] err;
+	    for( int i = 0; i < cnt; i++ )
+	        delete_DTGField( rows[i] );
+	    delete[] rows;
+	    return 0;
+	}
+
+	int loaded = 0;
+	struct DTGStrList *d = defects;
+	for( int i = 0; i < cnt; i++, d = d->next )
+	    if( rows[i] )
+	    {
+	        results[i] = new MyDTGDefect( this, d->value, rows[i], error );
+	        loaded++;
+	    }
+	clear_DTGError( error );
+	delete[] rows;
+	return loaded;
+}
+
+/*
+	Saves the dirty defects with their requests pipelined to the Java
+	proxy. Each defect ends up as if saved by MyDTGDefect::save.
+*/
+
+int MyDTGProj::save_defects( int cnt, void **defects, char **ids,
+					struct DTGError *errors )
+{
+	MyDTGDefect **items = new MyDTGDefect *[cnt];
+	const char **names = new const char *[cnt];
+	struct DTGField **changes = new struct DTGField *[cnt];
+	int *index = new int[cnt];
+	int dirty = 0;
+	int saved = 0;
+	int i;
+	for( i = 0; i < cnt; i++ )
+	{
+	    ids[i] = NULL;
+	    items[i] = MyDTGDefect::convert( defects[i] );
+	    if( !items[i] )
+	        set_DTGError( &errors[i], "proj_save_defects: Unknown defectID" );
+	    else if( testing || !items[i]->dirty || !items[i]->fields )
+	    {
+	        ids[i] = items[i]->save( &errors[i] );
+	        if( !errors[i].message )
+	            saved++;
+	    }
+	    else
+	    {
+	        names[dirty] = items[i]->defect;
+	        changes[dirty] = items[i]->changes;
+	        index[dirty++] = i;
+	    }
+	}
+
+	if( dirty )
+	{
+	    char **new_names = new char *[dirty];
+	    char **errs = new char *[dirty];
+	    MyDTS *dts = in_dt->dts;
+	    dts->save_defects( dirty, names, changes, new_names, errs );
+	    for( int j = 0; j < dirty; j++ )
+	    {
+	        MyDTGDefect *item = items[index[j]];
+	        if( errs[j] )
+	        {
+	            set_DTGError( &errors[index[j]], errs[j] );
+	            errors[index[j]].can_continue = dts->is_valid();
+	            delete[] errs[j];
+	            continue;
+	        }
+	        delete[] item->defect;
+	        item->defect = new_names[j];
+	        item->dirty = 0;
+	        ids[index[j]] = strdup( item->defect );
+	        saved++;
+	    }
+	    delete[] new_names;
+	    delete[] errs;
+	}
+
+	delete[] items;
+	delete[] names;
+	delete[] changes;
+	delete[] index;
+	return saved;
+}
+
 MyDTGDefect *MyDTGProj::new_defect( struct DTGError *error )
 {
 	if( !in_dt->allow_creation )
@@ -29,6 +29,8 @@
 
 #include <ctype.h>
 #include <sys/stat.h>
+#include <mutex>
+#include <set>
 #include "MyDTS.h"
 extern "C" {
 #include "dtg-utils.h"
@@ -56,6 +58,67 @@ const char *find_field( struct DTGField *fields, const char *id )
 	return fields ? fields->value : id;
 }
 
+// Milliseconds to wait for a new Java proxy, and for a PING answer
+static const int BRIDGE_START = 60000;
+static const int BRIDGE_PING = 5000;
+
+/*
+	Ports of the bridges a connection in this process holds. A bridge
+	serves one client at a time, so these are known to be busy without
+	waiting on a PING, and the connections of the replication workers
+	each go straight to a bridge of their own.
+*/
+
+static std::mutex held_lock;
+static std::set<int> held_ports;
+
+static int claim_port( int port )
+{
+	std::lock_guard<std::mutex> lock( held_lock );
+	return held_ports.insert( port ).second;
+}
+
+static void release_port( int port )
+{
+	std::lock_guard<std::mutex> lock( held_lock );
+	held_ports.erase( port );
+}
+
+static void pause_ms( int ms )
+{
+#ifdef OS_NT
+	Sleep( ms );
+#else
+	usleep( ms * 1000 );
+#endif
+}
+
+/* The properties file a Java proxy on port is started with */
+
+static char *bridge_properties( const char *port, const char *config,
+				int defect_batch, const char *server )
+{
+	char num[32];
+	sprintf( num, "%d", defect_batch );
+	return mk_string( "tcp_port=", port, "\nconfig_file=config/", config,
+			"\ndefect_batch=", num, "\n",
+			server ? "server=" : NULL, server, server ? "\n" : NULL );
+}
+
+static int same_contents( const char *path, const char *text )
+{
+	FILE *file = fopen( path, "r" );
+	if( !file )
+	    return 0;
+	size_t len = strlen( text );
+	char *buf = new char[len + 2];
+	size_t got = fread( buf, 1, len + 1, file );
+	fclose( file );
+	int same = got == len && !memcmp( buf, text, len );
+	delete[] buf;
+	return same;
+}
+
 MyDTS::MyDTS( const char *server,
 		const char *user,
 		const char *pass,
@@ -69,11 +132,14 @@ MyDTS::MyDTS( const char *server,
 	projID = NULL;
 	defectName = NULL;
 	sent_ref_fields = 0;
+	bulk_ok = 1;
 	tcp = NULL;
 	tcp_port = NULL;
 	tcp_server = NULL;
+	bridge_port = 0;
 	java_opts = NULL;
 	defect_batch = 0;
+	pipeline_window = 1;
 	if( server )
 	    my_server = cp_string( server );
 	else
@@ -118,6 +184,15 @@ MyDTS::MyDTS( const char *server,
 	else
 	    defect_batch = 100;
 
+	// Requests kept in flight to the Java proxy
+	f = get_field( (DTGField*)attrs, "pipeline_window" );
+	if( f )
+	    pipeline_window = atoi( f->value );
+	else
+	    pipeline_window = 8;
+	if( pipeline_window < 1 )
+	    pipeline_window = 1;
+
 	// TCP port
 	f = get_field( (DTGField*)attrs, "tcp_port" );
 	if( f )
@@ -134,86 +209,112 @@ MyDTS::MyDTS( const char *server,
 
 	f = NULL;
 
+	// Reuse a bridge already running for this configuration, or start
+	// one on the first port without a bridge. Ports held in this
+	// process are skipped.
 	int port_num = atoi( tcp_port ) - 1;
 	char port_string[32];
+	sprintf( port_string, "%d", port_num + 1 );
 
+	tcp = new TcpXML();
 	char *jira_properties = NULL;
+	char *properties = NULL;
+	int reused = 0;
 	struct stat buf;
 	do {
 	    port_num++;
+	    if( !claim_port( port_num ) )
+	        continue;
+	    bridge_port = port_num;
 	    sprintf( port_string, "%d", port_num );
 	    delete[] jira_properties;
+	    delete[] properties;
 	    jira_properties = mk_string( "jira/jira-rest-", port_string, ".properties" );
-	} while( !stat( jira_properties, &buf ) && port_num < 65535 );
-
-	// writes Jira information to properties file
-
-	FILE *file = fopen( jira_properties, "w+" );
-	if( !file )
-	{
-	    err = mk_string( "Unable to create Java properties file" );
-	    return;
-	}
+	    properties = bridge_properties( port_string, my_config, 
+					defect_batch, my_server );
+	    if( stat( jira_properties, &buf ) )
+	        break;
+	    if( same_contents( jira_properties, properties ) )
+	    {
+	        char *server = mk_string( "localhost:", port_string );
+	        reused = tcp->attach( server, BRIDGE_PING );
+	        delete[] server;
+	    }
+	    if( !reused )
+	    {
+	        release_port( port_num );
+	        bridge_port = 0;
+	    }
+	} while( !reused && port_num < 65535 );
 
 	delete[] tcp_port;
 	tcp_port = cp_string( port_string );
 	tcp_server = mk_string( "localhost:", port_string );
 
-	fprintf( file, "tcp_port=%s\n", tcp_port );
-	fprintf( file, "config_file=config/%s\n", my_config );
-	fprintf( file, "defect_batch=%d\n", defect_batch );
-	if( my_server )
+	if( !reused )
 	{
-		fprintf( file, "server=%s\n", my_server);
-	}
-	fclose( file );
+	    // writes Jira information to properties file
 
-	char *java_options = mk_string( java_opts,
+	    FILE *file = fopen( jira_properties, "w+" );
+	    if( !file )
+	    {
+	        err = mk_string( "Unable to create Java properties file" );
+	        delete[] jira_properties;
+	        delete[] properties;
+	        return;
+	    }
+	    fputs( properties, file );
+	    fclose( file );
+
+	    char *java_options = mk_string( java_opts,
 	                                " -Djava.awt.headless=true",
 	                                " -Djava.util.logging.config.file=jira/logging-rest.properties",
 	                                " -Djavadts.TCP_PORT=", port_string );
 	
-	char *java_command = mk_string( "java ", java_options, " -jar jira/jira-rest.jar" );
+	    char *java_command = mk_string( "java ", java_options, " -jar jira/jira-rest.jar" );
 	
-	if( java_options )
-	    delete[] java_options;
+	    if( java_options )
+	        delete[] java_options;
 
-	char *command = NULL;
+	    char *command = NULL;
 
 #ifdef OS_NT
-	command = mk_string( "cmd.exe /c START /B ", java_command, " ", jira_properties);
+	    command = mk_string( "cmd.exe /c START /B ", java_command, " ", jira_properties);
 #else
-	command = mk_string( java_command, " ", jira_properties, " &");
+	    command = mk_string( java_command, " ", jira_properties, " &");
 #endif
 
-	if( java_command )
-	    delete[] java_command;
-
-	if( jira_properties )
-	    delete[] jira_properties;
+	    if( java_command )
+	        delete[] java_command;
 
-	// spawn Java TCP server process
-	int status = system( command );
+	    // spawn Java TCP server process
+	    int status = system( command );
 
-	if( command )
-	    delete[] command;
+	    if( command )
+	        delete[] command;
 
+	    if( status == -1 )
+	    {
+	        err = mk_string( "Unable to spawn Java proxy" );
+	        delete[] jira_properties;
+	        delete[] properties;
+	        return;
+	    }
 
-	if( status == -1 )
-	{
-	    err = mk_string( "Unable to spawn Java proxy" );
-	    return;
+	    // Wait until it answers, backing off up to a second between
+	    // tries; connected() reports a proxy which never does
+	    int delay = 50;
+	    for( int waited = 0; waited < BRIDGE_START; waited += delay )
+	    {
+	        pause_ms( delay );
+	        if( tcp->attach( tcp_server, BRIDGE_PING ) )
+	            break;
+	        if( delay < 1000 )
+	            delay *= 2;
+	    }
 	}
-
-	// wait 8 seconds
-#ifdef OS_NT
-	Sleep( 8000 );
-#else
-	sleep(8);
-#endif
-
-	// Create TCP Connection object
-	tcp = new TcpXML();
+	delete[] jira_properties;
+	delete[] properties;
 
 	// Try connecting
 	valid = 0;
@@ -247,8 +348,13 @@ MyDTS::~MyDTS()
 	if ( java_opts )
 	   delete[] java_opts;
 
-	// Close connections
+	// Close connections, leaving the Java proxy running for the next
+	// connection. It exits when none is made within its socket timeout.
+	if( tcp )
+	    tcp->close_connection();
 	delete tcp;
+	if( bridge_port )
+	    release_port( bridge_port );
 }
 
 void
@@ -304,7 +410,8 @@ MyDTS::connected( char *&err)
 	valid = 0;
 	if( !tcp->opened() )
 	{
-	    if( !tcp->open( tcp_server, my_server, my_user, my_pass ) )
+	    if( !tcp->open( tcp_server, my_server, my_user, my_pass,
+				pipeline_window ) )
 	        if( tcp->error->message )
 	            err = mk_string( "Unable to connect to the JIRA plugin: ",
 				tcp->error->message );
@@ -553,47 +660,53 @@ MyDTS::list_jobs( int max_rows,
 	return list;
 }
 
-struct DTGField *MyDTS::get_defect( const char *defect,
-				struct DTGStrList *ref_fields, char *&err )
+int MyDTS::send_ref_fields( struct DTGStrList *ref_fields, char *&err )
 {
 	// Send ref_fields once per connection to a project
-	// Setting of the ref_fields may not be done until right before this
-	// method is called
+	// Setting of the ref_fields may not be done until right before a
+	// defect is retrieved
+
+	if( !ref_fields || sent_ref_fields )
+	    return 1;
 
 	struct DTGField *args = NULL;
-	if( ref_fields && !sent_ref_fields )
+	args = append_DTGField( args, new_DTGField( "PROJID", projID ) );
+	int n = 0;
+	char num[32];
+	for( struct DTGStrList *i = ref_fields; i; n++, i = i->next )
 	{
-	    args = append_DTGField( args, new_DTGField( "PROJID", projID ) );
-	    int n = 0;
-	    char num[32];
-	    for( struct DTGStrList *i = ref_fields; i; n++, i = i->next )
-	    {
-	        sprintf( num, "F%d", n );
-	        args = append_DTGField( args, new_DTGField( num, i->value ) );
-	    }
-	    if( !tcp->send( "REFERENCED_FIELDS", args ) )
-	    {
-	        err = mk_string("Unable to process referenced fields request: ",
+	    sprintf( num, "F%d", n );
+	    args = append_DTGField( args, new_DTGField( num, i->value ) );
+	}
+	if( !tcp->send( "REFERENCED_FIELDS", args ) )
+	{
+	    err = mk_string("Unable to process referenced fields request: ",
 				tcp->error->message );
-	        delete_DTGField( args );
-	        args = NULL;
-	        return NULL;
-	    }
 	    delete_DTGField( args );
-	    args = NULL;
-	    if( !tcp->strings || !tcp->strings->value || !*tcp->strings->value
+	    return 0;
+	}
+	delete_DTGField( args );
+	if( !tcp->strings || !tcp->strings->value || !*tcp->strings->value
 		|| strcasecmp( tcp->strings->value, "OK" ) )
-	    {
-	        if( tcp->error->message )
-	            err = mk_string( tcp->error->message );
-	        else
-	            err = mk_string( "Referenced fields request failed" );
-	        return NULL;
-	    }
-	    sent_ref_fields = 1;
+	{
+	    if( tcp->error->message )
+	        err = mk_string( tcp->error->message );
+	    else
+	        err = mk_string( "Referenced fields request failed" );
+	    return 0;
 	}
+	sent_ref_fields = 1;
+	return 1;
+}
+
+struct DTGField *MyDTS::get_defect( const char *defect,
+				struct DTGStrList *ref_fields, char *&err )
+{
+	if( !send_ref_fields( ref_fields, err ) )
+	    return NULL;
 
 	// Retrieve specified defect and return the field values
+	struct DTGField *args = NULL;
 	if( !strcasecmp( defect, "new" ) )
 	{
 	    args = append_DTGField( args, new_DTGField( "PROJID", projID ) );
@@ -645,6 +758,57 @@ struct DTGField *MyDTS::get_defect( const char *defect,
 	return args;
 }
 
+/*
+	Retrieves several defects with one GET_DEFECTS request, results[i]
+	being set for defects[i] when returned. A bridge which does not
+	know the request or fails it is left to GET_DEFECT, which reports
+	any error for the individual defects.
+*/
+
+int MyDTS::get_defects( struct DTGStrList *defects, 
+			struct DTGStrList *ref_fields, 
+			struct DTGField **results, char *&err )
+{
+	if( !bulk_ok || !defects || !tcp )
+	    return 0;
+	if( !send_ref_fields( ref_fields, err ) )
+	    return 0;
+
+	struct DTGField *args = NULL;
+	args = append_DTGField( args, new_DTGField( "PROJID", projID ) );
+	int n = 0;
+	char num[32];
+	for( struct DTGStrList *i = defects; i; n++, i = i->next )
+	{
+	    sprintf( num, "D%d", n );
+	    args = append_DTGField( args, new_DTGField( num, i->value ) );
+	}
+	int ok = tcp->send( "GET_DEFECTS", args );
+	delete_DTGField( args );
+	if( !ok )
+	{
+	    // Still answering, so an older bridge without GET_DEFECTS
+	    if( tcp->ping() )
+	        bulk_ok = 0;
+	    return 0;
+	}
+
+	int found = 0;
+	for( struct TcpXMLDefect *d = tcp->defects; d; d = d->next )
+	{
+	    int i = 0;
+	    for( struct DTGStrList *id = defects; id; id = id->next, i++ )
+	        if( !results[i] && d->fields && !strcmp( id->value, d->id ) )
+	        {
+	            results[i] = d->fields;
+	            d->fields = NULL;
+	            found++;
+	            break;
+	        }
+	}
+	return found;
+}
+
 char *MyDTS::save_defect( const char *defect, struct DTGField *fields, char *&err )
 {
 	//  Save defect and return a copy of the resulting defect name
@@ -682,3 +846,97 @@ char *MyDTS::save_defect( const char *defect, struct DTGField *fields, char *&er
 	return mk_string( tcp->strings->value );
 }
 
+/*
+	Saves several defects, keeping up to the agreed window of
+	SAVE_DEFECT/CREATE_DEFECT requests in flight. For defects[i] either
+	names[i] is set as by save_defect or errs[i] is. A bridge which does
+	not pipeline gets them one at a time. Returns the number saved.
+*/
+
+int MyDTS::save_defects( int cnt, const char **defects,
+			struct DTGField **fields, char **names, char **errs )
+{
+	int i;
+	for( i = 0; i < cnt; i++ )
+	    names[i] = errs[i] = NULL;
+
+	int saved = 0;
+	if( tcp->window <= 1 )
+	{
+	    for( i = 0; i < cnt; i++ )
+	        if( ( names[i] = save_defect( defects[i], fields[i], errs[i] ) ) )
+	            saved++;
+	    return saved;
+	}
+
+	// Outstanding REQIDs by defect, 0 once answered
+	long *ids = new long[cnt];
+	int next = 0;
+	int pending = 0;
+	for( ;; )
+	{
+	    while( next < cnt && pending < tcp->window && tcp->opened() )
+	    {
+	        struct DTGField *args = NULL;
+	        args = append_DTGField( args, 
+				new_DTGField( "PROJID", projID ) );
+	        const char *cmd;
+	        if( !strcasecmp( defects[next], "new" ) )
+	            cmd = "CREATE_DEFECT";
+	        else
+	        {
+	            cmd = "SAVE_DEFECT";
+	            args = append_DTGField( args, 
+				new_DTGField( "DEFECTID", defects[next] ) );
+	        }
+	        for( struct DTGField *f = fields[next]; f; f = f->next )
+	            args = append_DTGField( args, 
+				new_DTGField( f->name, f->value ) );
+	        ids[next] = tcp->submit( cmd, args, 1 );
+	        delete_DTGField( args );
+	        if( !ids[next] )
+	            break;
+	        next++;
+	        pending++;
+	    }
+	    if( !pending )
+	        break;
+
+	    int ok = tcp->receive();
+	    for( i = 0; i < next; i++ )
+	        if( ids[i] && ids[i] == tcp->reqid )
+	            break;
+	    if( !tcp->reqid || i == next )
+	    {
+	        // Connection lost, the answers still owed never come
+	        if( !tcp->error->message )
+	            set_DTGError( tcp->error, "Unknown REQID in response" );
+	        break;
+	    }
+	    ids[i] = 0;
+	    pending--;
+	    if( !ok )
+	        errs[i] = mk_string( "Unable to process save request: ",
+				tcp->error->message );
+	    else if( !tcp->strings || !tcp->strings->value || 
+			!*tcp->strings->value )
+	        errs[i] = mk_string( "Defect name not returned" );
+	    else
+	    {
+	        names[i] = mk_string( tcp->strings->value );
+	        saved++;
+	    }
+	}
+
+	// Whatever was not answered failed with the connection
+	for( i = 0; i < cnt; i++ )
+	    if( !names[i] && !errs[i] )
+	    {
+	        errs[i] = mk_string( "Unable to process save request: ",
+				tcp->error->message ? tcp->error->message : 
+				"Lost connection to the JIRA plugin" );
+	        valid = 0;
+	    }
+	delete[] ids;
+	return saved;
+}
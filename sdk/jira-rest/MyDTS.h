@@ -35,6 +35,7 @@ class MyDTS {
 	    int wait_time;
 	    char *tcp_port;
 	    char *tcp_server;
+	    int bridge_port;	// claimed in held_ports, 0 if none
 	    char *java_opts;
 	    char *my_server;
 	    char *my_user;
@@ -43,15 +44,18 @@ class MyDTS {
 	    char *my_prog_ver;
 	    char *my_config;
 	    int defect_batch;
+	    int pipeline_window;
 
 	    char *dtID;
 	    char *projID;
 	    char *defectName;
 	    int sent_ref_fields;
+	    int bulk_ok;	// bridge accepts GET_DEFECTS
 
 	    TcpXML *tcp;
 
 	    int connected( char *&err );
+	    int send_ref_fields( struct DTGStrList *ref_fields, char *&err );
 
 	public:
 	    MyDTS( const char *server, 
@@ -79,8 +83,14 @@ class MyDTS {
 		char *&err );
 	    struct DTGField *get_defect( const char *defect, 
 				struct DTGStrList *ref_fields, char *&err );
+	    int get_defects( struct DTGStrList *defects, 
+				struct DTGStrList *ref_fields, 
+				struct DTGField **results, char *&err );
 	    char *save_defect( const char *defect,
 				struct DTGField *fields, char *&err );
+	    int save_defects( int cnt, const char **defects,
+				struct DTGField **fields, 
+				char **names, char **errs );
 };
 
 #endif
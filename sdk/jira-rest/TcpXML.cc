@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
 extern "C" {
 #include "dtg-utils.h"
 }
@@ -31,13 +32,20 @@ extern "C" {
 #ifndef OS_NT
 #include <netdb.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/time.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #else
 #include <winsock2.h>
 #include <io.h>
 #endif
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 int open_socket( const char *host, int port )
 {
 # ifdef OS_NT
@@ -71,70 +79,173 @@ int open_socket( const char *host, int port )
 
 	if( connect( fd, (struct sockaddr *)&target,
 			sizeof(struct sockaddr) ) == -1 )
+	{
+#ifdef OS_NT
+	    closesocket( fd );
+#else
+	    close( fd );
+#endif
 	    return -1;
+	}
+
+	// Requests are a single write answered before the next one, so
+	// waiting to coalesce small segments only adds latency
+	int on = 1;
+	setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, 
+			sizeof( on ) );
 	return fd;
 }
 
-/* Message format: LENGTH_OF_MESSAGE_IN_BYTESmessage */
+/* Connects to "host:port" */
 
-int send_string( int fd, const char *str )
+static int connect_server( const char *my_server )
 {
-	size_t len = strlen( str );
-	char num[32]; 	   	
-	sprintf( num, "%ld", strlen( str ) );
-	int i = send( fd, num, strlen( num ), 0 );
-	i = send( fd, str, len, 0 );
-	return i;
+	char *server = strdup( my_server );
+	char *my_port = strchr( server, ':' );
+	if( !my_port )
+	{
+	    free( server );
+	    return -1;
+	}
+	*my_port++ = '\0'; // skip over ':'
+	int fd = open_socket( server, atoi( my_port ) );
+	free( server );
+	return fd;
 }
 
-int recv_string( int fd, char *&str )
-{
-	char buffer[8096+1];
-	long end = 8096;
-	int done = 0;
+/* Limits how long a receive waits, 0 to wait indefinitely */
 
-	long len = end;
-	str = new char[len+1];
-	long cnt;
+static void set_timeout( int fd, int ms )
+{
+#ifdef OS_NT
+	DWORD tv = ms;
+#else
+	struct timeval tv;
+	tv.tv_sec = ms / 1000;
+	tv.tv_usec = ( ms % 1000 ) * 1000;
+#endif
+	setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, 
+			sizeof( tv ) );
+}
 
-	// clean up the buffer
-	memset(buffer, 0, end);
+/* Message format: LENGTH_OF_MESSAGE_IN_BYTESmessage */
 
-	if( (cnt = recv( fd, buffer, end, 0 )) == -1 )
-	    return 0;
-	size_t msg = atol( buffer );
+int send_string( int fd, const char *str )
+{
+	size_t len = strlen( str );
 	char num[32];
-	sprintf( num, "%ld", msg );
+	sprintf( num, "%lu", (unsigned long)len );
+	size_t num_len = strlen( num );
 
-	msg = msg - cnt + strlen( num );
-	int i;
-	long j = 0;
-	for( i = strlen( num ); i < cnt; i++,j++ )
-	    str[j] = buffer[i];
-	str[j] = '\0';
-
-	while( msg > 0 )
+	// Length and message go out in one write, resumed after short ones
+	size_t sent = 0;
+	size_t total = num_len + len;
+	while( sent < total )
 	{
-	    // clean up the buffer
-	    memset(buffer, 0, end);
+	    long cnt;
+#ifdef OS_NT
+	    WSABUF bufs[2];
+	    DWORD bytes = 0;
+	    int nbufs = 0;
+	    if( sent < num_len )
+	    {
+	        bufs[nbufs].buf = num + sent;
+	        bufs[nbufs++].len = (ULONG)( num_len - sent );
+	    }
+	    size_t off = sent > num_len ? sent - num_len : 0;
+	    bufs[nbufs].buf = (char *)str + off;
+	    bufs[nbufs++].len = (ULONG)( len - off );
+	    if( WSASend( fd, bufs, nbufs, &bytes, 0, NULL, NULL ) )
+	        return -1;
+	    cnt = bytes;
+#else
+	    struct iovec bufs[2];
+	    int nbufs = 0;
+	    if( sent < num_len )
+	    {
+	        bufs[nbufs].iov_base = num + sent;
+	        bufs[nbufs++].iov_len = num_len - sent;
+	    }
+	    size_t off = sent > num_len ? sent - num_len : 0;
+	    bufs[nbufs].iov_base = (char *)str + off;
+	    bufs[nbufs++].iov_len = len - off;
+	    struct msghdr msg;
+	    memset( &msg, 0, sizeof( msg ) );
+	    msg.msg_iov = bufs;
+	    msg.msg_iovlen = nbufs;
+	    cnt = sendmsg( fd, &msg, MSG_NOSIGNAL );
+	    if( cnt < 0 && errno == EINTR )
+	        continue;
+#endif
+	    if( cnt <= 0 )
+	        return -1;
+	    sent += cnt;
+	}
+	return (int)len;
+}
+
+/*
+	Reads the next message. Pipelined responses are written as they
+	complete, so a read can take the end of one and the start of the
+	next; whatever follows the message is left in `in` for the next call.
+*/
+
+int recv_string( int fd, struct TcpRecvBuffer &in, char *&str )
+{
+	str = NULL;
 
-	    if( (cnt = recv( fd, buffer, end, 0 )) == -1 )
+	// The length may arrive split across reads; it ends at the '<'
+	// starting the message
+	size_t msg = 0;
+	int digits = 0;
+	for( ;; )
+	{
+	    if( in.pos == in.cnt )
+	    {
+	        in.pos = in.cnt = 0;
+	        long cnt = recv( fd, in.data, sizeof( in.data ), 0 );
+#ifndef OS_NT
+	        if( cnt < 0 && errno == EINTR )
+	            continue;
+#endif
+	        if( cnt <= 0 )
+	            return 0;
+	        in.cnt = cnt;
+	    }
+	    char c = in.data[in.pos];
+	    if( c < '0' || c > '9' )
+	        break;
+	    if( ++digits > 18 )
 	        return 0;
-	    if( (j + cnt) >= len )
+	    msg = msg * 10 + ( c - '0' );
+	    in.pos++;
+	}
+	if( !digits )
+	    return 0;
+
+	// The size is known, so the rest of the message is read in place
+	str = new char[msg + 1];
+	size_t j = in.cnt - in.pos;
+	if( j > msg )
+	    j = msg;
+	memcpy( str, &in.data[in.pos], j );
+	in.pos += j;
+	while( j < msg )
+	{
+	    long cnt = recv( fd, &str[j], msg - j, 0 );
+#ifndef OS_NT
+	    if( cnt < 0 && errno == EINTR )
+	        continue;
+#endif
+	    if( cnt <= 0 )
 	    {
-	        // expand input buffer
-	        len += end;
-	        char *tmp = new char[len + 1];
-	        tmp[0] = '\0';
-	        strcat( tmp, str );
 	        delete[] str;
-	        str = tmp;
+	        str = NULL;
+	        return 0;
 	    }
-	    for( int i = 0; i < cnt; i++,j++ )
-	        str[j] = buffer[i];
-	    str[j] = '\0';
-	    msg -= cnt;
+	    j += cnt;
 	}
+	str[msg] = '\0';
 	return 1;
 }
 
@@ -146,9 +257,14 @@ int recv_string( int fd, char *&str )
 	Requests/Responses:
 	-------------------
 	connect() -> return randomString in STRINGS
-		<CONNECT />
+		<CONNECT WINDOW="n" />
 
 		<STRINGS> <STRING value="randomString" />
+			[ <STRING value="WINDOW=m" /> ] </STRINGS>
+
+		WINDOW is optional, asking for up to n requests in flight.
+		A bridge able to pipeline answers with the m (<= n) it
+		accepts; older bridges ignore it and stay lock-step.
 
 	shutdown() -> no return value
 		<SHUTDOWN />
@@ -266,8 +382,26 @@ Responses:
 		</DESC>
 		...
 
+	<DEFECTS>
+		<FIELDS DEFECT="defectN">
+			<FIELD NAME="fieldN" VALUE="val1" />
+			...
+		</FIELDS>
+		...
+	</DEFECTS>
+
 	<ERROR CONTINUE="0|1", MESSAGE="message1" />
 
+Pipelining:
+	Once a window of m has been agreed, up to m requests may carry
+	REQID="k" on their root element. The bridge runs them concurrently
+	and wraps each response, sending them as they complete:
+
+	<RESPONSE REQID="k"> ...response as above... </RESPONSE>
+
+	A request without REQID is answered in order, unwrapped, after all
+	requests in flight have been answered.
+
 ***/
 
 void TcpXML::clear()
@@ -278,6 +412,14 @@ void TcpXML::clear()
 	fields = NULL;
 	delete_DTGFieldDesc( descs );
 	descs = NULL;
+	while( defects )
+	{
+	    struct TcpXMLDefect *d = defects;
+	    defects = d->next;
+	    delete[] d->id;
+	    delete_DTGField( d->fields );
+	    delete d;
+	}
 	clear_DTGError( error );
 }
 
@@ -298,38 +440,47 @@ TcpXML::TcpXML()
 	strings = NULL;
 	fields = NULL;
 	descs = NULL;
+	defects = NULL;
 	error = new_DTGError( NULL );
 	sfd = -1;
+	inbuf.pos = inbuf.cnt = 0;
+	next_reqid = 0;
+	reqid = 0;
+	window = 1;
 };
 
-int TcpXML::open( const char *my_server, const char *dts_url, const char *dts_user, const char *dts_pass )
+int TcpXML::open( const char *my_server, const char *dts_url, const char *dts_user, const char *dts_pass, int max_window )
 {
 	if( !my_server || !*my_server || !dts_url || !*dts_url || !dts_user || !*dts_user || !dts_pass || !*dts_pass )
 	    return 0;
-	if( sfd >= 0 )
-	    return 0;
+
+	// A connection made by attach() is used as is
+	if( sfd < 0 )
+	    sfd = connect_server( my_server );
 
 	char *url = strdup(dts_url);
 	char *user = strdup(dts_user);
 	char *pass = strdup(dts_pass);
-	char *server = strdup(my_server);
-	char *my_port;
-	my_port = strchr( server, ':' );
-	if( my_port )
-	{
-	    *my_port = '\0';
-	    my_port++; // skip over ':'
-	}
-	else
+
+	window = 1;
+	struct DTGField *args = NULL;
+	if( max_window > 1 )
 	{
-	    free(server);
-	    return 0;
+	    char num[32];
+	    sprintf( num, "%d", max_window );
+	    args = new_DTGField( "WINDOW", num );
 	}
+	this->send( "CONNECT", args );
+	delete_DTGField( args );
+	args = NULL;
+	for( struct DTGStrList *s = strings; s; s = s->next )
+	    if( s->value && !strncmp( s->value, "WINDOW=", 7 ) )
+	    {
+	        window = atoi( &s->value[7] );
+	        if( window < 1 || window > max_window )
+	            window = 1;
+	    }
 
-	sfd = open_socket( server, atoi( my_port ) );
-	free(server);
-
-	this->send( "CONNECT", NULL );
 	// Check response
 	if( !strings || !strings->value || !*strings->value )
 	{
@@ -348,7 +499,6 @@ int TcpXML::open( const char *my_server, const char *dts_url, const char *dts_us
 	}
 
     // DTS login info
-    struct DTGField *args = NULL;
     args = append_DTGField( args, new_DTGField( "JIRA_URL", url ) );
     args = append_DTGField( args, new_DTGField( "JIRA_USER", user ) );
     args = append_DTGField( args, new_DTGField( "JIRA_PASSWORD", pass ) );
@@ -379,6 +529,32 @@ int TcpXML::open( const char *my_server, const char *dts_url, const char *dts_us
 	return 1;
 }
 
+/*
+	Connects to a bridge already running at server and checks that it
+	answers a PING within timeout_ms. A bridge serving another client
+	does not read our request until that client leaves, so it is taken
+	as not available. The connection is kept for open() on success.
+*/
+
+int TcpXML::attach( const char *server, int timeout_ms )
+{
+	if( sfd >= 0 || !server )
+	    return 0;
+	sfd = connect_server( server );
+	if( sfd < 0 )
+	    return 0;
+
+	set_timeout( sfd, timeout_ms );
+	int ok = ping();
+	if( sfd >= 0 )
+	{
+	    set_timeout( sfd, 0 );
+	    if( !ok )
+	        close_connection();
+	}
+	return ok;
+}
+
 int TcpXML::close_connection()
 {
 	if( sfd < 0 )
@@ -392,6 +568,7 @@ int TcpXML::close_connection()
 # endif
 
 	sfd = -1;
+	inbuf.pos = inbuf.cnt = 0; // belonged to the old stream
 	return 1;
 }
 
@@ -410,12 +587,12 @@ int TcpXML::ping()
 	return 1;
 }
 
-int TcpXML::send( const char *req, struct DTGField *args, int elements )
+char *TcpXML::request( const char *req, struct DTGField *args, 
+				int elements, long id )
 {
-	if( sfd < 0 )
-	    return 0;
-
 	TiXmlElement elem( req );
+	if( id )
+	    elem.SetAttribute( "REQID", (int)id );
 	if( elements )
 	    for( struct DTGField *a = args; a; a = a->next )
 	    {
@@ -432,19 +609,37 @@ int TcpXML::send( const char *req, struct DTGField *args, int elements )
 	
 	TiXmlOutStream out;
 	out << elem;
-	const char *txt = out.c_str();
-
+	return mk_string( out.c_str() );
+}
 
-	// Send Request
+int TcpXML::transfer( const char *txt )
+{
 #ifdef DEBUG
 	fprintf( stderr, "REQ:%s\n", txt );
 #endif
-	send_string( sfd, txt );
+	if( send_string( sfd, txt ) < 0 )
+	{
+	    // The stream can no longer be trusted to be in step
+	    close_connection();
+	    set_DTGError( error, "Lost connection to the JIRA plugin" );
+	    return 0;
+	}
+	return 1;
+}
 
-	// Process Response
+int TcpXML::receive_response()
+{
 	clear();
+	reqid = 0;
 	char *str = NULL;
-	recv_string( sfd, str );
+	if( !recv_string( sfd, inbuf, str ) )
+	{
+	    close_connection();
+	    set_DTGError( error, "Lost connection to the JIRA plugin" );
+	    return 0;
+	}
+
+	// Process Response
 #ifdef DEBUG
 	fprintf( stderr, "RECV:%s\n", str );
 #endif
@@ -460,6 +655,69 @@ int TcpXML::send( const char *req, struct DTGField *args, int elements )
 	    return 1;
 }
 
+int TcpXML::send( const char *req, struct DTGField *args, int elements )
+{
+	if( sfd < 0 )
+	    return 0;
+
+	// Send Request
+	char *txt = request( req, args, elements, 0 );
+	clear();
+	int ok = transfer( txt );
+	delete[] txt;
+	if( !ok )
+	    return 0;
+	return receive_response();
+}
+
+/*
+	Sends a request without waiting for its response, returning the
+	REQID the response will carry or 0 if it could not be sent. The
+	caller keeps no more than window requests outstanding.
+*/
+
+long TcpXML::submit( const char *req, struct DTGField *args, int elements )
+{
+	if( sfd < 0 )
+	    return 0;
+
+	long id = ++next_reqid;
+	if( next_reqid >= 0x7fffffffL )
+	    next_reqid = 0;
+	char *txt = request( req, args, elements, id );
+	clear();
+	int ok = transfer( txt );
+	delete[] txt;
+	return ok ? id : 0;
+}
+
+/*
+	Reads the next response of a submitted request, in whatever order
+	they complete. The results are left as for send() with reqid set;
+	a reqid of 0 means the connection was lost or out of step, and
+	is closed.
+*/
+
+int TcpXML::receive()
+{
+	if( sfd < 0 )
+	{
+	    reqid = 0;
+	    set_DTGError( error, "Lost connection to the JIRA plugin" );
+	    return 0;
+	}
+	int ok = receive_response();
+	if( !reqid && sfd >= 0 )
+	{
+	    // Not one of ours, so the responses can not be matched
+	    close_connection();
+	    if( !error->message )
+	        set_DTGError( error, "Unexpected response from the JIRA plugin" );
+	    return 0;
+	}
+	return ok;
+}
+
 void TcpXML::process_strings( TiXmlNode *n )
 {
 	for( TiXmlNode *s = n->FirstChild(); s; s = s->NextSibling() )
@@ -525,6 +783,34 @@ void TcpXML::process_descs( TiXmlNode *n )
 	}
 }
 
+void TcpXML::process_defects( TiXmlNode *n )
+{
+	struct TcpXMLDefect *last = NULL;
+	for( TiXmlNode *s = n->FirstChild(); s; s = s->NextSibling() )
+	{
+	    if( !(s->Type() == TiXmlNode::ELEMENT ) ||
+		strcasecmp( s->Value(), "FIELDS" ) )
+	        continue;
+	    TiXmlElement *e = s->ToElement();
+	    if( !e->Attribute( "DEFECT" ) )
+	        continue;
+
+	    struct DTGField *tmp = fields;
+	    fields = NULL;
+	    process_fields( s );
+	    struct TcpXMLDefect *d = new TcpXMLDefect;
+	    d->id = mk_string( e->Attribute( "DEFECT" ) );
+	    d->fields = fields;
+	    d->next = NULL;
+	    fields = tmp;
+	    if( last )
+	        last->next = d;
+	    else
+	        defects = d;
+	    last = d;
+	}
+}
+
 void TcpXML::process_error( TiXmlNode *n )
 {
 	TiXmlElement *e = n->ToElement();
@@ -553,17 +839,30 @@ void TcpXML::parse( const char *xml )
 	const char *txt = out.c_str();
 
 	for( TiXmlNode *n = doc.FirstChild(); n; n = n->NextSibling() )
+	    process_node( n );
+}
+
+void TcpXML::process_node( TiXmlNode *n )
+{
+	if( !(n->Type() == TiXmlNode::ELEMENT ) )
+	    return;
+	const char *val = n->Value();
+	if( !strcasecmp( val, "STRINGS" ) )
+	    process_strings( n );
+	else if( !strcasecmp( val, "FIELDS" ) )
+	    process_fields( n );
+	else if( !strcasecmp( val, "DESCS" ) )
+	    process_descs( n );
+	else if( !strcasecmp( val, "DEFECTS" ) )
+	    process_defects( n );
+	else if( !strcasecmp( val, "ERROR" ) )
+	    process_error( n );
+	else if( !strcasecmp( val, "RESPONSE" ) )
 	{
-	    if( !(n->Type() == TiXmlNode::ELEMENT ) )
-	        continue;
-	    const char *val = n->Value();
-	    if( !strcasecmp( val, "STRINGS" ) )
-	        process_strings( n );
-	    else if( !strcasecmp( val, "FIELDS" ) )
-	        process_fields( n );
-	    else if( !strcasecmp( val, "DESCS" ) )
-	        process_descs( n );
-	    else if( !strcasecmp( val, "ERROR" ) )
-	        process_error( n );
+	    // Pipelined response
+	    const char *id = n->ToElement()->Attribute( "REQID" );
+	    reqid = id ? atol( id ) : 0;
+	    for( TiXmlNode *c = n->FirstChild(); c; c = c->NextSibling() )
+	        process_node( c );
 	}
 }
@@ -26,13 +26,38 @@
 struct DTGField;
 class TiXmlNode;
 
+/* Bytes received but not yet taken by a message */
+struct TcpRecvBuffer {
+	char data[8192];
+	long pos;
+	long cnt;
+};
+
+int send_string( int fd, const char *str );
+int recv_string( int fd, struct TcpRecvBuffer &in, char *&str );
+
+/* One defect of a DEFECTS response */
+struct TcpXMLDefect {
+	char *id;
+	struct DTGField *fields;
+	struct TcpXMLDefect *next;
+};
+
 class TcpXML {
 	protected:
 	    int sfd; 		// socket file descriptor
+	    long next_reqid;	// last REQID submitted
+	    struct TcpRecvBuffer inbuf; // start of the next response
 
+	    char *request( const char *req, struct DTGField *args, 
+				int elements, long reqid );
+	    int transfer( const char *txt );
+	    int receive_response();
+	    void process_node( TiXmlNode *n );
 	    void process_strings( TiXmlNode *n );
 	    void process_fields( TiXmlNode *n );
 	    void process_descs( TiXmlNode *n );
+	    void process_defects( TiXmlNode *n );
 	    void process_error( TiXmlNode *n );
 	    void parse( const char *xml );
 	    void clear();
@@ -41,18 +66,27 @@ class TcpXML {
 	    struct DTGStrList *strings;
 	    struct DTGField *fields;
 	    struct DTGFieldDesc *descs;
+	    struct TcpXMLDefect *defects;
 	    struct DTGError *error;
+	    long reqid;		// REQID of the last response, 0 if none
+	    int window;		// requests the bridge takes in flight
 
 	public:
 	    TcpXML();
 	    virtual ~TcpXML();
 
-	    int open( const char *server, const char *url, const char *user, const char *pass );
+	    int open( const char *server, const char *url, const char *user, const char *pass, int max_window = 1 );
+	    int attach( const char *server, int timeout_ms );
 	    int close_connection();
 	    int ping();
 
 	    int send( const char *req, struct DTGField *args, int elements=0 );
 
+	    // Pipelined requests, see the protocol notes in TcpXML.cc
+	    long submit( const char *req, struct DTGField *args, 
+				int elements=0 );
+	    int receive();
+
 	    int opened() { return (sfd >= 0) ? 1 : 0; };
 };
 
@@ -26,6 +26,7 @@ import java.util.Collections;
 import java.util.Date;
 import java.util.HashMap;
 import java.util.HashSet;
+import java.util.LinkedHashMap;
 import java.util.LinkedList;
 import java.util.List;
 import java.util.Map;
@@ -70,6 +71,7 @@ import com.perforce.p4dtg.plugin.jira.tcp.internal.response.StringResponse;
 import com.perforce.p4dtg.plugin.jira.tcp.response.IResponse;
 import java.util.logging.Handler;
 import org.joda.time.DateTime;
+import io.atlassian.util.concurrent.Promise;
 
 /**
  * Manage the requests for the creation, modification and deletion of remote
@@ -413,6 +415,66 @@ public class RequestHandler extends AbstractRequestHandler {
                     + defectId + " not found", "0"));
         }
 
+        return getDefectFields(issue);
+    }
+
+    /**
+     * Gets several defects, requesting them from the JIRA server in
+     * parallel. Defects which cannot be retrieved are left out so the
+     * client can request them individually.
+     *
+     * @param request the request
+     * @return the defect fields by defect id, in request order
+     * @throws RequestException the request exception
+     * @see
+     * com.perforce.p4dtg.plugin.jira.tcp.IRequestHandler#getDefects(org.w3c.dom.Element)
+     */
+    @Override
+    public Map<String, FieldResponse[]> getDefects(Element request) throws RequestException {
+        TimeCommand timer = new TimeCommand();
+        String qMsg = ".";
+        String projId = request.getAttribute(PROJID);
+        if (Utils.isEmpty(projId)) {
+            throw new RequestException(new ErrorResponse(
+                    "Missing PROJID in getDefects", "0"));
+        }
+
+        Map<String, Promise<Issue>> pending = new LinkedHashMap<>();
+        for (int i = 0; request.hasAttribute("D" + i); i++) {
+            String defectId = request.getAttribute("D" + i);
+            if (!Utils.isEmpty(defectId)) {
+                pending.put(defectId, restClientManager.getExtendedIssueClient().getIssue(defectId));
+            }
+        }
+        if (logger.isLoggable(Level.FINER)) {
+            qMsg = "getDefects: getIssue x" + pending.size();
+            logStart(qMsg, timer);
+        }
+
+        Map<String, FieldResponse[]> defects = new LinkedHashMap<>();
+        for (Entry<String, Promise<Issue>> defect : pending.entrySet()) {
+            try {
+                Issue issue = defect.getValue().claim();
+                if (issue != null) {
+                    defects.put(defect.getKey(), getDefectFields(issue));
+                }
+            } catch (RestClientException e) {
+                logger.log(Level.FINE, "getDefects: " + defect.getKey() + " :" + e.toString());
+            }
+        }
+        if (logger.isLoggable(Level.FINER)) {
+            logStop(qMsg, timer);
+        }
+        return defects;
+    }
+
+    /**
+     * Gets the field responses of a defect.
+     *
+     * @param issue the issue
+     * @return the field responses
+     */
+    private FieldResponse[] getDefectFields(Issue issue) {
         DefectFieldsMapBuilder dfmBuilder = new DefectFieldsMapBuilder(issue,
                 this.issueFieldsMapper, this.configuration);
         Map<String, String[]> fieldValueMap = dfmBuilder.build();
@@ -17,6 +17,8 @@
 */
 package com.perforce.p4dtg.plugin.jira.tcp.request;
 
+import java.util.Map;
+
 import org.w3c.dom.Element;
 
 import com.perforce.p4dtg.plugin.jira.tcp.internal.request.RequestException;
@@ -202,6 +204,18 @@ public interface IRequestHandler {
      */
     FieldResponse[] getDefect(Element request) throws RequestException;
 
+    /**
+     * Get the response to a get defects request.
+     *
+     * @param request
+     *            the request
+     * @return - field responses by defect id, in request order; defects
+     *           which could not be retrieved are left out
+     * @throws RequestException
+     *             the request exception
+     */
+    Map<String, FieldResponse[]> getDefects(Element request) throws RequestException;
+
     /**
      * Get the response to a create defect request.
      *
@@ -31,6 +31,9 @@ public interface IResponse {
     String FIELD = "FIELD";
     String FIELDS = "FIELDS";
 
+    String DEFECT = "DEFECT";
+    String DEFECTS = "DEFECTS";
+
     String ERROR = "ERROR";
     String MESSAGE = "MESSAGE";
     String CONTINUE = "CONTINUE";
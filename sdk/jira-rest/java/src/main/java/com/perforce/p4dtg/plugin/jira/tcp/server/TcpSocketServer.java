@@ -28,7 +28,14 @@ import java.net.InetAddress;
 import java.net.ServerSocket;
 import java.net.Socket;
 import java.nio.charset.Charset;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Map;
 import java.util.Properties;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
 import java.util.logging.Level;
 import java.util.logging.Logger;
 
@@ -47,6 +54,8 @@ import com.perforce.p4dtg.plugin.jira.tcp.internal.request.RequestHandler;
 import com.perforce.p4dtg.plugin.jira.tcp.internal.response.DescriptionResponse;
 import com.perforce.p4dtg.plugin.jira.tcp.internal.response.ErrorResponse;
 import com.perforce.p4dtg.plugin.jira.tcp.internal.response.FieldResponse;
+import com.perforce.p4dtg.plugin.jira.tcp.internal.response.ResponseHelper;
+import com.perforce.p4dtg.plugin.jira.tcp.internal.response.StringResponse;
 import com.perforce.p4dtg.plugin.jira.tcp.request.IRequestHandler;
 import com.perforce.p4dtg.plugin.jira.tcp.response.IResponse;
 
@@ -94,7 +103,8 @@ public class TcpSocketServer {
         SEGMENT_FILTERS,
         REFERENCED_FIELDS,
         SAVE_DEFECT,
-        GET_DEFECT
+        GET_DEFECT,
+        GET_DEFECTS
     }
 
     private DocumentBuilderFactory factory;
@@ -102,6 +112,21 @@ public class TcpSocketServer {
 
     private boolean shutdown = false;
 
+    /**
+     * Most requests a connection may keep in flight.
+     */
+    private static final int MAX_WINDOW = 32;
+
+    /**
+     * Requests in flight agreed on CONNECT, 1 for lock-step.
+     */
+    private int window = 1;
+
+    /**
+     * Set when DTG has closed the connection.
+     */
+    private boolean endOfStream = false;
+
     /**
      * Constructor to create a new TCP XML socket server with a request handler.
      *
@@ -143,6 +168,7 @@ public class TcpSocketServer {
             try {
                 StringBuilder readLength = new StringBuilder();
                 int read = stream.read();
+                endOfStream = read == -1;
                 while (read != '<' && read != -1) {
                     readLength.append((char) read);
                     read = stream.read();
@@ -174,6 +200,7 @@ public class TcpSocketServer {
             } catch (SAXException e) {
                 logger.log(Level.SEVERE, "XML parser exception reading request.", e);
             } catch (IOException e) {
+                endOfStream = true;
                 logger.log(Level.SEVERE, "I/O exception reading from stream.", e);
             } catch (NumberFormatException e) {
                 logger.log(Level.SEVERE, "Number format exception parsing message length.", e);
@@ -227,6 +254,50 @@ public class TcpSocketServer {
         return wrapResponseArray(responses, IResponse.FIELDS);
     }
 
+    /**
+     * Wrap the field responses of several defects.
+     *
+     * @param defects
+     *            the field responses by defect id
+     * @return the i response
+     */
+    private IResponse wrapDefectResponses(Map<String, FieldResponse[]> defects) {
+        IResponse response = null;
+        if (defects != null) {
+            final StringBuilder xml = new StringBuilder();
+            xml.append('<');
+            xml.append(IResponse.DEFECTS);
+            xml.append('>');
+            for (Map.Entry<String, FieldResponse[]> defect : defects.entrySet()) {
+                xml.append('<');
+                xml.append(IResponse.FIELDS);
+                xml.append(' ');
+                xml.append(IResponse.DEFECT);
+                xml.append("=\"");
+                xml.append(ResponseHelper.escapeXML(defect.getKey()));
+                xml.append("\">");
+                for (FieldResponse field : defect.getValue()) {
+                    if (field != null) {
+                        xml.append(field.toString());
+                    }
+                }
+                xml.append("</");
+                xml.append(IResponse.FIELDS);
+                xml.append('>');
+            }
+            xml.append("</");
+            xml.append(IResponse.DEFECTS);
+            xml.append('>');
+
+            response = new IResponse() {
+                public String toString() {
+                    return xml.toString();
+                }
+            };
+        }
+        return response;
+    }
+
     /**
      * Wrap description responses.
      *
@@ -255,6 +326,87 @@ public class TcpSocketServer {
         return requestType;
     }
 
+    /**
+     * Gets the window asked for by a CONNECT request, limited to MAX_WINDOW.
+     *
+     * @param root
+     *            the request element
+     * @return the window, 1 when not asked for
+     */
+    private int getWindow(Element root) {
+        try {
+            int asked = Integer.parseInt(root.getAttribute("WINDOW"));
+            return Math.max(1, Math.min(asked, MAX_WINDOW));
+        } catch (NumberFormatException e) {
+            return 1;
+        }
+    }
+
+    /**
+     * Gets the REQID of a pipelined request.
+     *
+     * @param request
+     *            the request
+     * @return the request id, null when answered in order
+     */
+    private String getRequestId(Document request) {
+        Element root = request.getDocumentElement();
+        if (root != null && window > 1) {
+            String reqId = root.getAttribute("REQID");
+            if (reqId.matches("\\d{1,10}")) {
+                return reqId;
+            }
+        }
+        return null;
+    }
+
+    /**
+     * Write a response, prefixed by its length. Pipelined responses are
+     * written from several threads, one whole response at a time.
+     *
+     * @param outgoing
+     *            the output stream
+     * @param response
+     *            the response
+     * @throws IOException
+     *             the exception
+     */
+    private void writeResponse(OutputStream outgoing, String response) throws IOException {
+        byte[] byteResponse = response.getBytes(charset);
+        synchronized (outgoing) {
+            outgoing.write(Integer.toString(byteResponse.length).getBytes(charset));
+            outgoing.write(byteResponse);
+            outgoing.flush();
+        }
+        if (DUMP_TRAFFIC) {
+            logger.info("Response length: " + byteResponse.length);
+            logger.info("Response: " + response);
+        }
+    }
+
+    /**
+     * Wait for the pipelined requests in flight to be answered.
+     *
+     * @param inFlight
+     *            the requests in flight
+     * @throws Exception
+     *             the exception writing a response
+     */
+    private void awaitResponses(List<Future<Void>> inFlight) throws Exception {
+        try {
+            for (Future<Void> pending : inFlight) {
+                pending.get();
+            }
+        } catch (ExecutionException e) {
+            if (e.getCause() instanceof IOException) {
+                throw (IOException) e.getCause();
+            }
+            throw new Exception(e.getCause());
+        } finally {
+            inFlight.clear();
+        }
+    }
+
     /**
      * Gets the response.
      *
@@ -275,7 +427,12 @@ public class TcpSocketServer {
                         response = handler.shutdown(root);
                         break;
                     case CONNECT:
-                        response = handler.connect(root);
+                        StringResponse connected = handler.connect(root);
+                        window = getWindow(root);
+                        if (window > 1) {
+                            connected.add("WINDOW=" + window);
+                        }
+                        response = connected;
                         break;
                     case LOGIN:
                         response = handler.login(root);
@@ -318,6 +475,9 @@ public class TcpSocketServer {
                     case GET_DEFECT:
                         response = wrapFieldResponses(handler.getDefect(root));
                         break;
+                    case GET_DEFECTS:
+                        response = wrapDefectResponses(handler.getDefects(root));
+                        break;
                     default:
                         response = new ErrorResponse("Unhandled element name in request: " + rootTag, "0");
                         break;
@@ -358,42 +518,71 @@ public class TcpSocketServer {
     private void handle(Socket socket) throws Exception {
         InputStream incoming = null;
         OutputStream outgoing = null;
+        ExecutorService pool = null;
+        List<Future<Void>> inFlight = new ArrayList<Future<Void>>();
+        window = 1;
         try {
             incoming = socket.getInputStream();
+            outgoing = socket.getOutputStream();
             Document request = getRequest(incoming);
             while (request != null) {
-                String response = getResponse(request);
-                if (response == null) {
-                    break;
-                }
-                outgoing = socket.getOutputStream();
-                byte[] byteResponse = response.getBytes(charset);
-                outgoing.write(Integer.toString(byteResponse.length).getBytes(charset));
-                outgoing.write(byteResponse);
-                outgoing.flush();
-                if (DUMP_TRAFFIC) {
-                    logger.info("Response length: " + byteResponse.length);
-                    logger.info("Response: " + response);
+                String reqId = getRequestId(request);
+                if (reqId != null) {
+                    // Pipelined, answered when done
+                    if (pool == null) {
+                        pool = Executors.newFixedThreadPool(window);
+                    }
+                    final Document pipelined = request;
+                    final OutputStream out = outgoing;
+                    inFlight.removeIf(Future::isDone);
+                    inFlight.add(pool.submit(() -> {
+                        String response = getResponse(pipelined);
+                        if (response == null) {
+                            response = new ErrorResponse("Unable to process the request.", "0").toString();
+                        }
+                        writeResponse(out, "<RESPONSE REQID=\"" + reqId + "\">" + response + "</RESPONSE>");
+                        return null;
+                    }));
+                } else {
+                    // Answered in order, after those in flight
+                    awaitResponses(inFlight);
+                    String response = getResponse(request);
+                    if (response == null) {
+                        break;
+                    }
+                    writeResponse(outgoing, response);
+                    Request requestType = getRequestType(request);
+                    if (requestType == Request.SHUTDOWN) {
+                        shutdown = true;
+                        break;
+                    }
                 }
-                Request requestType = getRequestType(request);
-                if (requestType == Request.SHUTDOWN) {
-                    shutdown = true;
+                request = getRequest(incoming);
+                if (request == null && endOfStream) {
+                    // Closed without SHUTDOWN, wait for the next connection
+                    awaitResponses(inFlight);
+                    if (DUMP_TRAFFIC) {
+                        logger.info("Connection closed by DTG.");
+                    }
                     break;
                 }
-                request = getRequest(incoming);
 	            if (request == null) {
 	                logger.severe("Unable to parse request.");
 	                ErrorResponse er = new ErrorResponse("Unable to parse the request.", "0");
-	                byteResponse = er.toString().getBytes(charset);
-	                outgoing.write(Integer.toString(byteResponse.length).getBytes(charset));
-	                outgoing.write(byteResponse);
-	                outgoing.flush();
+	                awaitResponses(inFlight);
+	                writeResponse(outgoing, er.toString());
 	            }
             }
+        } catch (IOException e) {
+            // DTG went away, the next connection may reuse this server
+            logger.log(Level.WARNING, "Connection to DTG lost.", e);
         } catch (Throwable e) {
             logger.log(Level.SEVERE, "Problem occurred while handling request.", e);
             throw new Exception(e);
         } finally {
+            if (pool != null) {
+                pool.shutdownNow();
+            }
             if (outgoing != null) {
                 try {
                     outgoing.flush();
@@ -0,0 +1,171 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Round trips of send_string/recv_string against an echo thread
+	standing in for the Java bridge, over a local TCP connection.
+	Reports the latency of one round trip and the MB/s moved, both
+	ways, for small requests and multi-MB responses.
+
+	    tcpxml-bench [rounds-scale]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <chrono>
+#include <thread>
+#include "TcpXML.h"
+
+/* Sends back every message it receives until the stream closes */
+
+static void echo( int fd )
+{
+	struct TcpRecvBuffer in;
+	in.pos = in.cnt = 0;
+	char *str;
+	while( recv_string( fd, in, str ) )
+	{
+	    int ok = send_string( fd, str ) >= 0;
+	    delete[] str;
+	    if( !ok )
+	        break;
+	}
+	close( fd );
+}
+
+/* A connected pair of TCP sockets on the loopback interface */
+
+static int tcp_pair( int &client, int &server )
+{
+	int lfd = socket( AF_INET, SOCK_STREAM, 0 );
+	struct sockaddr_in addr;
+	memset( &addr, 0, sizeof( addr ) );
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	socklen_t len = sizeof( addr );
+	if( lfd < 0 || bind( lfd, (struct sockaddr *)&addr, len ) ||
+	    listen( lfd, 1 ) ||
+	    getsockname( lfd, (struct sockaddr *)&addr, &len ) )
+	    return 0;
+	client = socket( AF_INET, SOCK_STREAM, 0 );
+	if( client < 0 ||
+	    connect( client, (struct sockaddr *)&addr, sizeof( addr ) ) )
+	    return 0;
+	server = accept( lfd, NULL, NULL );
+	close( lfd );
+	if( server < 0 )
+	    return 0;
+
+	// As TcpXML::connect_server sets it
+	int on = 1;
+	setsockopt( client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof( on ) );
+	setsockopt( server, IPPROTO_TCP, TCP_NODELAY, &on, sizeof( on ) );
+	return 1;
+}
+
+/* A message of size bytes, starting with '<' as the bridge's do */
+
+static char *message( size_t size )
+{
+	char *msg = new char[size + 1];
+	memset( msg, 'x', size );
+	msg[0] = '<';
+	msg[size] = '\0';
+	return msg;
+}
+
+static int run( int fd, struct TcpRecvBuffer &in, size_t size, int rounds )
+{
+	char *msg = message( size );
+	char *str;
+
+	// One round to warm up the connection
+	if( send_string( fd, msg ) < 0 || !recv_string( fd, in, str ) )
+	    return 0;
+	delete[] str;
+
+	double worst = 0.0;
+	auto start = std::chrono::steady_clock::now();
+	for( int i = 0; i < rounds; i++ )
+	{
+	    auto sent = std::chrono::steady_clock::now();
+	    if( send_string( fd, msg ) < 0 || !recv_string( fd, in, str ) )
+	        return 0;
+	    double secs = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - sent ).count();
+	    if( secs > worst )
+	        worst = secs;
+	    if( strcmp( str, msg ) )
+	    {
+	        fprintf( stderr, "Echo of %lu bytes differs\n",
+				(unsigned long)size );
+	        return 0;
+	    }
+	    delete[] str;
+	}
+	double secs = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start ).count();
+	delete[] msg;
+
+	double mb = 2.0 * size * rounds / ( 1024.0 * 1024.0 );
+	printf( "%10lu %8d %12.1f %12.1f %10.1f\n", (unsigned long)size,
+		rounds, secs * 1e6 / rounds, worst * 1e6, mb / secs );
+	return 1;
+}
+
+int main( int argc, char **argv )
+{
+	int scale = argc > 1 ? atoi( argv[1] ) : 1;
+	if( scale < 1 )
+	    scale = 1;
+
+	signal( SIGPIPE, SIG_IGN );
+	int client, server;
+	if( !tcp_pair( client, server ) )
+	{
+	    perror( "tcp_pair" );
+	    return 1;
+	}
+	std::thread echoer( echo, server );
+
+	struct TcpRecvBuffer in;
+	in.pos = in.cnt = 0;
+	static const struct { size_t size; int rounds; } runs[] = {
+	    { 64, 20000 },
+	    { 1024, 20000 },
+	    { 16 * 1024, 5000 },
+	    { 1024 * 1024, 200 },
+	    { 8 * 1024 * 1024, 20 },
+	};
+	printf( "%10s %8s %12s %12s %10s\n",
+		"bytes", "rounds", "avg usec", "max usec", "MB/s" );
+	int ok = 1;
+	for( size_t i = 0; ok && i < sizeof( runs ) / sizeof( runs[0] ); i++ )
+	    ok = run( client, in, runs[i].size, runs[i].rounds * scale );
+
+	close( client );
+	echoer.join();
+	return ok ? 0 : 1;
+}
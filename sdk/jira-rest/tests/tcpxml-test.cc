@@ -0,0 +1,149 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Response framing of TcpXML: pipelined responses are written by the
+	bridge as they complete, so one read can hold several of them or
+	end part way through the length of the next.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+extern "C" {
+#include "dtg-utils.h"
+}
+#include "TcpXML.h"
+
+class TestXML : public TcpXML {
+	public:
+	    void use( int fd ) { sfd = fd; };
+};
+
+static int failures = 0;
+
+static void check( int ok, const char *what )
+{
+	if( !ok )
+	{
+	    fprintf( stderr, "FAIL: %s\n", what );
+	    failures++;
+	}
+}
+
+/* A framed <RESPONSE> carrying one STRING */
+
+static char *framed( long id, const char *value )
+{
+	char head[64];
+	sprintf( head, "<RESPONSE REQID=\"%ld\"><STRINGS><STRING VALUE=\"", id );
+	const char *tail = "\" /></STRINGS></RESPONSE>";
+	size_t len = strlen( head ) + strlen( value ) + strlen( tail );
+	char *msg = new char[len + 32];
+	sprintf( msg, "%lu%s%s%s", (unsigned long)len, head, value, tail );
+	return msg;
+}
+
+static void put( int fd, const char *data, size_t len )
+{
+	while( len )
+	{
+	    ssize_t n = write( fd, data, len );
+	    if( n <= 0 )
+	        return;
+	    data += n;
+	    len -= n;
+	}
+}
+
+static void expect( TestXML &x, long id, const char *value, const char *what )
+{
+	int ok = x.receive();
+	check( ok, what );
+	check( x.reqid == id, what );
+	check( ok && x.strings && x.strings->value &&
+		!strcmp( x.strings->value, value ), what );
+}
+
+int main()
+{
+	int fds[2];
+	if( socketpair( AF_UNIX, SOCK_STREAM, 0, fds ) )
+	{
+	    perror( "socketpair" );
+	    return 1;
+	}
+	// A lost response fails the test rather than hanging or killing it
+	signal( SIGPIPE, SIG_IGN );
+	struct timeval tv;
+	tv.tv_sec = 5;
+	tv.tv_usec = 0;
+	setsockopt( fds[0], SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof( tv ) );
+	TestXML x;
+	x.use( fds[0] );
+
+	// Two responses in one write
+	char *a = framed( 1, "first" );
+	char *b = framed( 2, "second" );
+	char *both = new char[strlen( a ) + strlen( b ) + 1];
+	sprintf( both, "%s%s", a, b );
+	put( fds[1], both, strlen( both ) );
+	expect( x, 1, "first", "first of two in one read" );
+	expect( x, 2, "second", "second of two in one read" );
+
+	// The next response split inside its length
+	char *c = framed( 3, "third" );
+	char *d = framed( 4, "fourth" );
+	put( fds[1], c, strlen( c ) );
+	put( fds[1], d, 1 );
+	expect( x, 3, "third", "response followed by a partial length" );
+	put( fds[1], d + 1, strlen( d ) - 1 );
+	expect( x, 4, "fourth", "response completing a partial length" );
+
+	// A response larger than the receive buffer, then a small one
+	size_t big_len = 3 * sizeof( ((TcpRecvBuffer *)0)->data );
+	char *value = new char[big_len + 1];
+	memset( value, 'x', big_len );
+	value[big_len] = '\0';
+	char *e = framed( 5, value );
+	char *f = framed( 6, "sixth" );
+	put( fds[1], e, strlen( e ) );
+	put( fds[1], f, strlen( f ) );
+	expect( x, 5, value, "response larger than the buffer" );
+	expect( x, 6, "sixth", "response after a large one" );
+
+	// Closing the stream fails the receive
+	close( fds[1] );
+	check( !x.receive() && !x.opened(), "closed stream" );
+
+	delete[] a;
+	delete[] b;
+	delete[] both;
+	delete[] c;
+	delete[] d;
+	delete[] value;
+	delete[] e;
+	delete[] f;
+	if( failures )
+	    return 1;
+	printf( "tcpxml-test: all passed\n" );
+	return 0;
+}
@@ -95,6 +95,10 @@ class MyDTGProj {
 						const char *exclude_user,
 	                                        struct DTGError *error );
 	MyDTGDefect *get_defect( const char *defect, struct DTGError *error );
+	int get_defects( struct DTGStrList *defects, void **results,
+					struct DTGError *error );
+	int save_defects( int cnt, void **defects, char **ids,
+					struct DTGError *errors );
 	MyDTGDefect *new_defect( struct DTGError *error );
 };
 
@@ -111,6 +115,10 @@ class MyDTGDefect {
 	MyDTGDefect( MyDTGProj *proj, 
 			const char *defect, 
 			struct DTGError *error );
+	MyDTGDefect( MyDTGProj *proj, 
+			const char *defect, 
+			struct DTGField *fields,
+			struct DTGError *error );
 	~MyDTGDefect();
 
 	static MyDTGDefect *convert( void *obj )
@@ -127,6 +135,7 @@ class MyDTGDefect {
 	void set_field( const char *field, const char *value,
 	                struct DTGError *error );
 	char *save( struct DTGError *error );
+	const char *job_name();
 };
 
 #endif
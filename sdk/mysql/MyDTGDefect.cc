@@ -68,6 +68,28 @@ MyDTGDefect::MyDTGDefect( MyDTGProj *proj,
 	clear_DTGError( error );
 }
 
+/* Takes ownership of fields already fetched by MyDTS::get_defects */
+
+MyDTGDefect::MyDTGDefect( MyDTGProj *proj, 
+	                const char *in_defect, 
+	                struct DTGField *in_fields,
+	                struct DTGError *error  )
+{
+	magic = MyDTGMagic;
+	in_proj = proj;
+	fields = in_fields;
+	defect = mk_string( in_defect );
+	dirty = 0;
+	testing = 0;
+	if( !proj || !defect || !fields )
+	{
+	    set_DTGError( error, 
+			"MyDTGDefect::MyDTGDefect: Undefined arguments");
+	    return;
+	}
+	clear_DTGError( error );
+}
+
 MyDTGDefect::~MyDTGDefect()
 {
 	if( fields )
@@ -192,15 +214,7 @@ char *MyDTGDefect::save( DTGError *error )
 	if( dirty )
 	{
 	    // Check for required fields.
-	    int has_job = 0;
-	    struct DTGField *f = NULL;
-	    for( f = fields; f; f = f->next )
-	        if( !strcmp( f->name, "job" ) )
-	        {
-	            has_job = 1;
-	            break;
-	        }
-	    if( !has_job )
+	    if( !job_name() )
 	    {
 	        set_DTGError( error, "Missing the required \"job\" field!" );
 	        error->can_continue = 0;
@@ -223,11 +237,15 @@ char *MyDTGDefect::save( DTGError *error )
 	        dirty = 0;
 	}
 
-	char* jobname = NULL;
-	struct DTGField *f;
-	for( f = fields; f; f = f->next )
+	const char *jobname = job_name();
+	return jobname ? strdup( jobname ) : NULL;
+}
+
+const char *MyDTGDefect::job_name()
+{
+	const char *jobname = NULL;
+	for( struct DTGField *f = fields; f; f = f->next )
 	    if( !strcmp( f->name, "job" ) )
 	        jobname = f->value;
-
-	return jobname ? strdup( jobname ) : NULL;
+	return jobname;
 }
@@ -16,6 +16,7 @@
 *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -122,6 +123,163 @@ MyDTGDefect *MyDTGProj::get_defect( const char *defect, struct DTGError *error )
 	return item;
 }
 
+int MyDTGProj::get_defects( struct DTGStrList *defects, void **results,
+					struct DTGError *error )
+{
+	int cnt = 0;
+	for( struct DTGStrList *d = defects; d; d = d->next )
+	    results[cnt++] = NULL;
+	clear_DTGError( error );
+	if( testing || !cnt )
+	    return 0;
+
+	struct DTGField **rows = new struct DTGField *[cnt];
+	memset( rows, 0, sizeof(struct DTGField *) * cnt );
+	char *err = NULL;
+	in_dt->dts->get_defects( defects, rows, err );
+	if( err )
+	{
+	    set_DTGError( error, err );
+	    error->can_continue = in_dt->dts->is_valid();
+	    delete[] err;
+	    for( int i = 0; i < cnt; i++ )
+	        delete_DTGField( rows[i] );
+	    delete[] rows;
+	    return 0;
+	}
+
+	int loaded = 0;
+	struct DTGStrList *d = defects;
+	for( int i = 0; i < cnt; i++, d = d->next )
+	    if( rows[i] )
+	    {
+	        results[i] = new MyDTGDefect( this, d->value, rows[i], error );
+	        loaded++;
+	    }
+	clear_DTGError( error );
+	delete[] rows;
+	return loaded;
+}
+
+/*
+	Saves the defects in one transaction, new jobs sharing their fields
+	with a single INSERT, undoing any defect which fails alone. If the
+	commit fails none are saved, so each is given the error and left
+	dirty.
+*/
+
+int MyDTGProj::save_defects( int cnt, void **defects, char **ids,
+					struct DTGError *errors )
+{
+	MyDTS *dts = in_dt->dts;
+	char *err = NULL;
+	int batch = !testing && dts->begin_batch( err );
+	if( err )
+	{
+	    // Saved one at a time
+	    delete[] err;
+	    err = NULL;
+	}
+
+	int i;
+	int added = 0;
+	MyDTGDefect **news = new MyDTGDefect *[cnt];
+	struct DTGField **rows = new struct DTGField *[cnt];
+	for( i = 0; batch && i < cnt; i++ )
+	{
+	    MyDTGDefect *defect = MyDTGDefect::convert( defects[i] );
+	    if( defect && defect->dirty && defect->fields && 
+		defect->defect && !strcmp( defect->defect, "new" ) &&
+		defect->job_name() )
+	    {
+	        news[added] = defect;
+	        rows[added++] = defect->fields;
+	    }
+	}
+	if( added > 1 )
+	{
+	    dts->mark_batch( err );
+	    if( !err && dts->insert_jobs( rows, added, err ) )
+	        for( i = 0; i < added; i++ )
+	            news[i]->dirty = 0;
+	    else if( err )
+	    {
+	        // Saved one at a time to find the failing job
+	        delete[] err;
+	        err = NULL;
+	        dts->undo_batch( err );
+	        if( err )
+	            delete[] err;
+	        err = NULL;
+	    }
+	}
+	delete[] news;
+	delete[] rows;
+
+	int saved = 0;
+	for( i = 0; i < cnt; i++ )
+	{
+	    ids[i] = NULL;
+	    MyDTGDefect *defect = MyDTGDefect::convert( defects[i] );
+	    if( !defect )
+	    {
+	        set_DTGError( &errors[i], "proj_save_defects: Unknown defectID" );
+	        continue;
+	    }
+	    if( batch && defect->dirty )
+	        dts->mark_batch( err );
+	    if( err )
+	    {
+	        set_DTGError( &errors[i], err );
+	        errors[i].can_continue = dts->is_valid();
+	        delete[] err;
+	        err = NULL;
+	        continue;
+	    }
+	    ids[i] = defect->save( &errors[i] );
+	    if( !errors[i].message )
+	    {
+	        saved++;
+	        continue;
+	    }
+	    if( batch )
+	    {
+	        dts->undo_batch( err );
+	        if( err )
+	            delete[] err;
+	        err = NULL;
+	    }
+	    if( !errors[i].can_continue )
+	        break;
+	}
+	for( int j = i + 1; j < cnt; j++ )
+	{
+	    ids[j] = NULL;
+	    set_DTGError( &errors[j], errors[i].message );
+	    errors[j].can_continue = 0;
+	}
+
+	if( batch && !dts->end_batch( err ) )
+	{
+	    for( i = 0; i < cnt; i++ )
+	    {
+	        if( errors[i].message )
+	            continue;
+	        set_DTGError( &errors[i], err );
+	        errors[i].can_continue = dts->is_valid();
+	        if( ids[i] )
+	            free( ids[i] );
+	        ids[i] = NULL;
+	        MyDTGDefect *defect = MyDTGDefect::convert( defects[i] );
+	        if( defect )
+	            defect->dirty = 1;
+	    }
+	    delete[] err;
+	    saved = 0;
+	}
+	return saved;
+}
+
 MyDTGDefect *MyDTGProj::new_defect( struct DTGError *error )
 {
 	MyDTGDefect *item = new MyDTGDefect( this, "new", error );
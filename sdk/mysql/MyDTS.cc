@@ -197,6 +197,28 @@ int MyDTS::no_privs( char *&err )
 	return 0;
 }
 
+/*
+	The client library is set up once as the plug-in loads, before any
+	thread can connect. Threads other than the one a connection was
+	made on set up their own state with thread_begin().
+*/
+
+static class MySQLLibrary {
+	public:
+	    MySQLLibrary() { mysql_library_init( 0, NULL, NULL ); };
+	    ~MySQLLibrary() { mysql_library_end(); };
+} mysql_library;
+
+void MyDTS::thread_begin()
+{
+	mysql_thread_init();
+}
+
+void MyDTS::thread_end()
+{
+	mysql_thread_end();
+}
+
 MyDTS::MyDTS( const char *server, 
 		const char *user, 
 		const char *pass,
@@ -542,6 +564,75 @@ struct DTGField *MyDTS::get_defect( const char *defect, char *&err )
 	return result;
 }
 
+/*
+	Retrieves several jobs with a single query, results[i] being set
+	for ids[i] when found. Jobs not returned are left NULL for the caller
+	to load individually.
+*/
+
+int MyDTS::get_defects( struct DTGStrList *ids, struct DTGField **results,
+							char *&err )
+{
+	char *in = NULL;
+	for( struct DTGStrList *id = ids; id; id = id->next )
+	{
+	    char *qdefect = esc_field( id->value );
+	    char *tmp = in ? mk_string( in, ", '", qdefect, "'" ) 
+			   : mk_string( "'", qdefect, "'" );
+	    free( qdefect );
+	    delete[] in;
+	    in = tmp;
+	}
+	if( !in )
+	    return 0;
+	char *query = 
+		mk_string( "SELECT * from jobs where _job IN ( ", in, " )" );
+	delete[] in;
+
+	if( mysql_query( mysql, query ) )
+	{
+	    err = mk_string( "Failed to retrieve data: ",
+	                     mysql_error( mysql ) );
+	    delete[] query;
+	    return 0;
+	}
+	delete[] query;
+	MYSQL_RES *res = mysql_store_result( mysql );
+	if( !res )
+	    return 0;
+
+	int found = 0;
+	unsigned int f = mysql_num_fields( res );
+	MYSQL_FIELD *cols = mysql_fetch_fields( res );
+	unsigned int key;
+	for( key = 0; key < f && strcmp( cols[key].name, "_job" ); key++ );
+	MYSQL_ROW row;
+	while( key < f && ( row = mysql_fetch_row( res ) ) )
+	{
+	    int i = 0;
+	    struct DTGStrList *id;
+	    for( id = ids; id; id = id->next, i++ )
+	        if( !results[i] && row[key] && !strcmp( id->value, row[key] ) )
+	            break;
+	    if( !id )
+	        continue;
+
+	    DTGField *fields = NULL;
+	    for( unsigned int c = 0; c < f; c++ )
+	    {
+	        if( row[c] == NULL )
+	            continue;
+	        fields = append_DTGField( fields,
+	                                    new_DTGField( cols[c].name, row[c] )
+	                                );
+	    }
+	    results[i] = fields;
+	    found++;
+	}
+	mysql_free_result( res );
+	return found;
+}
+
 char *
 MyDTS::save_defect( const char *defect, struct DTGField *fields, char *&err )
 {
@@ -653,3 +744,118 @@ MyDTS::save_defect( const char *defect, struct DTGField *fields, char *&err )
 	free( real_defect );
 	return cp_string( defect );
 }
+
+/*
+	Saves from MyDTGProj::save_defects() run in one transaction, each
+	defect under a savepoint so a failed one can be undone alone.
+*/
+
+int
+MyDTS::begin_batch( char *&err )
+{
+	if( !connected( err ) )
+	    return 0;
+	if( mysql_query( mysql, "START TRANSACTION" ) )
+	{
+	    err = mk_string( "begin_batch failed: ", mysql_error( mysql ) );
+	    return 0;
+	}
+	return 1;
+}
+
+void
+MyDTS::mark_batch( char *&err )
+{
+	if( mysql_query( mysql, "SAVEPOINT dtg_save" ) )
+	    err = mk_string( "mark_batch failed: ", mysql_error( mysql ) );
+}
+
+void
+MyDTS::undo_batch( char *&err )
+{
+	if( mysql_query( mysql, "ROLLBACK TO SAVEPOINT dtg_save" ) )
+	    err = mk_string( "undo_batch failed: ", mysql_error( mysql ) );
+}
+
+int
+MyDTS::end_batch( char *&err )
+{
+	if( mysql_query( mysql, "COMMIT" ) )
+	{
+	    err = mk_string( "end_batch failed: ", mysql_error( mysql ) );
+	    (void)mysql_query( mysql, "ROLLBACK" );
+	    return 0;
+	}
+	return 1;
+}
+
+/*
+	Insert several new jobs with a single statement. Returns 0 without
+	an error when the jobs do not all have the same fields, leaving them
+	to be saved one at a time.
+*/
+
+int
+MyDTS::insert_jobs( struct DTGField **rows, int cnt, char *&err )
+{
+	if( cnt < 2 || !rows[0] )
+	    return 0;
+	for( int i = 1; i < cnt; i++ )
+	{
+	    struct DTGField *a = rows[0];
+	    struct DTGField *b = rows[i];
+	    for( ; a && b && !strcmp( a->name, b->name ); a = a->next, b = b->next );
+	    if( a || b )
+	        return 0;
+	}
+
+	struct DTGStrList *fs = NULL;
+	struct DTGStrList *vs = NULL;
+	for( struct DTGField *f = rows[0]; f; f = f->next )
+	{
+	    char* qname = esc_field( f->name );
+	    char *tmp = mk_string( "`", qname, "`" );
+	    fs = append_DTGStrList( fs, tmp );
+	    delete[] tmp;
+	    free( qname );
+	}
+	for( int i = 0; i < cnt; i++ )
+	{
+	    struct DTGStrList *ff = NULL;
+	    for( struct DTGField *f = rows[i]; f; f = f->next )
+	    {
+	        char* qvalue = esc_field( f->value );
+	        char *tmp = mk_string( "\'", qvalue, "\'" );
+	        ff = append_DTGStrList( ff, tmp );
+	        delete[] tmp;
+	        free( qvalue );
+	    }
+	    char *vals = join_DTGStrList( ff, ", " );
+	    delete_DTGStrList( ff );
+	    char *tmp = mk_string( "( ", vals, " )" );
+	    vs = append_DTGStrList( vs, tmp );
+	    delete[] tmp;
+	    free( vals );
+	}
+
+	char *sets = join_DTGStrList( fs, ", " );
+	char *values = join_DTGStrList( vs, ", " );
+	delete_DTGStrList( fs );
+	delete_DTGStrList( vs );
+	char *query = mk_string( "INSERT INTO jobs ( ", sets,
+				" ) VALUES ", values );
+	free( sets );
+	free( values );
+
+	if( !mysql_query( mysql, query ) )
+	{
+	    int rows_in = mysql_affected_rows( mysql );
+	    if( rows_in != cnt )
+	        err = mk_string( "INSERT failed:", query );
+	}
+	else
+	    err = mk_string( "insert_jobs failed: \"", query, "\", ",
+	                     mysql_error( mysql ) );
+	delete[] query;
+	return !err;
+}
@@ -65,6 +65,9 @@ class MyDTS {
 		char *&err);
 	    virtual ~MyDTS();
 
+	    static void thread_begin();
+	    static void thread_end();
+
 	    int is_valid() { return valid; };
 	    int valid_project( const char *proj );
 	    int utf8_ok() { return utf8; };
@@ -81,8 +84,15 @@ class MyDTS {
 		const char *exclude_user, const char *mod_by_field,
 		char *&err );
 	    struct DTGField *get_defect( const char *defect, char *&err );
+	    int get_defects( struct DTGStrList *ids, struct DTGField **results,
+							char *&err );
 	    char *save_defect( const char *defect,
 				struct DTGField *fields, char *&err );
+	    int insert_jobs( struct DTGField **rows, int cnt, char *&err );
+	    int begin_batch( char *&err );
+	    void mark_batch( char *&err );
+	    void undo_batch( char *&err );
+	    int end_batch( char *&err );
 };
 
 #endif
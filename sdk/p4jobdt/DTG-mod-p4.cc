@@ -24,6 +24,7 @@ extern "C" {
 #include <dtg-utils.h>
 }
 #include "MyDTG.h"
+#include "MyDTS.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -174,6 +175,24 @@ void dt_free( void *dtID, struct DTGError *error )
 	return;
 }
 
+DL_EXPORT_FTN
+void dt_thread_begin()
+{
+#ifdef DEBUG
+	fprintf( useLog(), "dt_thread_begin()\n" );
+#endif
+	MyDTS::thread_begin();
+}
+
+DL_EXPORT_FTN
+void dt_thread_end()
+{
+#ifdef DEBUG
+	fprintf( useLog(), "dt_thread_end()\n" );
+#endif
+	MyDTS::thread_end();
+}
+
 DL_EXPORT_FTN
 const char *dt_get_server_version( void *dtID, struct DTGError *error )
 {
@@ -334,6 +353,67 @@ struct DTGStrList *proj_list_changed_defects( void *projID,
 			mod_date_field, mod_by_field, exclude_user, error );
 }
 
+DL_EXPORT_FTN
+void *proj_open_changed_defects( void *projID,
+					int page_size,
+					struct DTGDate *since,
+					const char *mod_date_field,
+					const char *mod_by_field,
+					const char *exclude_user,
+					struct DTGError *error )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "proj_open_changed_defects(%d,%s,%s,%s)\n",
+		page_size, mod_date_field, mod_by_field, exclude_user );
+	fflush( useLog() );
+#endif
+	MyDTGProj *mydtproj = MyDTGProj::convert( projID );
+	if( !mydtproj )
+	{
+	    set_DTGError( error, "proj_open_changed_defects:Unknown projID" );
+	    return NULL;
+	}
+
+	return mydtproj->open_changed_defects( page_size, since, 
+			mod_date_field, mod_by_field, exclude_user, error );
+}
+
+DL_EXPORT_FTN
+struct DTGStrList *cursor_next_defects( void *cursorID, 
+					struct DTGError *error )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "cursor_next_defects()\n" );
+	fflush( useLog() );
+#endif
+	MyDTGCursor *mycursor = MyDTGCursor::convert( cursorID );
+	if( !mycursor )
+	{
+	    set_DTGError( error, "cursor_next_defects: Unknown cursorID" );
+	    return NULL;
+	}
+
+	return mycursor->next_page( error );
+}
+
+DL_EXPORT_FTN
+void cursor_free( void *cursorID, struct DTGError *error )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "cursor_free()\n" );
+	fflush( useLog() );
+#endif
+	MyDTGCursor *mycursor = MyDTGCursor::convert( cursorID );
+	if( !mycursor )
+	{
+	    set_DTGError( error, "cursor_free: Unknown cursorID" );
+	    return;
+	}
+
+	delete mycursor;
+	clear_DTGError( error );
+}
+
 DL_EXPORT_FTN
 void proj_referenced_fields( void *projID, struct DTGStrList *fields )
 {
@@ -380,6 +460,23 @@ void *proj_get_defect( void *projID, const char *defect, struct DTGError *error
 	return mydtproj->get_defect( defect, error );
 }
 
+DL_EXPORT_FTN
+int proj_get_defects( void *projID, struct DTGStrList *defects, 
+			void **defectIDs, struct DTGError *error )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "proj_get_defects()\n" );
+#endif
+	MyDTGProj *mydtproj = MyDTGProj::convert( projID );
+	if( !mydtproj )
+	{
+	    set_DTGError( error, "proj_get_defects: Unknown projID" );
+	    return 0;
+	}
+
+	return mydtproj->get_defects( defects, defectIDs, error );
+}
+
 DL_EXPORT_FTN
 void *proj_new_defect( void *projID, struct DTGError *error )
 {
@@ -502,6 +599,25 @@ void *proj_find_defects( void *projID,
 	return mydtproj->find_defects( max_rows, qual, error );
 }
 
+DL_EXPORT_FTN
+struct DTGField *proj_find_defect_values( void *projID, 
+			const char *qual, 
+			const char *field,
+			struct DTGError *error )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "proj_find_defect_values(%s,%s)\n", qual, field );
+#endif
+	MyDTGProj *mydtproj = MyDTGProj::convert( projID );
+	if( !mydtproj )
+	{
+	    set_DTGError( error, "proj_find_defect_values: Unknown projID" );
+	    return NULL;
+	}
+
+	return mydtproj->find_defect_values( qual, field, error );
+}
+
 DL_EXPORT_FTN
 struct DTGStrList *proj_list_fixes( void *projID, 
 				const char *defect,
@@ -537,6 +653,23 @@ struct DTGFixDesc *proj_describe_fix( void *projID, const char *fixid,
 	return mydtproj->describe_fix( fixid, error );
 }
 
+DL_EXPORT_FTN
+int proj_describe_fixes( void *projID, struct DTGStrList *fixids, 
+			struct DTGFixDesc **fixes, struct DTGError *error )
+{
+#ifdef DEBUG
+	fprintf( useLog(), "proj_describe_fixes()\n" );
+#endif
+	MyDTGProj *mydtproj = MyDTGProj::convert( projID );
+	if( !mydtproj )
+	{
+	    set_DTGError( error, "proj_describe_fixes: Unknown projID" );
+	    return 0;
+	}
+
+	return mydtproj->describe_fixes( fixids, fixes, error );
+}
+
 
 DL_EXPORT_FTN
 void free_char( char *obj )
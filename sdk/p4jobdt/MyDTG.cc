@@ -27,6 +27,7 @@ extern "C" {
 #include <dtg-utils.h>
 }
 #include <dtg-str.h>
+#include "p4charcvt.h"
 
 const char *MyDTG::MyDTGMagic = "MyDTGClass";
 
@@ -38,6 +39,7 @@ MyDTG::MyDTG( const char *server, const char *user, const char *pass,
 	cur_message_level = 10; // None
 	server_version = NULL;
 	charset = NULL;
+	cvt = NULL;
 	sub_missing = 0;
 	gen_jobname = 0;
 	mapid = NULL;
@@ -90,6 +92,8 @@ MyDTG::MyDTG( const char *server, const char *user, const char *pass,
 	    delete_DTGStrList ( msg );
 	    cur_message_level = 2;
 	}
+	if( charset )
+	    cvt = new P4CharCvt( charset );
 }
 
 MyDTG::~MyDTG()
@@ -102,6 +106,8 @@ MyDTG::~MyDTG()
 	    delete dts;
 	if( charset )
 	    delete[] charset;
+	if( cvt )
+	    delete cvt;
 	if( mapid )
 	    delete[] mapid;
 }
@@ -211,6 +217,15 @@ struct DTGAttribute *MyDTG::list_attrs()
 		"specified for the replication map.",
 		"10",
 		0 ) );
+	in_field = append_DTGAttribute( in_field, new_DTGAttribute(
+		"fix_index_max",
+		"Fix index limit",
+		"Specifies the most fixes the plug-in reads with a single "
+		"'p4 fixes' when a replication cycle looks up the fixes of "
+		"many jobs. A server with more fixes than this is queried one "
+		"job at a time. Use 0 to always query one job at a time.",
+		"100000",
+		0 ) );
 
 	return in_field;
 }
@@ -302,6 +317,15 @@ char *MyDTG::validate_attr( const struct DTGField *attr )
 	        return strdup( "Wait time: Must be a positive integer,"
 	                       " or -1." );
 
+	if( !strcmp( attr->name, "fix_index_max" ) )
+	{
+	    if( attr->value && is_number( attr->value ) && 
+		atoi( attr->value ) >= 0 )
+	        return NULL;
+	    return strdup( "Fix index limit: Must be 0 or a positive "
+	                   "integer." );
+	}
+
 	char *tmp = (char *)malloc( 20 + strlen( attr->name) );
 	sprintf( tmp, "Unknown attribute: %s", attr->name );
 	return tmp;
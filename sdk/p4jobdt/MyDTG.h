@@ -27,6 +27,8 @@ class MyDTS;
 class MyDTGProj;
 class MyDTGDefect;
 class MyDTGFixDesc;
+class MyDTGCursor;
+class P4CharCvt;
 
 class StrDict;
 
@@ -40,6 +42,7 @@ class MyDTG {
 	char *cur_message;
 	int cur_message_level;
 	char *charset;
+	P4CharCvt *cvt;	// set with charset
 	int sub_missing;
 	int gen_jobname;
 	char *mapid;
@@ -104,7 +107,15 @@ class MyDTGProj {
 						const char *mod_by_field,
 						const char *exclude_user,
 	                                        struct DTGError *error );
+	MyDTGCursor *open_changed_defects( int page_size,
+						struct DTGDate *since,
+						const char *mod_date_field,
+						const char *mod_by_field,
+						const char *exclude_user,
+						struct DTGError *error );
 	MyDTGDefect *get_defect( const char *defect, struct DTGError *error );
+	int get_defects( struct DTGStrList *defects, void **results,
+					struct DTGError *error );
 	MyDTGDefect *new_defect( struct DTGError *error );
 
 	void referenced_fields( struct DTGStrList *fields );
@@ -115,9 +126,15 @@ class MyDTGProj {
 					struct DTGError *error );
 	struct DTGFixDesc *describe_fix( const char *fixid, 
 					struct DTGError *error );
+	int describe_fixes( struct DTGStrList *fixids, 
+					struct DTGFixDesc **fixes,
+					struct DTGError *error );
 	struct DTGStrList *find_defects( int limit, 
 					const char *qual, 
 					struct DTGError *error );
+	struct DTGField *find_defect_values( const char *qual, 
+					const char *field,
+					struct DTGError *error );
 	int is_fix_pending( const char *fixid, struct DTGError *error );
 	char *translate( const char *str, int sm, char *&err, 
 			int rev = 0, int cpp = 1 );
@@ -148,6 +165,10 @@ class MyDTGDefect {
 	MyDTGDefect( MyDTGProj *proj, 
 			const char *defect, 
 			struct DTGError *error );
+	MyDTGDefect( MyDTGProj *proj, 
+			const char *defect, 
+			StrDict *fields,
+			struct DTGError *error );
 	~MyDTGDefect();
 
 	static MyDTGDefect *convert( void *obj )
@@ -165,6 +186,38 @@ class MyDTGDefect {
 	                struct DTGError *error );
 	char *save( struct DTGError *error );
 	void set_jobid();
+	void translate_fields( struct DTGError *error );
+};
+
+class MyDTGCursor {
+    public:
+	static const char *MyDTGMagic;
+	const char *magic;
+	MyDTGProj *in_proj;
+	struct DTGDate *since;
+	int page_size;
+	char *mod_date_field;	// in the server's character set
+	char *mod_by_field;
+	char *exclude_user;
+	char *filters;
+	char *last;		// last job returned, as the server names it
+	int done;
+
+	MyDTGCursor( MyDTGProj *proj, int page_size, struct DTGDate *since,
+			const char *mod_date_field, const char *mod_by_field,
+			const char *exclude_user );
+	~MyDTGCursor();
+
+	static MyDTGCursor *convert( void *obj )
+	{
+	    MyDTGCursor *me = (MyDTGCursor *)obj;
+	    if( me && me->magic == MyDTGMagic )
+	        return me;
+	    else
+	        return NULL;
+	};
+
+	struct DTGStrList *next_page( struct DTGError *error );
 };
 
 #endif
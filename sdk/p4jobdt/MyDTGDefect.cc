@@ -72,7 +72,36 @@ MyDTGDefect::MyDTGDefect( MyDTGProj *proj,
 	}
 
 	clear_DTGError( error );
+	translate_fields( error );
+}
+
+/* Takes ownership of a job form already fetched by MyDTS::get_defects */
+
+MyDTGDefect::MyDTGDefect( MyDTGProj *proj, 
+	                const char *in_defect, 
+	                StrDict *in_fields,
+	                struct DTGError *error  )
+{
+	magic = MyDTGMagic;
+	in_proj = proj;
+	fields = in_fields;
+	defect = mk_string( in_defect );
+	translated = 0;
+	dirty = 0;
+	testing = 0;
+	if( !proj || !defect || !fields )
+	{
+	    set_DTGError( error, 
+			"MyDTGDefect::MyDTGDefect: Undefined arguments");
+	    return;
+	}
 
+	clear_DTGError( error );
+	translate_fields( error );
+}
+
+void MyDTGDefect::translate_fields( struct DTGError *error )
+{
 	if( in_proj->in_dt->charset )
 	{
 	    StrDict *f = fields;
@@ -60,14 +60,13 @@ char *MyDTGProj::translate( const char *str, int sm, char *&err,
 {
 	if( !str )
 	    return NULL;
+	if( !in_dt->cvt )
+	{
+	    err = cp_string( "Missing FROM/TO charset" );
+	    return NULL;
+	}
 
-	char *result;
-	if( rev )
-	    result = p4charcvt( "utf8", in_dt->charset, str, strlen( str ), 
-				sm, err );
-	else
-	    result = p4charcvt( in_dt->charset, "utf8", str, strlen( str ), 
-				sm, err );
+	char *result = in_dt->cvt->convert( rev, str, strlen( str ), sm, err );
 	if( !result || cpp )
 	    return result; // new/delete variant
 	char *tmp = strdup( result );
@@ -305,6 +304,113 @@ struct DTGStrList *MyDTGProj::list_changed_defects( int max_rows,
 	return list;
 }
 
+MyDTGCursor *MyDTGProj::open_changed_defects( int page_size,
+						struct DTGDate *since,
+						const char *mod_date_field,
+						const char *mod_by_field,
+						const char *exclude_user,
+						struct DTGError *error )
+{
+	clear_DTGError( error );
+	return new MyDTGCursor( this, page_size, since, 
+			mod_date_field, mod_by_field, exclude_user );
+}
+
+/*
+	Pages through the changed jobs in job name order, the order 'p4 jobs'
+	lists them in, each page starting after the last job returned. A job
+	saved meanwhile is at worst returned again.
+*/
+
+const char *MyDTGCursor::MyDTGMagic = "MyDTGCursorClass";
+
+MyDTGCursor::MyDTGCursor( MyDTGProj *proj, int size, struct DTGDate *date,
+			const char *mdf, const char *mbf, const char *eu )
+{
+	magic = MyDTGMagic;
+	in_proj = proj;
+	since = copy_DTGDate( date );
+	page_size = size > 0 ? size : 1;
+	if( proj->in_dt->charset )
+	{
+	    char *err = NULL;
+	    mod_date_field = proj->translate( mdf, 0, err, 1 );
+	    delete[] err; err = NULL; // Ignore errors
+	    mod_by_field = proj->translate( mbf, 0, err, 1 );
+	    delete[] err; err = NULL; // Ignore errors
+	    exclude_user = proj->translate( eu, 0, err, 1 );
+	    delete[] err; err = NULL; // Ignore errors
+	    filters = proj->translate( proj->seg_filters, 0, err, 1 );
+	    delete[] err; // Ignore errors
+	}
+	else
+	{
+	    mod_date_field = cp_string( mdf );
+	    mod_by_field = cp_string( mbf );
+	    exclude_user = cp_string( eu );
+	    filters = cp_string( proj->seg_filters );
+	}
+	last = cp_string( "" );
+	done = 0;
+}
+
+MyDTGCursor::~MyDTGCursor()
+{
+	magic = NULL;
+	delete_DTGDate( since );
+	delete[] mod_date_field;
+	delete[] mod_by_field;
+	delete[] exclude_user;
+	delete[] filters;
+	delete[] last;
+}
+
+struct DTGStrList *MyDTGCursor::next_page( struct DTGError *error )
+{
+	clear_DTGError( error );
+	if( done )
+	    return NULL;
+	if( in_proj->testing ) 
+	{
+	    done = 1;
+	    return new_DTGStrList( "*defect*" );
+	}
+
+	char *err = NULL;
+	struct DTGStrList *list = in_proj->in_dt->dts->list_jobs( page_size, 
+					since, mod_date_field,
+					exclude_user, mod_by_field,
+					filters, err, last );
+	if( err )
+	{
+	    set_DTGError( error, err );
+	    error->can_continue = in_proj->in_dt->dts->is_valid();
+	    delete[] err;
+	    delete_DTGStrList( list );
+	    return NULL;
+	}
+
+	int cnt = 0;
+	struct DTGStrList *l = list;
+	for( ; l && l->next; l = l->next, cnt++ );
+	if( l )
+	{
+	    // A page which does not move on would be listed forever
+	    if( !strcmp( l->value, last ) )
+	        done = 1;
+	    delete[] last;
+	    last = cp_string( l->value );
+	    cnt++;
+	}
+	if( cnt < page_size )
+	    done = 1;
+
+	if( in_proj->in_dt->charset )
+	    list = in_proj->translate( list, error );
+
+	return list;
+}
+
 MyDTGDefect *MyDTGProj::get_defect( const char *defect, struct DTGError *error )
 {
 	if( defect && *defect == '-' )
@@ -325,6 +431,69 @@ MyDTGDefect *MyDTGProj::get_defect( const char *defect, struct DTGError *error )
 	return item;
 }
 
+int MyDTGProj::get_defects( struct DTGStrList *defects, void **results,
+					struct DTGError *error )
+{
+	int cnt = 0;
+	for( struct DTGStrList *d = defects; d; d = d->next )
+	    results[cnt++] = NULL;
+	clear_DTGError( error );
+	if( testing || !cnt )
+	    return 0;
+
+	StrDict **forms = new StrDict *[cnt];
+	memset( forms, 0, sizeof(StrDict *) * cnt );
+	char *err = NULL;
+	if( in_dt->charset )
+	{
+	    struct DTGStrList *ids = 
+		translate( copy_DTGStrList( defects ), error, 1 );
+	    if( error->message )
+	    {
+	        // Leave these to be loaded one at a time
+	        clear_DTGError( error );
+	        delete[] forms;
+	        return 0;
+	    }
+	    in_dt->dts->get_defects( ids, forms, err );
+	    delete_DTGStrList( ids );
+	}
+	else
+	    in_dt->dts->get_defects( defects, forms, err );
+	if( err )
+	{
+	    set_DTGError( error, err );
+	    error->can_continue = in_dt->dts->is_valid();
+	    delete[] err;
+	    for( int i = 0; i < cnt; i++ )
+	        if( forms[i] )
+	            delete forms[i];
+	    delete[] forms;
+	    return 0;
+	}
+
+	int loaded = 0;
+	struct DTGError *tmp = new_DTGError( NULL );
+	struct DTGStrList *d = defects;
+	for( int i = 0; i < cnt; i++, d = d->next )
+	{
+	    if( !forms[i] )
+	        continue;
+	    MyDTGDefect *item = new MyDTGDefect( this, d->value, forms[i], tmp );
+	    if( tmp->message )
+	    {
+	        delete item;
+	        clear_DTGError( tmp );
+	        continue;
+	    }
+	    results[i] = item;
+	    loaded++;
+	}
+	delete_DTGError( tmp );
+	delete[] forms;
+	return loaded;
+}
+
 MyDTGDefect *MyDTGProj::new_defect( struct DTGError *error )
 {
 	MyDTGDefect *item = new MyDTGDefect( this, "new", error );
@@ -393,20 +562,8 @@ struct DTGStrList *MyDTGProj::list_fixes( const char *defect,
 	    return NULL;
 	}
 
-	struct DTGStrList *fix;
+	// Pending fixes are already left out
 	clear_DTGError( error );
-	for( fix = list; fix; fix = fix->next )
-	{
-	    if( is_fix_pending( fix->value, error ) )
-	        fix->value[0] = '\0';
-	    if( error->message )
-	    {
-	        delete_DTGStrList( list );
-	        return NULL;
-	    }
-	}
-	list = purge_DTGStrList( list );
-
 	return list;
 }
 
@@ -441,6 +598,43 @@ struct DTGFixDesc *MyDTGProj::describe_fix( const char *fixid,
 	return fix;
 }
 
+int MyDTGProj::describe_fixes( struct DTGStrList *fixids, 
+				struct DTGFixDesc **fixes,
+				struct DTGError *error )
+{
+	int cnt = 0;
+	for( struct DTGStrList *f = fixids; f; f = f->next )
+	    fixes[cnt++] = NULL;
+	clear_DTGError( error );
+	if( testing || !cnt )
+	    return 0;
+
+	char *err = NULL;
+	int found = in_dt->dts->describe_fixes( fixids, fixes, err );
+	if( err )
+	{
+	    set_DTGError( error, err );
+	    error->can_continue = in_dt->dts->is_valid();
+	    delete[] err;
+	    return 0;
+	}
+	if( !in_dt->charset )
+	    return found;
+
+	for( int i = 0; i < cnt; i++ )
+	    if( fixes[i] )
+	    {
+	        // On failure left for describe_fix to report
+	        fixes[i] = translate( fixes[i], error );
+	        if( !fixes[i] )
+	        {
+	            clear_DTGError( error );
+	            found--;
+	        }
+	    }
+	return found;
+}
+
 struct DTGStrList * MyDTGProj::find_defects( int limit, const char *qual, struct DTGError *error )
 {
 	struct DTGStrList *list;
@@ -472,6 +666,68 @@ struct DTGStrList * MyDTGProj::find_defects( int limit, const char *qual, struct
 	return list;
 }
 
+struct DTGField *MyDTGProj::find_defect_values( const char *qual, 
+					const char *field,
+					struct DTGError *error )
+{
+	struct DTGField *list;
+	if( testing ) 
+	{
+	    list = new_DTGField( "*defect*", "*value*" );
+	    clear_DTGError( error );
+	    return list;
+	}
+	char *err = NULL;
+	if( in_dt->charset )
+	{
+	    char *q = translate( qual, 0, err, 1 );
+	    delete[] err; err = NULL; // ignore err
+	    char *f = translate( field, 0, err, 1 );
+	    delete[] err; err = NULL; // ignore err
+	    list = in_dt->dts->list_job_values( q, f, err );
+	    delete[] q;
+	    delete[] f;
+	}
+	else
+	    list = in_dt->dts->list_job_values( qual, field, err );
+	if( err )
+	{
+	    set_DTGError( error, err );
+	    error->can_continue = in_dt->dts->is_valid();
+	    delete[] err;
+	    delete_DTGField( list );
+	    return NULL;
+	}
+	clear_DTGError( error );
+
+	if( in_dt->charset )
+	    for( struct DTGField *item = list; item; item = item->next )
+	    {
+	        char *tmp = item->name;
+	        item->name = translate( tmp, 0, err, 0, 0 );
+	        if( !item->name )
+	        {
+	            item->name = tmp;
+	            delete[] err; err = NULL; // keep untranslated
+	        }
+	        else
+	            free( tmp );
+	        if( !item->value )
+	            continue;
+	        tmp = item->value;
+	        item->value = translate( tmp, 0, err, 0, 0 );
+	        if( !item->value )
+	        {
+	            item->value = tmp;
+	            delete[] err; err = NULL; // keep untranslated
+	        }
+	        else
+	            free( tmp );
+	    }
+
+	return list;
+}
+
 void MyDTGProj::referenced_fields( struct DTGStrList *fields )
 {
 	char *tmp = join_DTGStrList( fields, ", " );
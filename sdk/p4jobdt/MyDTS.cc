@@ -16,6 +16,8 @@
 *    along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <ctype.h>
+#include <atomic>
 #include "MyDTS.h"
 #include <p4/strtable.h>
 #include <p4/i18napi.h>
@@ -25,6 +27,7 @@ extern "C" {
 }
 #include "dtg-str.h"
 #include "StrArr.h"
+#include <p4/vararray.h>
 
 struct DTGField *get_field( struct DTGField *fields, const char *id )
 {
@@ -46,6 +49,24 @@ const char *find_field( struct DTGField *fields, const char *id )
 	return fields ? fields->value : id;
 }
 
+/*
+	Worker threads of the replication engine using the plug-in. Each
+	has its own connection, so a listing made on another one does not
+	keep the forms of the jobs for them.
+*/
+
+static std::atomic<int> worker_threads( 0 );
+
+void MyDTS::thread_begin()
+{
+	worker_threads++;
+}
+
+void MyDTS::thread_end()
+{
+	worker_threads--;
+}
+
 MyDTS::MyDTS( const char *server, 
 		const char *user, 
 		const char *pass,
@@ -55,6 +76,12 @@ MyDTS::MyDTS( const char *server,
 		char *&err)
 {
 	server_id = NULL;
+	prefetched = NULL;
+	prefetch_size = 0;
+	fix_index = NULL;
+	fix_index_size = 0;
+	fix_lookups = 0;
+	fix_index_max = 0;
 	if( server )
 	    my_server = cp_string( server );
 	else
@@ -118,12 +145,21 @@ MyDTS::MyDTS( const char *server,
 	else
 	    wait_time = 10;
 
+	// Fixes read for the fix index
+	f = get_field( (DTGField*)attrs, "fix_index_max" );
+	if( f )
+	    fix_index_max = atoi( f->value );
+	else
+	    fix_index_max = 100000;
+
 	// Try connecting
 	valid = connected( err );
 }
 
 MyDTS::~MyDTS()
 {
+	clear_prefetched();
+	clear_fix_index();
 	if( server_id )
 	    delete[] server_id;
 	if( my_server )
@@ -350,11 +386,25 @@ struct DTGStrList *MyDTS::list_projects( char *&err )
 	return list;
 }
 
+/* Appends a job name to a jobview, its special characters escaped */
+
+static void jobview_value( StrBuf &view, const char *id )
+{
+	for( ; *id; id++ )
+	{
+	    if( !( *id & 0x80 ) && !isalnum( (unsigned char)*id ) && 
+		!strchr( "_-.", *id ) )
+	        view.Extend( '\\' );
+	    view.Extend( *id );
+	}
+	view.Terminate();
+}
+
 struct DTGStrList *MyDTS::list_jobs( int max_rows, 
 		struct DTGDate *since, const char *mod_date_field,
 		const char *exclude_user, const char *mod_by_field,
 	        const char *segment_filters,
-		char *&err )
+		char *&err, const char *after )
 {
 	// Build up qualifier
 	StrBuf qualifier;
@@ -374,63 +424,297 @@ struct DTGStrList *MyDTS::list_jobs( int max_rows,
 	}
 	if( segment_filters )
 	    qualifier << " & " << segment_filters;
-	return list_jobs( max_rows, qualifier.Text(), err );
+
+	// Worker threads read the jobs on connections of their own
+	int prefetch = !worker_threads.load();
+
+	// A new cycle: fixes may have changed since the last one
+	if( !after || !*after )
+	{
+	    clear_fix_index();
+	    return list_jobs( max_rows, qualifier.Text(), err, prefetch );
+	}
+
+	// The page of jobs named after the last one returned. The server
+	// compares names in the order it lists them.
+	StrBuf paged;
+	paged.Clear();
+	if( qualifier.Length() )
+	    paged << "(" << qualifier << ") & ";
+	paged << "Job>";
+	jobview_value( paged, after );
+	return list_jobs( max_rows, paged.Text(), err, prefetch );
 }
 
-struct DTGStrList *MyDTS::list_jobs( int max_rows,const char *qualifier, char *&err )
+/*
+	Forms kept from one listing for get_defect(), so a listing of every
+	changed job in force mode holds no more than this many.
+*/
+
+static const int PREFETCH_MAX = 1000;
+
+static unsigned int job_hash( const char *id )
+{
+	unsigned int h = 2166136261u;
+	for( ; *id; id++ )
+	    h = ( h ^ (unsigned char)*id ) * 16777619u;
+	return h;
+}
+
+void MyDTS::clear_prefetched()
+{
+	for( int i = 0; i < prefetch_size; i++ )
+	    while( prefetched[i] )
+	    {
+	        PrefetchedJob *item = prefetched[i];
+	        prefetched[i] = item->next;
+	        delete[] item->id;
+	        delete item->form;
+	        delete item;
+	    }
+	delete[] prefetched;
+	prefetched = NULL;
+	prefetch_size = 0;
+}
+
+void MyDTS::add_prefetched( const char *id, StrDict *form )
+{
+	PrefetchedJob *item = new PrefetchedJob;
+	unsigned int b = job_hash( id ) % prefetch_size;
+	item->id = cp_string( id );
+	item->form = form;
+	item->next = prefetched[b];
+	prefetched[b] = item;
+}
+
+/* Returns, and forgets, the form of a job listed this cycle */
+
+StrDict *MyDTS::take_prefetched( const char *id )
+{
+	if( !prefetched || !id )
+	    return NULL;
+	PrefetchedJob **p = &prefetched[job_hash( id ) % prefetch_size];
+	for( ; *p; p = &(*p)->next )
+	    if( !strcmp( (*p)->id, id ) )
+	    {
+	        PrefetchedJob *item = *p;
+	        *p = item->next;
+	        StrDict *form = item->form;
+	        delete[] item->id;
+	        delete item;
+	        return form;
+	    }
+	return NULL;
+}
+
+/*
+	Lists the jobs matching qualifier with a tagged 'p4 jobs -l', which
+	returns every field of each job. With prefetch the forms are kept
+	for get_defect()/get_defects() in place of the 'p4 job -o' per job.
+*/
+
+struct DTGStrList *MyDTS::list_jobs( int max_rows, const char *qualifier, 
+					char *&err, int prefetch )
 {
 	if( !connected( err ) )
 	    return NULL;
 
 	// Run the command
 	DTGStrList *list = NULL;
-	char *args1[] = { 0, 0, 0, 0, 0 };
+	char *args2[] = { 0, 0, 0, 0, 0, 0 };
+	char num[32];
 	int i = 0;
+	args2[i++] = (char*)&"-l";
 	if( max_rows > 0 )
 	{
-	    char num[32];
 	    snprintf(num, 31, "%d", max_rows );
-	    args1[i++] = (char*)&"-m";
-	    args1[i++] = num;
+	    args2[i++] = (char*)&"-m";
+	    args2[i++] = num;
 	}
 	if( qualifier && *qualifier )
 	{
-	    args1[i++] = (char*)&"-e";
-	    args1[i++] = (char *)qualifier;
+	    args2[i++] = (char*)&"-e";
+	    args2[i++] = (char *)qualifier;
 	}
-	client1->SetArgv( i, args1 );
-	ui1->clear_results();
-	client1->Run( "jobs", ui1 );
-	if( ui1->err_results )
+	client2->SetArgv( i, args2 );
+	ui2->clear_results();
+	ui2->collect_stats = 1;
+	client2->Run( "jobs", ui2 );
+	ui2->collect_stats = 0;
+	if( ui2->err_results )
 	{
-	    err = cp_string( ui1->err_results->Text() );
+	    err = cp_string( ui2->err_results->Text() );
+	    ui2->clear_results();
 	    return NULL;
 	}
 
-	char *val;
-	if( !ui1->info_results )
-	    return NULL;
-	for( int i = 0; val = (char *)ui1->info_results->Get( i ); i++ )
+	int cnt = ui2->stat_list ? ui2->stat_list->Count() : 0;
+	if( prefetch )
 	{
-	    int j;
-	    for( j = 0; val[j] != ' ' && val[j]; j++ );
-	    if( val[j] == ' ' )
+	    clear_prefetched();
+	    prefetch_size = ( cnt < PREFETCH_MAX ? cnt : PREFETCH_MAX ) + 1;
+	    prefetched = new PrefetchedJob *[prefetch_size];
+	    memset( prefetched, 0, sizeof(PrefetchedJob *) * prefetch_size );
+	}
+	struct DTGStrList **last = &list;
+	for( int j = 0; j < cnt; j++ )
+	{
+	    StrDict *job = (StrDict *)ui2->stat_list->Get( j );
+	    StrPtr *name = job->GetVar( "Job" );
+	    if( !name )
+	        continue;
+	    *last = new_DTGStrList( name->Text() );
+	    last = &(*last)->next;
+	    if( prefetch && j < PREFETCH_MAX )
 	    {
-	        val[j] = '\0';
-	        list = append_DTGStrList( list, val );
+	        StrBufDict *form = new StrBufDict();
+	        StrRef var, val;
+	        for( int v = 0; job->GetVar( v, var, val ); v++ )
+	            form->SetVar( var, val );
+	        add_prefetched( name->Text(), form );
 	    }
 	}
+	ui2->clear_results();
+
+	return list;
+}
+
+struct DTGField *MyDTS::list_job_values( const char *qualifier, 
+					const char *field, char *&err )
+{
+	if( !connected( err ) )
+	    return NULL;
+
+	// One tagged 'p4 jobs' returns every field of the matching jobs
+	char *args2[] = { (char*)&"-e", 0, 0 };
+	args2[1] = (char *)qualifier;
+	client2->SetArgv( 2, args2 );
+	ui2->clear_results();
+	ui2->collect_stats = 1;
+	client2->Run( "jobs", ui2 );
+	ui2->collect_stats = 0;
+	if( ui2->err_results )
+	{
+	    err = cp_string( ui2->err_results->Text() );
+	    return NULL;
+	}
+	if( !ui2->stat_list )
+	    return NULL;
+
+	struct DTGField *list = NULL;
+	struct DTGField *last = NULL;
+	for( int i = 0; i < ui2->stat_list->Count(); i++ )
+	{
+	    StrDict *job = (StrDict *)ui2->stat_list->Get( i );
+	    StrPtr *id = job->GetVar( "Job" );
+	    if( !id )
+	        continue;
+	    StrPtr *val = job->GetVar( field );
+	    struct DTGField *item = 
+		new_DTGField( id->Text(), val ? val->Text() : NULL );
+	    if( last )
+	        last->next = item;
+	    else
+	        list = item;
+	    last = item;
+	}
+	ui2->clear_results();
 
 	return list;
 }
 
 StrDict *MyDTS::get_defect( const char *id, char *&err )
 {
+	StrDict *form = take_prefetched( id );
+	if( form )
+	    return form;
 	return get_form( "job", id, err );
 }
 
-char *MyDTS::save_defect( const char * /*name*/, StrDict *fields, char *&err )
+/* Job names which can be matched in a jobview as they are */
+
+static int plain_jobname( const char *id )
+{
+	if( !id || !*id || *id == '-' )
+	    return 0;
+	for( ; *id; id++ )
+	    if( !isalnum( (unsigned char)*id ) && !strchr( "_-.", *id ) )
+	        return 0;
+	return 1;
+}
+
+/*
+	Fetches several jobs with one tagged 'p4 jobs', results[i] being set
+	for ids[i] when found. Jobs not returned are left NULL for the caller
+	to load individually.
+*/
+
+int MyDTS::get_defects( struct DTGStrList *ids, StrDict **results, 
+							char *&err )
+{
+	// Jobs listed this cycle are already here
+	int found = 0;
+	int i = 0;
+	for( struct DTGStrList *id = ids; id; id = id->next, i++ )
+	    if( ( results[i] = take_prefetched( id->value ) ) )
+	        found++;
+	if( !connected( err ) )
+	    return found;
+
+	StrBuf qual;
+	i = 0;
+	for( struct DTGStrList *id = ids; id; id = id->next, i++ )
+	    if( !results[i] && plain_jobname( id->value ) )
+	    {
+	        if( qual.Length() )
+	            qual.Append( "|" );
+	        qual.Append( "Job=" );
+	        qual.Append( id->value );
+	    }
+	if( !qual.Length() )
+	    return found;
+
+	char *args2[] = { (char*)&"-l", (char*)&"-e", 0, 0 };
+	args2[2] = qual.Text();
+	client2->SetArgv( 3, args2 );
+	ui2->clear_results();
+	ui2->collect_stats = 1;
+	client2->Run( "jobs", ui2 );
+	ui2->collect_stats = 0;
+	if( ui2->err_results )
+	{
+	    err = cp_string( ui2->err_results->Text() );
+	    return 0;
+	}
+
+	for( int j = 0; ui2->stat_list && j < ui2->stat_list->Count(); j++ )
+	{
+	    StrDict *job = (StrDict *)ui2->stat_list->Get( j );
+	    StrPtr *name = job->GetVar( "Job" );
+	    if( !name )
+	        continue;
+	    int i = 0;
+	    for( struct DTGStrList *id = ids; id; id = id->next, i++ )
+	        if( !results[i] && !strcmp( id->value, name->Text() ) )
+	        {
+	            StrBufDict *form = new StrBufDict();
+	            StrRef var, val;
+	            for( int v = 0; job->GetVar( v, var, val ); v++ )
+	                form->SetVar( var, val );
+	            results[i] = form;
+	            found++;
+	            break;
+	        }
+	}
+	ui2->clear_results();
+
+	return found;
+}
+
+char *MyDTS::save_defect( const char *name, StrDict *fields, char *&err )
 {
+	// A form listed before this save is out of date
+	delete take_prefetched( name );
 	return save_form( "job", fields, err );
 }
 
@@ -464,45 +748,216 @@ struct DTGFixDesc *MyDTS::describe_fix( const char *id, char *&err )
 	return results;
 }
 
-struct DTGStrList *MyDTS::list_fixes( const char *id, char *&err )
+/*
+	Describes several changes with one tagged 'p4 describe -s', results[i]
+	being set for ids[i] when returned. A change the server could not
+	describe fails only itself, left NULL for describe_fix() to report.
+*/
+
+int MyDTS::describe_fixes( struct DTGStrList *ids, 
+				struct DTGFixDesc **results, char *&err )
 {
-	if( !connected( err ) )
+	int cnt = 0;
+	struct DTGStrList *id;
+	for( id = ids; id; id = id->next )
+	    results[cnt++] = NULL;
+	if( !cnt || !connected( err ) )
+	    return 0;
+
+	char **args2 = new char *[cnt + 2];
+	int i = 0;
+	args2[i++] = (char *)"-s";
+	for( id = ids; id; id = id->next )
+	    args2[i++] = id->value;
+	args2[i] = NULL;
+	client2->SetArgv( i, args2 );
+	ui2->clear_results();
+	ui2->collect_stats = 1;
+	client2->Run( "describe", ui2 );
+	ui2->collect_stats = 0;
+	delete[] args2;
+	if( ui2->err_results && !ui2->stat_list )
+	{
+	    err = cp_string( ui2->err_results->Text() );
+	    ui2->clear_results();
+	    return 0;
+	}
+
+	int found = 0;
+	for( int j = 0; ui2->stat_list && j < ui2->stat_list->Count(); j++ )
+	{
+	    StrDict *desc = (StrDict *)ui2->stat_list->Get( j );
+	    StrPtr *change = desc->GetVar( "change" );
+	    if( !change )
+	        continue;
+	    i = 0;
+	    for( id = ids; id; id = id->next, i++ )
+	        if( !results[i] && !strcmp( id->value, change->Text() ) )
+	        {
+	            results[i] = new_DTGFixDesc();
+	            P4MetaClient::fill_fix( results[i], desc );
+	            found++;
+	            break;
+	        }
+	}
+	ui2->clear_results();
+
+	return found;
+}
+
+/*
+	Jobs looked up one 'p4 fixes -j' at a time before the cycle switches
+	to a single 'p4 fixes' for the whole server. Small cycles stay cheap
+	while a cycle touching many jobs pays for one query. A server with
+	more than fix_index_max fixes stays with the per job queries.
+*/
+
+static const int FIX_INDEX_MIN = 16;
+
+void MyDTS::clear_fix_index()
+{
+	for( int i = 0; i < fix_index_size; i++ )
+	    while( fix_index[i] )
+	    {
+	        FixedJob *item = fix_index[i];
+	        fix_index[i] = item->next;
+	        delete[] item->id;
+	        delete_DTGStrList( item->fixes );
+	        delete item;
+	    }
+	delete[] fix_index;
+	fix_index = NULL;
+	fix_index_size = 0;
+	fix_lookups = 0;
+}
+
+/*
+	Indexes the submitted fixes of every job from one tagged 'p4 fixes',
+	reading one more than fix_index_max to tell a server over the limit.
+*/
+
+int MyDTS::load_fix_index( char *&err )
+{
+	char num[32];
+	snprintf( num, 31, "%d", fix_index_max + 1 );
+	char *args2[] = { (char*)&"-m", num, 0 };
+	client2->SetArgv( 2, args2 );
+	ui2->clear_results();
+	ui2->collect_stats = 1;
+	client2->Run( "fixes", ui2 );
+	ui2->collect_stats = 0;
+	if( ui2->err_results )
+	{
+	    err = cp_string( ui2->err_results->Text() );
+	    ui2->clear_results();
+	    return 0;
+	}
+
+	int cnt = ui2->stat_list ? ui2->stat_list->Count() : 0;
+	if( cnt > fix_index_max )
+	{
+	    err = cp_string( "Fix index limit exceeded" );
+	    ui2->clear_results();
+	    return 0;
+	}
+	fix_index_size = cnt / 2 + 1;
+	fix_index = new FixedJob *[fix_index_size];
+	memset( fix_index, 0, sizeof(FixedJob *) * fix_index_size );
+	for( int i = 0; i < cnt; i++ )
+	{
+	    StrDict *fix = (StrDict *)ui2->stat_list->Get( i );
+	    StrPtr *job = fix->GetVar( "Job" );
+	    StrPtr *change = fix->GetVar( "Change" );
+	    StrPtr *status = fix->GetVar( "Status" );
+	    if( !job || !change || 
+		( status && !strcasecmp( status->Text(), "pending" ) ) )
+	        continue;
+	    FixedJob **p = &fix_index[job_hash( job->Text() ) % fix_index_size];
+	    while( *p && strcmp( (*p)->id, job->Text() ) )
+	        p = &(*p)->next;
+	    if( !*p )
+	    {
+	        *p = new FixedJob;
+	        (*p)->id = cp_string( job->Text() );
+	        (*p)->fixes = NULL;
+	        (*p)->next = NULL;
+	    }
+	    (*p)->fixes = append_DTGStrList( (*p)->fixes, change->Text() );
+	}
+	ui2->clear_results();
+
+	return 1;
+}
+
+struct DTGStrList *MyDTS::indexed_fixes( const char *id )
+{
+	FixedJob *item = fix_index[job_hash( id ) % fix_index_size];
+	while( item && strcmp( item->id, id ) )
+	    item = item->next;
+	if( !item )
 	    return NULL;
+	struct DTGStrList *fixes = NULL;
+	for( struct DTGStrList *f = item->fixes; f; f = f->next )
+	    fixes = append_DTGStrList( fixes, f->value );
+	return fixes;
+}
 
-	// Run the command
-	struct DTGStrList *list = NULL;
-	char *args[] = { (char*)&"-j", 0, 0, 0, 0 };
-	args[1] = (char *)id;
-	client1->SetArgv( 2, args );
-	ui1->clear_results();
-	client1->Run( "fixes", ui1 );
-	if( ui1->err_results )
+/* Tagged fixes carry the change status, so pending ones need no lookup */
+
+struct DTGStrList *MyDTS::submitted_fixes( const char *id, char *&err )
+{
+	char *args2[] = { (char*)&"-j", 0, 0 };
+	args2[1] = (char *)id;
+	client2->SetArgv( 2, args2 );
+	ui2->clear_results();
+	ui2->collect_stats = 1;
+	client2->Run( "fixes", ui2 );
+	ui2->collect_stats = 0;
+	if( ui2->err_results )
 	{
-	    err = cp_string( ui1->err_results->Text() );
+	    err = cp_string( ui2->err_results->Text() );
+	    ui2->clear_results();
 	    return NULL;
 	}
 
-	char *val;
-	if( !ui1->info_results )
+	struct DTGStrList *fixes = NULL;
+	for( int i = 0; ui2->stat_list && i < ui2->stat_list->Count(); i++ )
+	{
+	    StrDict *fix = (StrDict *)ui2->stat_list->Get( i );
+	    StrPtr *change = fix->GetVar( "Change" );
+	    StrPtr *status = fix->GetVar( "Status" );
+	    if( change && 
+		!( status && !strcasecmp( status->Text(), "pending" ) ) )
+	        fixes = append_DTGStrList( fixes, change->Text() );
+	}
+	ui2->clear_results();
+
+	return fixes;
+}
+
+/* Lists the submitted changes fixing a job */
+
+struct DTGStrList *MyDTS::list_fixes( const char *id, char *&err )
+{
+	if( !connected( err ) )
 	    return NULL;
-	for( int i = 0; val = (char *)ui1->info_results->Get( i ); i++ )
-	    list = append_DTGStrList( list, val );
 
-	struct DTGStrList *fixes = NULL;
-	char tmp[32];
-	for( struct DTGStrList *f = list; f; f = f->next )
+	if( !fix_index && fix_index_max > 0 && fix_lookups >= 0 && 
+		++fix_lookups > FIX_INDEX_MIN )
 	{
-	    char *i = strstr( f->value, " by change " );
-	    if( i )
+	    char *msg = NULL;
+	    if( !load_fix_index( msg ) )
 	    {
-	        int num = atoi( &i[11] );
-	        snprintf( tmp, 32, "%d", num );
-	        fixes = append_DTGStrList( fixes, tmp );
+	        // Over the limit or MaxResults: stay with per job queries
+	        delete[] msg;
+	        clear_fix_index();
+	        fix_lookups = -1;
 	    }
 	}
-	delete_DTGStrList( list );
+	if( fix_index )
+	    return indexed_fixes( id );
 
-	return fixes;
+	return submitted_fixes( id, err );
 }
 
 StrDict *MyDTS::get_form( const char *type, const char *id, char *&err )
@@ -48,6 +48,36 @@ class MyDTS {
 	    int connected( char *&err );
 	    char *save_form( const char *type, StrDict *fields, char *&err );
 
+	    // Jobs returned by the last listing of changed jobs, by name,
+	    // at most PREFETCH_MAX and none while worker threads run
+	    struct PrefetchedJob {
+	        char *id;
+	        StrDict *form;
+	        PrefetchedJob *next;
+	    };
+	    PrefetchedJob **prefetched;
+	    int prefetch_size;
+
+	    void clear_prefetched();
+	    void add_prefetched( const char *id, StrDict *form );
+	    StrDict *take_prefetched( const char *id );
+
+	    // Submitted fixes of every job, loaded at most once per cycle
+	    struct FixedJob {
+	        char *id;
+	        struct DTGStrList *fixes;
+	        FixedJob *next;
+	    };
+	    FixedJob **fix_index;
+	    int fix_index_size;
+	    int fix_lookups;	// per job queries this cycle, -1 no index
+	    int fix_index_max;	// most fixes read into the index, 0 none
+
+	    void clear_fix_index();
+	    int load_fix_index( char *&err );
+	    struct DTGStrList *indexed_fixes( const char *id );
+	    struct DTGStrList *submitted_fixes( const char *id, char *&err );
+
 	public:
 	    char *server_id;
 
@@ -62,6 +92,9 @@ class MyDTS {
 		char *&err);
 	    virtual ~MyDTS();
 
+	    static void thread_begin();
+	    static void thread_end();
+
 	    int is_valid() { return valid; };
 	    int valid_project( const char *proj );
 	    int utf8_ok() { return utf8; };
@@ -74,13 +107,20 @@ class MyDTS {
 		struct DTGDate *since, const char *mod_date_field,
 		const char *exclude_user, const char *mod_by_field,
 		const char *segment_filters,
-		char *&err );
+		char *&err, const char *after = NULL );
 	    StrDict *get_defect( const char *id, char *&err );
+	    int get_defects( struct DTGStrList *ids, StrDict **results, 
+						char *&err );
 	    char *save_defect( const char *name, StrDict *fields, char *&err );
 
 	    struct DTGStrList *list_jobs( int max_rows, const char *qual, 
+						char *&err, int prefetch = 0 );
+	    struct DTGField *list_job_values( const char *qual, 
+						const char *field,
 						char *&err );
 	    struct DTGFixDesc *describe_fix( const char *id, char *&err );
+	    int describe_fixes( struct DTGStrList *ids, 
+				struct DTGFixDesc **results, char *&err );
 	    struct DTGStrList *list_fixes( const char *id, char *&err );
 };
 
@@ -27,6 +27,7 @@ extern "C" {
 
 #include "P4MetaClient.h"
 #include <p4/strtable.h>
+#include <p4/vararray.h>
 #include "dtg-utils.h"
 #include "StrArr.h"
 
@@ -37,6 +38,9 @@ P4MetaClient::P4MetaClient() : ClientUser()
 	stat_results = NULL;
 	err_results = NULL;
 
+	collect_stats = 0;
+	stat_list = NULL;
+
 	fix = NULL;
 
 	data_set = NULL;
@@ -56,6 +60,12 @@ P4MetaClient::clear_results()
 	DELETE_OBJECT( info_results )
 	DELETE_OBJECT( stat_results )
 	DELETE_OBJECT( err_results )
+	if( stat_list )
+	{
+	    for( int i = 0; i < stat_list->Count(); i++ )
+	        delete (StrBufDict *)stat_list->Get( i );
+	    DELETE_OBJECT( stat_list )
+	}
 	if( fix )
 	{
 	    delete_DTGFixDesc( fix );
@@ -168,18 +178,37 @@ P4MetaClient::OutputStat( StrDict *dict )
 {
 	if( !fix )
 	{
-	    if( stat_results == NULL )
-	        stat_results = new StrBufDict();
+	    StrBufDict *results;
+	    if( collect_stats )
+	    {
+	        if( stat_list == NULL )
+	            stat_list = new VarArray;
+	        results = new StrBufDict();
+	        stat_list->Put( results );
+	    }
+	    else
+	    {
+	        if( stat_results == NULL )
+	            stat_results = new StrBufDict();
+	        results = stat_results;
+	    }
 	    StrRef var, val;
 	    for( int i = 0; dict->GetVar( i, var, val ); i++ )
 	        if( strcmp( var.Text(), "func" ) && 
 	            strcmp( var.Text(), "specFormatted" ) &&
 	            strcmp( var.Text(), "altArg" ) )
-	            stat_results->SetVar( var, val );
+	            results->SetVar( var, val );
 	    return;
 	}
-	
-	/* Process FIX details */
+
+	fill_fix( fix, dict );
+}
+
+/* Sets fix from the tagged output of 'p4 describe -s' for one change */
+
+void
+P4MetaClient::fill_fix( struct DTGFixDesc *fix, StrDict *dict )
+{
 	StrRef var, val;
 	struct DTGStrList *tmp;
 	const char *action = NULL;
@@ -27,6 +27,7 @@
 
 class StrArr;
 class StrBufDict;
+class VarArray;
 
 struct DTGFixDesc;
 
@@ -46,7 +47,12 @@ class P4MetaClient : public ClientUser {
 	    StrBufDict *stat_results;
 	    StrBuf *err_results;
 
+	    // When set, every tagged record is kept in stat_list
+	    int collect_stats;
+	    VarArray *stat_list; // of StrBufDict *
+
 	    struct DTGFixDesc *fix;
+	    static void fill_fix( struct DTGFixDesc *fix, StrDict *dict );
 
 	    StrBuf *data_set;
 
@@ -21,61 +21,69 @@
 #include <dtg-str.h>
 #include <p4/i18napi.h>
 #include <p4/charcvt.h>
+#include "p4charcvt.h"
 
-/* 
-    Convert 'from' string from encoding 'from_set' to 'to_set'
-    if sub_missing, then substitute '?' for missing characters
-    On error, returns NULL and sets 'err' with error message
-*/
-char *p4charcvt(const char *from_set,
-		const char *to_set,
-		const char *from,
-		int from_len,
-		int sub_missing,
-		char *&err )
+static char *copy_str( const char *from, int from_len )
 {
-	char *tmp = NULL;
+	char *tmp = new char[from_len + 1];
+	memcpy( tmp, from, from_len );
+	tmp[from_len] = '\0';
+	return tmp;
+}
 
-	if( !from_set || !to_set )
-	{
-	    err = cp_string( "Missing FROM/TO charset" );
-	    return NULL;
-	}
-	if( !from )
-	    return NULL;
+/* Checks a word at a time for a byte with the high bit set */
 
-	if( !strcmp( from_set, to_set ) )
+static int is_ascii( const char *from, int from_len )
+{
+	const unsigned long long high = 0x8080808080808080ULL;
+	int i = 0;
+	for( ; i + 8 <= from_len; i += 8 )
 	{
-	    tmp = new char[from_len + 1];
-	    memcpy( tmp, from, from_len );
-	    tmp[from_len] = '\0';
-	    return tmp;
+	    unsigned long long word;
+	    memcpy( &word, &from[i], 8 );
+	    if( word & high )
+	        return 0;
 	}
+	for( ; i < from_len; i++ )
+	    if( from[i] & 0x80 )
+	        return 0;
+	return 1;
+}
 
+static int ascii_charset( const char *set )
+{
+	return strncmp( set, "utf16", 5 ) && strncmp( set, "utf32", 5 );
+}
+
+static CharSetCvt *find_cvt( const char *from_set, const char *to_set, 
+				char *&err )
+{
 	CharSetCvt::CharSet fromset = CharSetCvt::Lookup( from_set );
 	if( fromset == (CharSetCvt::CharSet)-1 )
 	{
-	    tmp = mk_string( "Invalid FROM charset: ", from_set );
-	    err = tmp;
+	    err = mk_string( "Invalid FROM charset: ", from_set );
 	    return NULL;
 	}
 	CharSetCvt::CharSet toset = CharSetCvt::Lookup( to_set );
 	if( toset == (CharSetCvt::CharSet)-1 )
 	{
-	    tmp = mk_string( "Invalid TO charset: ", to_set );
-	    err = tmp;
+	    err = mk_string( "Invalid TO charset: ", to_set );
 	    return NULL;
 	}
 	CharSetCvt *cvter = CharSetCvt::FindCvt( fromset, toset );
 	if( !cvter )
 	{
-	    tmp = mk_string( "Invalid conversion from ", from_set,
+	    err = mk_string( "Invalid conversion from ", from_set,
 					" to ", to_set );
-	    err = tmp;
 	    return NULL;
 	}
-
 	cvter->IgnoreBOM(); // Useful only for file content
+	return cvter;
+}
+
+static char *run_cvt( CharSetCvt *cvter, const char *from, int from_len,
+			int sub_missing, char *&err )
+{
 	cvter->ResetErr();
 
 	/*
@@ -100,22 +108,84 @@ char *p4charcvt(const char *from_set,
 	case CharSetCvt::NOMAPPING:
 	    if( sub_missing )
 	        break;
-	    tmp = mk_string( "Missing character mapping" );
-	    err = tmp;
-	    delete cvter;
+	    err = mk_string( "Missing character mapping" );
 	    return NULL;
 	case CharSetCvt::PARTIALCHAR:
-	    tmp = mk_string( "Partial character found" );
-	    err = tmp;
-	    delete cvter;
+	    err = mk_string( "Partial character found" );
 	    return NULL;
 	}
 	
-	tmp = new char[rlen + 1];
-	memcpy( tmp, to, rlen );
-	tmp[rlen] = '\0';
+	return copy_str( to, rlen );
+}
+
+/* 
+    Convert 'from' string from encoding 'from_set' to 'to_set'
+    if sub_missing, then substitute '?' for missing characters
+    On error, returns NULL and sets 'err' with error message
+*/
+char *p4charcvt(const char *from_set,
+		const char *to_set,
+		const char *from,
+		int from_len,
+		int sub_missing,
+		char *&err )
+{
+	if( !from_set || !to_set )
+	{
+	    err = cp_string( "Missing FROM/TO charset" );
+	    return NULL;
+	}
+	if( !from )
+	    return NULL;
 
+	if( !strcmp( from_set, to_set ) ||
+	    ( ascii_charset( from_set ) && ascii_charset( to_set ) &&
+	      is_ascii( from, from_len ) ) )
+	    return copy_str( from, from_len );
+
+	CharSetCvt *cvter = find_cvt( from_set, to_set, err );
+	if( !cvter )
+	    return NULL;
+	char *tmp = run_cvt( cvter, from, from_len, sub_missing, err );
 	delete cvter;
 
 	return tmp;
 }
+
+P4CharCvt::P4CharCvt( const char *charset )
+{
+	to_utf8 = from_utf8 = NULL;
+	error = NULL;
+	ascii_same = ascii_charset( charset );
+	if( !strcmp( charset, "utf8" ) )
+	    return; // Nothing to convert
+	to_utf8 = find_cvt( charset, "utf8", error );
+	if( to_utf8 )
+	    from_utf8 = find_cvt( "utf8", charset, error );
+}
+
+P4CharCvt::~P4CharCvt()
+{
+	if( to_utf8 )
+	    delete to_utf8;
+	if( from_utf8 )
+	    delete from_utf8;
+	if( error )
+	    delete[] error;
+}
+
+char *P4CharCvt::convert( int rev, const char *from, int from_len,
+			int sub_missing, char *&err )
+{
+	if( !from )
+	    return NULL;
+	if( error )
+	{
+	    err = cp_string( error );
+	    return NULL;
+	}
+	CharSetCvt *cvter = rev ? from_utf8 : to_utf8;
+	if( !cvter || ( ascii_same && is_ascii( from, from_len ) ) )
+	    return copy_str( from, from_len );
+	return run_cvt( cvter, from, from_len, sub_missing, err );
+}
@@ -26,4 +26,28 @@ extern char *p4charcvt(const char *from_set,
                 int sub_missing,
                 char *&err );
 
+class CharSetCvt;
+
+/*
+	Converts between one charset and utf8 for a connection, creating the
+	converters once. Plain ASCII, the same in utf8 and the byte oriented
+	charsets, is copied as it is.
+*/
+
+class P4CharCvt {
+    protected:
+	CharSetCvt *to_utf8;
+	CharSetCvt *from_utf8;
+	int ascii_same;	// not for utf16/utf32
+	char *error;	// charset not usable
+
+    public:
+	P4CharCvt( const char *charset );
+	~P4CharCvt();
+
+	// rev: utf8 to the charset
+	char *convert( int rev, const char *from, int from_len,
+			int sub_missing, char *&err );
+};
+
 #endif
@@ -0,0 +1,208 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Times the conversion of the fields of a job between a non-Unicode
+	server charset and utf8, as MyDTGProj::translate does for each
+	field read or saved:
+
+	    per string	a converter looked up and made for every field,
+			as before P4CharCvt
+	    cached	P4CharCvt's converters, without the ASCII copy
+	    cached+ascii	P4CharCvt as the plug-in uses it
+
+	over plain ASCII jobs and jobs with accented text.
+
+	    p4charcvt-bench [charset [rounds]]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <dtg-str.h>
+#include <p4/i18napi.h>
+#include <p4/charcvt.h>
+#include "p4charcvt.h"
+
+/* P4CharCvt converting every string, ASCII or not */
+
+class NoAsciiCvt : public P4CharCvt {
+    public:
+	NoAsciiCvt( const char *charset ) : P4CharCvt( charset )
+	{
+	    ascii_same = 0;
+	};
+};
+
+/* The conversion as it was: both charsets looked up for each string */
+
+static char *per_string( const char *from_set, const char *to_set,
+			const char *from, int from_len, char *&err )
+{
+	CharSetCvt *cvter = CharSetCvt::FindCvt(
+				CharSetCvt::Lookup( from_set ),
+				CharSetCvt::Lookup( to_set ) );
+	if( !cvter )
+	{
+	    err = cp_string( "No converter" );
+	    return NULL;
+	}
+	cvter->IgnoreBOM();
+	cvter->ResetErr();
+	int rlen = 0;
+	const char *to = cvter->FastCvt( from, from_len, &rlen );
+	char *tmp = NULL;
+	if( to && !cvter->LastErr() )
+	{
+	    tmp = new char[rlen + 1];
+	    memcpy( tmp, to, rlen );
+	    tmp[rlen] = '\0';
+	}
+	else
+	    err = cp_string( "Conversion failed" );
+	delete cvter;
+	return tmp;
+}
+
+/* The fields of a job as 'p4 job -o' returns them */
+
+static const char *ascii_job[] = {
+	"job004217",
+	"open",
+	"2024/03/18 14:22:05",
+	"jsmith",
+	"Crash when saving a defect with an empty description",
+	"Saving a defect with an empty Description field crashes the\n"
+	"replication engine on the next cycle. Steps to reproduce:\n"
+	"1. Create a defect with no description\n"
+	"2. Run a replication cycle\n"
+	"The log shows a segmentation fault in the mapping code.\n",
+	"BUG-1284",
+	"A",
+	NULL
+};
+
+/* The same job in the server charset, with accented text */
+
+static const char *latin_job[] = {
+	"job004218",
+	"open",
+	"2024/03/18 14:22:05",
+	"j\xe9r\xf4me",
+	"Caract\xe8res accentu\xe9s perdus \xe0 l'enregistrement",
+	"Les champs contenant des caract\xe8res accentu\xe9s sont\n"
+	"tronqu\xe9s apr\xe8s la r\xe9plication : \xab caf\xe9 \xbb devient\n"
+	"\xab caf \xbb. Le probl\xe8me appara\xeet d\xe8s le premier cycle\n"
+	"et touche aussi la description et le r\xe9sum\xe9.\n",
+	"BUG-1285",
+	"B",
+	NULL
+};
+
+typedef char *(convert_ftn)( void *cvt, const char *charset, int rev,
+				const char *from, int from_len, char *&err );
+
+static char *by_string( void *, const char *charset, int rev,
+			const char *from, int from_len, char *&err )
+{
+	return rev ? per_string( "utf8", charset, from, from_len, err ) :
+			per_string( charset, "utf8", from, from_len, err );
+}
+
+static char *by_cvt( void *cvt, const char *, int rev,
+			const char *from, int from_len, char *&err )
+{
+	return ((P4CharCvt *)cvt)->convert( rev, from, from_len, 0, err );
+}
+
+/*
+	Converts each field to utf8 and back, as a job is read and saved,
+	returning the seconds taken or -1 on an error.
+*/
+
+static double run( convert_ftn *ftn, void *cvt, const char *charset,
+			const char **job, int rounds, long &bytes )
+{
+	bytes = 0;
+	auto start = std::chrono::steady_clock::now();
+	for( int r = 0; r < rounds; r++ )
+	    for( const char **f = job; *f; f++ )
+	    {
+	        char *err = NULL;
+	        int len = (int)strlen( *f );
+	        char *utf8 = ftn( cvt, charset, 0, *f, len, err );
+	        char *back = utf8 ? ftn( cvt, charset, 1, utf8,
+					(int)strlen( utf8 ), err ) : NULL;
+	        if( !back || strcmp( back, *f ) )
+	        {
+	            fprintf( stderr, "Field %s: %s\n", *f,
+				err ? err : "does not convert back" );
+	            delete[] err;
+	            delete[] utf8;
+	            delete[] back;
+	            return -1.0;
+	        }
+	        bytes += len + (long)strlen( utf8 );
+	        delete[] utf8;
+	        delete[] back;
+	    }
+	return std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start ).count();
+}
+
+int main( int argc, char **argv )
+{
+	const char *charset = argc > 1 ? argv[1] : "iso8859-1";
+	int rounds = argc > 2 ? atoi( argv[2] ) : 20000;
+	if( rounds < 1 )
+	    rounds = 1;
+
+	P4CharCvt cached( charset );
+	NoAsciiCvt no_ascii( charset );
+	struct { const char *name; convert_ftn *ftn; void *cvt; } modes[] = {
+	    { "per string", by_string, NULL },
+	    { "cached", by_cvt, &no_ascii },
+	    { "cached+ascii", by_cvt, &cached },
+	};
+	struct { const char *name; const char **job; } jobs[] = {
+	    { "ascii", ascii_job },
+	    { "accented", latin_job },
+	};
+
+	int fields = 0;
+	for( const char **f = ascii_job; *f; f++, fields++ );
+
+	printf( "charset %s, %d rounds of %d fields to utf8 and back\n",
+		charset, rounds, fields );
+	printf( "%-10s %-14s %12s %10s\n", "job", "converter",
+		"ns/field", "MB/s" );
+	for( size_t j = 0; j < sizeof( jobs ) / sizeof( jobs[0] ); j++ )
+	    for( size_t m = 0; m < sizeof( modes ) / sizeof( modes[0] ); m++ )
+	    {
+	        long bytes;
+	        double secs = run( modes[m].ftn, modes[m].cvt, charset,
+				jobs[j].job, rounds, bytes );
+	        if( secs < 0.0 )
+	            return 1;
+	        printf( "%-10s %-14s %12.1f %10.1f\n", jobs[j].name,
+			modes[m].name, secs * 1e9 / ( 2.0 * rounds * fields ),
+			bytes / ( 1024.0 * 1024.0 ) / secs );
+	    }
+	return 0;
+}
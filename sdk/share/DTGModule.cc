@@ -46,6 +46,72 @@ extern "C" {
 
 #include <DTGModule.h>
 
+/*
+	Calls int_<ftn> with args, timing it when stats are enabled. With
+	them off this costs the one test of stats.
+*/
+#define TIMED( ftn, args ) \
+	( stats ? stats->timed( DTGCallStats::ftn, \
+			[&]() { return int_##ftn args; } ) \
+		: int_##ftn args )
+
+const char *DTGCallStats::names[CALLS] = {
+	"extract_date", "format_date", "dt_get_server_warnings",
+	"dt_get_message", "dt_accept_utf8", "dt_server_offline",
+	"dt_get_server_date", "dt_list_projects", "proj_list_fields",
+	"proj_list_fixes", "proj_describe_fix", "proj_describe_fixes",
+	"proj_list_changed_defects", "proj_open_changed_defects",
+	"cursor_next_defects", "cursor_free", "proj_find_defects",
+	"proj_find_defect_values", "proj_referenced_fields",
+	"proj_segment_filters", "defect_get_fields", "defect_get_field",
+	"defect_save", "dt_get_name", "dt_get_module_version",
+	"dt_get_server_version", "dt_connect", "dt_free", "dt_get_project",
+	"proj_free", "proj_get_defect", "proj_get_defects", 
+	"proj_save_defects", "proj_new_defect", "defect_free",
+	"defect_set_field", "dt_list_attrs", "dt_validate_attr"
+};
+
+DTGCallStats::DTGCallStats()
+{
+	for( int i = 0; i < CALLS; i++ )
+	{
+	    calls[i] = 0L;
+	    usecs[i] = 0L;
+	    max_usecs[i] = 0L;
+	    for( int j = 0; j < DTGCallCounts::BUCKETS; j++ )
+	        hist[i][j] = 0L;
+	}
+}
+
+void DTGCallStats::record( int ftn, long usec )
+{
+	int bucket = 0;
+	while( bucket < DTGCallCounts::BUCKETS - 1 && ( usec >> bucket ) )
+	    bucket++;
+	calls[ftn].fetch_add( 1, std::memory_order_relaxed );
+	usecs[ftn].fetch_add( usec, std::memory_order_relaxed );
+	hist[ftn][bucket].fetch_add( 1, std::memory_order_relaxed );
+	long max = max_usecs[ftn].load( std::memory_order_relaxed );
+	while( usec > max && 
+		!max_usecs[ftn].compare_exchange_weak( max, usec,
+					std::memory_order_relaxed ) );
+}
+
+void DTGCallStats::read( int ftn, struct DTGCallCounts *counts )
+{
+	counts->calls = calls[ftn].load( std::memory_order_relaxed );
+	counts->usecs = usecs[ftn].load( std::memory_order_relaxed );
+	counts->max_usecs = max_usecs[ftn].load( std::memory_order_relaxed );
+	for( int j = 0; j < DTGCallCounts::BUCKETS; j++ )
+	    counts->hist[j] = hist[ftn][j].load( std::memory_order_relaxed );
+}
+
+void DTGModule::enable_stats()
+{
+	if( !stats )
+	    stats = new DTGCallStats();
+}
+
 int DTGModule::has_perforce_extensions()
 {
 	return ( int_proj_list_fixes &&
@@ -60,6 +126,21 @@ int DTGModule::has_attribute_extensions()
 		free_dtg_attribute );
 }
 
+int DTGModule::has_bulk_extensions()
+{
+	return ( int_proj_get_defects != NULL );
+}
+
+int DTGModule::has_bulk_save()
+{
+	return ( int_proj_save_defects != NULL );
+}
+
+int DTGModule::has_bulk_describe()
+{
+	return ( int_proj_describe_fixes != NULL );
+}
+
 void DTGModule::record_error( const char *ftn, const char *error )
 {
 	SNPRINTF( last_error, MAX_ERR_MSG, "%s: %s", ftn, error );
@@ -79,6 +160,7 @@ DTGModule::DTGModule( const char *use_dl )
 {
 	next = NULL;
 	pseudo_attrs = NULL;
+	stats = NULL;
 	dl_name = strdup( use_dl );
 	last_error[0] = '\0';
 
@@ -214,6 +296,11 @@ DTGModule::DTGModule( const char *use_dl )
 	  (proj_list_fixes_ftn *)load_function( "proj_list_fixes" );
 	int_proj_describe_fix = 
 	  (proj_describe_fix_ftn *)load_function( "proj_describe_fix" );
+	int_proj_describe_fixes = 
+	  (proj_describe_fixes_ftn *)load_function( "proj_describe_fixes" );
+	int_proj_find_defect_values = 
+	  (proj_find_defect_values_ftn *)load_function( 
+						"proj_find_defect_values" );
 	if( *last_error )
 	    last_error[0] = '\0';
 
@@ -226,6 +313,21 @@ DTGModule::DTGModule( const char *use_dl )
 						     "proj_referenced_fields" );
 	int_proj_segment_filters =
 	  (proj_segment_filters_ftn *)load_function( "proj_segment_filters" );
+	int_proj_get_defects =
+	  (proj_get_defects_ftn *)load_function( "proj_get_defects" );
+	int_proj_save_defects =
+	  (proj_save_defects_ftn *)load_function( "proj_save_defects" );
+	int_proj_open_changed_defects =
+	  (proj_open_changed_defects_ftn *)load_function( 
+						"proj_open_changed_defects" );
+	int_cursor_next_defects =
+	  (cursor_next_defects_ftn *)load_function( "cursor_next_defects" );
+	int_cursor_free =
+	  (cursor_free_ftn *)load_function( "cursor_free" );
+	int_dt_thread_begin =
+	  (dt_thread_begin_ftn *)load_function( "dt_thread_begin" );
+	int_dt_thread_end =
+	  (dt_thread_end_ftn *)load_function( "dt_thread_end" );
 	int_dt_accept_utf8 = 
 		(dt_accept_utf8_ftn *)load_function( "dt_accept_utf8" );
 	int_dt_server_offline = 
@@ -266,6 +368,7 @@ DTGModule::~DTGModule()
 	if( next )
 	    delete next;
 	delete_DTGField( pseudo_attrs );
+	delete stats;
 }
 
 static void die( struct DTGError *err, const char *msg )
@@ -431,7 +534,7 @@ DTGModule::test_module()
 
 struct DTGDate *DTGModule::extract_date( const char *date_string )
 {
-	struct DTGDate *tmp = int_extract_date( date_string );
+	struct DTGDate *tmp = TIMED( extract_date, ( date_string ) );
 	struct DTGDate *res = copy_DTGDate( tmp );
 	free_dtg_date( tmp );
 	return res;
@@ -439,7 +542,7 @@ struct DTGDate *DTGModule::extract_date( const char *date_string )
 
 struct DTGAttribute *DTGModule::dt_list_attrs()
 {
-	struct DTGAttribute *tmp = int_dt_list_attrs();
+	struct DTGAttribute *tmp = TIMED( dt_list_attrs, () );
 	struct DTGAttribute *res = copy_DTGAttribute( tmp );
 	free_dtg_attribute( tmp );
 	return res;
@@ -447,7 +550,7 @@ struct DTGAttribute *DTGModule::dt_list_attrs()
 
 char *DTGModule::dt_validate_attr( const struct DTGField *attr )
 {
-	char *tmp = int_dt_validate_attr( attr );
+	char *tmp = TIMED( dt_validate_attr, ( attr ) );
 	char *res;
 	if( tmp )
 	{
@@ -461,7 +564,7 @@ char *DTGModule::dt_validate_attr( const struct DTGField *attr )
 
 char *DTGModule::format_date( struct DTGDate *date )
 {
-	char *tmp = int_format_date( date );
+	char *tmp = TIMED( format_date, ( date ) );
 	char *res;
 	if( tmp )
 	{
@@ -477,7 +580,7 @@ char *DTGModule::dt_get_server_warnings( void *dtID,
 					struct DTGError *error )
 {
 	clear_DTGError( error );
-	char *tmp = int_dt_get_server_warnings( dtID, error );
+	char *tmp = TIMED( dt_get_server_warnings, ( dtID, error ) );
 	char *res;
 	if( tmp )
 	{
@@ -500,7 +603,7 @@ int DTGModule::dt_get_message( void *dtID, struct DTGError *error )
 	clear_DTGError( error );
 	if( int_dt_get_message )
 	{
-	    int tmp = int_dt_get_message( dtID, error );
+	    int tmp = TIMED( dt_get_message, ( dtID, error ) );
 	    if( error->message )
 	    {
 	        char *msg = error->message;
@@ -517,7 +620,7 @@ struct DTGDate *DTGModule::dt_get_server_date( void *dtID,
 					struct DTGError *error )
 {
 	clear_DTGError( error );
-	struct DTGDate *tmp = int_dt_get_server_date( dtID, error );
+	struct DTGDate *tmp = TIMED( dt_get_server_date, ( dtID, error ) );
 	struct DTGDate *res = copy_DTGDate( tmp );
 	free_dtg_date( tmp );
 	if( error->message )
@@ -535,7 +638,7 @@ int DTGModule::dt_accept_utf8( void *dtID, struct DTGError *error )
 	if( int_dt_accept_utf8 )
 	{
 	    clear_DTGError( error );
-	    accept = int_dt_accept_utf8( dtID, error );
+	    accept = TIMED( dt_accept_utf8, ( dtID, error ) );
 	    if( error->message )
 	    {
 	        char *str = error->message;
@@ -554,7 +657,7 @@ int DTGModule::dt_server_offline( void *dtID, struct DTGError *error )
 	if( int_dt_server_offline )
 	{
 	    clear_DTGError( error );
-	    wait = int_dt_server_offline( dtID, error );
+	    wait = TIMED( dt_server_offline, ( dtID, error ) );
 	    if( error->message )
 	    {
 	        char *str = error->message;
@@ -576,7 +679,7 @@ struct DTGStrList *DTGModule::dt_list_projects( void *dtID,
 					struct DTGError *error )
 {
 	clear_DTGError( error );
-	struct DTGStrList *tmp = int_dt_list_projects( dtID, error );
+	struct DTGStrList *tmp = TIMED( dt_list_projects, ( dtID, error ) );
 	struct DTGStrList *res = copy_DTGStrList( tmp );
 	free_dtg_str_list( tmp );
 	if( error->message )
@@ -592,7 +695,8 @@ struct DTGFieldDesc *DTGModule::proj_list_fields( void *projID,
 					struct DTGError *error )
 {
 	clear_DTGError( error );
-	struct DTGFieldDesc *tmp = int_proj_list_fields( projID, error );
+	struct DTGFieldDesc *tmp = 
+		TIMED( proj_list_fields, ( projID, error ) );
 	struct DTGFieldDesc *res = copy_DTGFieldDesc( tmp );
 	free_dtg_field_desc( tmp );
 	if( error->message )
@@ -617,7 +721,8 @@ struct DTGStrList *DTGModule::proj_list_fixes( void *projID,
 					struct DTGError *error )
 {
 	clear_DTGError( error );
-	struct DTGStrList *tmp = int_proj_list_fixes( projID, defect, error );
+	struct DTGStrList *tmp = 
+		TIMED( proj_list_fixes, ( projID, defect, error ) );
 	struct DTGStrList *res = copy_DTGStrList( tmp );
 	free_dtg_str_list( tmp );
 	if( error->message )
@@ -634,7 +739,8 @@ struct DTGFixDesc *DTGModule::proj_describe_fix( void *projID,
 					struct DTGError *error )
 {
 	clear_DTGError( error );
-	struct DTGFixDesc *tmp = int_proj_describe_fix( projID, fixid, error );
+	struct DTGFixDesc *tmp = 
+		TIMED( proj_describe_fix, ( projID, fixid, error ) );
 	struct DTGFixDesc *res = copy_DTGFixDesc( tmp );
 	free_dtg_fix_desc( tmp );
 	if( error->message )
@@ -646,6 +752,38 @@ struct DTGFixDesc *DTGModule::proj_describe_fix( void *projID,
 	return res;
 }
 
+int DTGModule::proj_describe_fixes( void *projID, 
+					struct DTGStrList *fixids,
+					struct DTGFixDesc **fixes,
+					struct DTGError *error )
+{
+	clear_DTGError( error );
+	int i = 0;
+	struct DTGStrList *f;
+	for( f = fixids; f; f = f->next )
+	    fixes[i++] = NULL;
+	if( !int_proj_describe_fixes )
+	    return 0; // Left for proj_describe_fix
+
+	int res = TIMED( proj_describe_fixes, 
+				( projID, fixids, fixes, error ) );
+	i = 0;
+	for( f = fixids; f; f = f->next, i++ )
+	    if( fixes[i] )
+	    {
+	        struct DTGFixDesc *tmp = fixes[i];
+	        fixes[i] = copy_DTGFixDesc( tmp );
+	        free_dtg_fix_desc( tmp );
+	    }
+	if( error->message )
+	{
+	    char *str = error->message;
+	    error->message = strdup( str );
+	    free_char( str );
+	}
+	return res;
+}
+
 struct DTGStrList *DTGModule::proj_list_changed_defects( void *projID, 
 					int max_rows,
 					struct DTGDate *since, 
@@ -655,10 +793,10 @@ struct DTGStrList *DTGModule::proj_list_changed_defects( void *projID,
 					struct DTGError *error )
 {
 	clear_DTGError( error );
-	struct DTGStrList *tmp = int_proj_list_changed_defects( projID, 
+	struct DTGStrList *tmp = TIMED( proj_list_changed_defects, ( projID, 
 					max_rows, since, mod_date_field,
 					mod_by_field, exclude_mod_user, 
-					error );
+					error ) );
 	struct DTGStrList *res = copy_DTGStrList( tmp );
 	free_dtg_str_list( tmp );
 	if( error->message )
@@ -670,16 +808,125 @@ struct DTGStrList *DTGModule::proj_list_changed_defects( void *projID,
 	return res;
 }
 
+/*
+	Changed defect cursor: the plug-in's own when it has one, otherwise
+	the proj_list_changed_defects list handed out a page at a time.
+*/
+
+struct DTGModuleCursor {
+	void *cursorID;
+	struct DTGStrList *rest;
+	int page_size;
+};
+
+void *DTGModule::proj_open_changed_defects( void *projID, 
+					int page_size,
+					struct DTGDate *since, 
+					const char *mod_date_field,
+					const char *mod_by_field,
+					const char *exclude_mod_user,
+					struct DTGError *error )
+{
+	clear_DTGError( error );
+	struct DTGModuleCursor *cur = new DTGModuleCursor;
+	cur->cursorID = NULL;
+	cur->rest = NULL;
+	cur->page_size = page_size > 0 ? page_size : 1;
+	if( int_proj_open_changed_defects && 
+	    int_cursor_next_defects && int_cursor_free )
+	{
+	    cur->cursorID = TIMED( proj_open_changed_defects, ( projID, 
+					cur->page_size, since, mod_date_field,
+					mod_by_field, exclude_mod_user, 
+					error ) );
+	    if( error->message )
+	    {
+	        char *str = error->message;
+	        error->message = strdup( str );
+	        free_char( str );
+	    }
+	}
+	else
+	    cur->rest = proj_list_changed_defects( projID, 0, since, 
+					mod_date_field, mod_by_field,
+					exclude_mod_user, error );
+	if( error->message )
+	{
+	    struct DTGError *tmp = new_DTGError( NULL );
+	    cursor_free( cur, tmp );
+	    delete_DTGError( tmp );
+	    return NULL;
+	}
+	return cur;
+}
+
+struct DTGStrList *DTGModule::cursor_next_defects( void *cursorID,
+					struct DTGError *error )
+{
+	clear_DTGError( error );
+	struct DTGModuleCursor *cur = (struct DTGModuleCursor *)cursorID;
+	if( !cur )
+	    return NULL;
+	if( cur->cursorID )
+	{
+	    struct DTGStrList *tmp = 
+		TIMED( cursor_next_defects, ( cur->cursorID, error ) );
+	    struct DTGStrList *res = copy_DTGStrList( tmp );
+	    free_dtg_str_list( tmp );
+	    if( error->message )
+	    {
+	        char *str = error->message;
+	        error->message = strdup( str );
+	        free_char( str );
+	    }
+	    return res;
+	}
+
+	struct DTGStrList *page = cur->rest;
+	struct DTGStrList *last = page;
+	for( int i = 1; last && i < cur->page_size; i++ )
+	    last = last->next;
+	if( last )
+	{
+	    cur->rest = last->next;
+	    last->next = NULL;
+	}
+	else
+	    cur->rest = NULL;
+	return page;
+}
+
+void DTGModule::cursor_free( void *cursorID, struct DTGError *error )
+{
+	clear_DTGError( error );
+	struct DTGModuleCursor *cur = (struct DTGModuleCursor *)cursorID;
+	if( !cur )
+	    return;
+	if( cur->cursorID )
+	{
+	    TIMED( cursor_free, ( cur->cursorID, error ) );
+	    if( error->message )
+	    {
+	        char *str = error->message;
+	        error->message = strdup( str );
+	        free_char( str );
+	    }
+	}
+	if( cur->rest )
+	    delete_DTGStrList( cur->rest );
+	delete cur;
+}
+
 void DTGModule::proj_referenced_fields( void *projID, struct DTGStrList *f )
 {
 	if( projID && f && int_proj_referenced_fields )
-	    int_proj_referenced_fields( projID, f );
+	    TIMED( proj_referenced_fields, ( projID, f ) );
 }
 
 void DTGModule::proj_segment_filters( void *projID, struct DTGFieldDesc *f )
 {
 	if( projID && f && int_proj_segment_filters )
-	    int_proj_segment_filters( projID, f );
+	    TIMED( proj_segment_filters, ( projID, f ) );
 }
 
 struct DTGStrList *DTGModule::proj_find_defects( void *projID, 
@@ -688,8 +935,8 @@ struct DTGStrList *DTGModule::proj_find_defects( void *projID,
 					struct DTGError *error )
 {
 	clear_DTGError( error );
-	struct DTGStrList *tmp = int_proj_find_defects( projID, max_rows,
-							qualification, error );
+	struct DTGStrList *tmp = TIMED( proj_find_defects, ( projID, 
+					max_rows, qualification, error ) );
 	struct DTGStrList *res = copy_DTGStrList( tmp );
 	free_dtg_str_list( tmp );
 	if( error->message )
@@ -701,11 +948,64 @@ struct DTGStrList *DTGModule::proj_find_defects( void *projID,
 	return res;
 }
 
+struct DTGField *DTGModule::proj_find_defect_values( void *projID, 
+					const char *qualification,
+					const char *field,
+					struct DTGError *error )
+{
+	clear_DTGError( error );
+	if( int_proj_find_defect_values )
+	{
+	    struct DTGField *tmp = TIMED( proj_find_defect_values, ( projID, 
+					qualification, field, error ) );
+	    struct DTGField *res = copy_DTGField( tmp );
+	    free_dtg_field( tmp );
+	    if( error->message )
+	    {
+	        char *str = error->message;
+	        error->message = strdup( str );
+	        free_char( str );
+	    }
+	    return res;
+	}
+
+	/* Not defined, read each matching defect instead */
+	if( !int_proj_find_defects )
+	{
+	    set_DTGError( error, "proj_find_defect_values: not supported" );
+	    return NULL;
+	}
+	struct DTGStrList *ids = 
+		proj_find_defects( projID, 0, qualification, error );
+	struct DTGField *res = NULL;
+	struct DTGField *last = NULL;
+	for( struct DTGStrList *id = ids; id && !error->message; id = id->next )
+	{
+	    void *defect = proj_get_defect( projID, id->value, error );
+	    if( !defect )
+	        break;
+	    char *value = defect_get_field( defect, field, error );
+	    struct DTGField *item = new_DTGField( id->value, value );
+	    if( last )
+	        last->next = item;
+	    else
+	        res = item;
+	    last = item;
+	    if( value )
+	        free( value );
+	    struct DTGError *tmp = new_DTGError( NULL );
+	    defect_free( defect, tmp );
+	    delete_DTGError( tmp );
+	}
+	delete_DTGStrList( ids );
+	return res;
+}
+
 struct DTGField *DTGModule::defect_get_fields( void *defectID, 
 					struct DTGError *error )
 {
 	clear_DTGError( error );
-	struct DTGField *tmp = int_defect_get_fields( defectID, error );
+	struct DTGField *tmp = TIMED( defect_get_fields, ( defectID, error ) );
 	struct DTGField *res = copy_DTGField( tmp );
 	free_dtg_field( tmp );
 	if( error->message )
@@ -730,7 +1030,7 @@ char *DTGModule::defect_get_field( void *defectID, const char *field,
 	if( fields )
 	    return strdup( fields->value );
 
-	char *tmp = int_defect_get_field( defectID, field, error );
+	char *tmp = TIMED( defect_get_field, ( defectID, field, error ) );
 	char *res;
 	if( tmp )
 	{
@@ -751,7 +1051,7 @@ char *DTGModule::defect_get_field( void *defectID, const char *field,
 char *DTGModule::defect_save( void *defectID, struct DTGError *error )
 {
 	clear_DTGError( error );
-	char *tmp = int_defect_save( defectID, error );
+	char *tmp = TIMED( defect_save, ( defectID, error ) );
 	char *res;
 	if( tmp )
 	{
@@ -772,7 +1072,7 @@ char *DTGModule::defect_save( void *defectID, struct DTGError *error )
 const char *DTGModule::dt_get_name( struct DTGError *error )
 {
 	clear_DTGError( error );
-	const char *res = int_dt_get_name( error );
+	const char *res = TIMED( dt_get_name, ( error ) );
 	if( error->message )
 	{
 	    char *tmp = error->message;
@@ -785,7 +1085,7 @@ const char *DTGModule::dt_get_name( struct DTGError *error )
 const char *DTGModule::dt_get_module_version( struct DTGError *error )
 {
 	clear_DTGError( error );
-	const char *res = int_dt_get_module_version( error );
+	const char *res = TIMED( dt_get_module_version, ( error ) );
 	if( error->message )
 	{
 	    char *tmp = error->message;
@@ -799,7 +1099,7 @@ const char *DTGModule::dt_get_server_version( void *dtID,
 						struct DTGError *error )
 {
 	clear_DTGError( error );
-	const char *res = int_dt_get_server_version( dtID, error );
+	const char *res = TIMED( dt_get_server_version, ( dtID, error ) );
 	if( error->message )
 	{
 	    char *tmp = error->message;
@@ -839,7 +1139,7 @@ void *DTGModule::dt_connect( const char *server,
 			struct DTGError *error )
 {
 	clear_DTGError( error );
-	void *res = int_dt_connect( server, user, pass, attrs, error );
+	void *res = TIMED( dt_connect, ( server, user, pass, attrs, error ) );
 	if( error->message )
 	{
 	    char *tmp = error->message;
@@ -878,7 +1178,7 @@ void *DTGModule::dt_connect( const char *server,
 void DTGModule::dt_free( void *dtID, struct DTGError *error )
 {
 	clear_DTGError( error );
-	int_dt_free( dtID, error );
+	TIMED( dt_free, ( dtID, error ) );
 	if( error->message )
 	{
 	    char *tmp = error->message;
@@ -887,12 +1187,24 @@ void DTGModule::dt_free( void *dtID, struct DTGError *error )
 	}
 }
 
+void DTGModule::dt_thread_begin()
+{
+	if( int_dt_thread_begin )
+	    int_dt_thread_begin();
+}
+
+void DTGModule::dt_thread_end()
+{
+	if( int_dt_thread_end )
+	    int_dt_thread_end();
+}
+
 void *DTGModule::dt_get_project( void *dtID, 
 				const char *project, 
 				struct DTGError *error )
 {
 	clear_DTGError( error );
-	void *res = int_dt_get_project( dtID, project, error );
+	void *res = TIMED( dt_get_project, ( dtID, project, error ) );
 	if( error->message )
 	{
 	    char *tmp = error->message;
@@ -907,7 +1219,7 @@ void *DTGModule::dt_get_project( void *dtID,
 void DTGModule::proj_free( void *projID, struct DTGError *error )
 {
 	clear_DTGError( error );
-	int_proj_free( projID, error );
+	TIMED( proj_free, ( projID, error ) );
 	if( error->message )
 	{
 	    char *tmp = error->message;
@@ -921,7 +1233,7 @@ void *DTGModule::proj_get_defect( void *projID,
 				struct DTGError *error )
 {
 	clear_DTGError( error );
-	void *res = int_proj_get_defect( projID, defect, error );
+	void *res = TIMED( proj_get_defect, ( projID, defect, error ) );
 	if( error->message )
 	{
 	    char *tmp = error->message;
@@ -931,10 +1243,101 @@ void *DTGModule::proj_get_defect( void *projID,
 	return res;
 }
 
+int DTGModule::proj_get_defects( void *projID, 
+				struct DTGStrList *defects,
+				void **defectIDs,
+				struct DTGError *error )
+{
+	clear_DTGError( error );
+	if( int_proj_get_defects )
+	{
+	    int res = TIMED( proj_get_defects, 
+				( projID, defects, defectIDs, error ) );
+	    if( error->message )
+	    {
+	        char *tmp = error->message;
+	        error->message = strdup( tmp );
+	        free_char( tmp );
+	    }
+	    return res;
+	}
+
+	/* Not defined, load each defect instead */
+	int res = 0;
+	int i = 0;
+	struct DTGStrList *d;
+	for( d = defects; d; d = d->next )
+	    defectIDs[i++] = NULL;
+	i = 0;
+	for( d = defects; d; d = d->next, i++ )
+	{
+	    defectIDs[i] = proj_get_defect( projID, d->value, error );
+	    if( !error->message )
+	    {
+	        res++;
+	        continue;
+	    }
+
+	    // Left for proj_get_defect to report
+	    int can_continue = error->can_continue;
+	    if( defectIDs[i] )
+	        defect_free( defectIDs[i], error );
+	    defectIDs[i] = NULL;
+	    clear_DTGError( error );
+	    if( !can_continue )
+	        break;
+	}
+	return res;
+}
+
+int DTGModule::proj_save_defects( void *projID, int count,
+				void **defectIDs,
+				char **ids,
+				struct DTGError *errors )
+{
+	int i;
+	for( i = 0; i < count; i++ )
+	{
+	    clear_DTGError( &errors[i] );
+	    ids[i] = NULL;
+	}
+	if( !int_proj_save_defects )
+	{
+	    /* Not defined, save each defect instead */
+	    int res = 0;
+	    for( i = 0; i < count; i++ )
+	    {
+	        ids[i] = defect_save( defectIDs[i], &errors[i] );
+	        if( !errors[i].message )
+	            res++;
+	    }
+	    return res;
+	}
+
+	int res = TIMED( proj_save_defects, 
+				( projID, count, defectIDs, ids, errors ) );
+	for( i = 0; i < count; i++ )
+	{
+	    char *tmp = ids[i];
+	    if( tmp )
+	    {
+	        ids[i] = strdup( tmp );
+	        free_char( tmp );
+	    }
+	    if( errors[i].message )
+	    {
+	        tmp = errors[i].message;
+	        errors[i].message = strdup( tmp );
+	        free_char( tmp );
+	    }
+	}
+	return res;
+}
+
 void *DTGModule::proj_new_defect( void *projID, struct DTGError *error )
 {
 	clear_DTGError( error );
-	void *res = int_proj_new_defect( projID, error );
+	void *res = TIMED( proj_new_defect, ( projID, error ) );
 	if( error->message )
 	{
 	    char *tmp = error->message;
@@ -947,7 +1350,7 @@ void *DTGModule::proj_new_defect( void *projID, struct DTGError *error )
 void DTGModule::defect_free( void *defectID, struct DTGError *error )
 {
 	clear_DTGError( error );
-	int_defect_free( defectID, error );
+	TIMED( defect_free, ( defectID, error ) );
 	if( error->message )
 	{
 	    char *tmp = error->message;
@@ -962,7 +1365,7 @@ void DTGModule::defect_set_field( void *defectID,
 				struct DTGError *error )
 {
 	clear_DTGError( error );
-	int_defect_set_field( defectID, name, value, error );
+	TIMED( defect_set_field, ( defectID, name, value, error ) );
 	if( error->message )
 	{
 	    char *tmp = error->message;
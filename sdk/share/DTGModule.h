@@ -20,6 +20,81 @@
 #define DTGSDDCIF_HEADER
 
 #include <DTG-typedefs.h>
+#include <atomic>
+#include <chrono>
+
+/*
+	Call counts and latencies of the plug-in interface, kept once
+	DTGModule::enable_stats() is called. hist[ftn][i] counts the calls
+	taking under 2^i microseconds; the last bucket takes the rest.
+*/
+
+struct DTGCallCounts {
+	static const int BUCKETS = 24;
+	long calls;
+	long long usecs;
+	long max_usecs;
+	long hist[BUCKETS];
+};
+
+class DTGCallStats {
+    public:
+	enum {	extract_date, format_date, dt_get_server_warnings,
+		dt_get_message, dt_accept_utf8, dt_server_offline,
+		dt_get_server_date, dt_list_projects, proj_list_fields,
+		proj_list_fixes, proj_describe_fix, proj_describe_fixes,
+		proj_list_changed_defects, proj_open_changed_defects,
+		cursor_next_defects, cursor_free, proj_find_defects,
+		proj_find_defect_values, proj_referenced_fields,
+		proj_segment_filters, defect_get_fields, defect_get_field,
+		defect_save, dt_get_name, dt_get_module_version,
+		dt_get_server_version, dt_connect, dt_free, dt_get_project,
+		proj_free, proj_get_defect, proj_get_defects, 
+		proj_save_defects, proj_new_defect, defect_free,
+		defect_set_field, dt_list_attrs, dt_validate_attr,
+		CALLS };
+	static const char *names[CALLS];
+
+    protected:
+	std::atomic<long> calls[CALLS];
+	std::atomic<long long> usecs[CALLS];
+	std::atomic<long> max_usecs[CALLS];
+	std::atomic<long> hist[CALLS][DTGCallCounts::BUCKETS];
+
+	void record( int ftn, long usec );
+
+	// Records the call when it goes out of scope
+	class Timer {
+	    public:
+		DTGCallStats *stats;
+		int ftn;
+		std::chrono::steady_clock::time_point start;
+
+		Timer( DTGCallStats *s, int f )
+		{
+		    stats = s;
+		    ftn = f;
+		    start = std::chrono::steady_clock::now();
+		}
+		~Timer()
+		{
+		    stats->record( ftn, (long)
+			std::chrono::duration_cast<std::chrono::microseconds>(
+			    std::chrono::steady_clock::now() - start ).count() );
+		}
+	};
+
+    public:
+	DTGCallStats();
+
+	template <class F> auto timed( int ftn, F call ) -> decltype( call() )
+	{
+	    Timer t( this, ftn );
+	    return call();
+	}
+
+	void read( int ftn, struct DTGCallCounts *counts );
+};
 
 class DTGModule {
 
@@ -32,6 +107,8 @@ class DTGModule {
 	static const int MAX_ERR_MSG = 1000;
 	char last_error[MAX_ERR_MSG + 1];
 
+	DTGCallStats *stats;	// NULL unless enable_stats()
+
     protected:
 	void *load_function( const char *ftn_name );
 	void record_error( const char *ftn, const char *error );
@@ -47,6 +124,7 @@ class DTGModule {
 	proj_describe_fix_ftn *int_proj_describe_fix;
 	proj_list_changed_defects_ftn *int_proj_list_changed_defects;
 	proj_find_defects_ftn *int_proj_find_defects;
+	proj_find_defect_values_ftn *int_proj_find_defect_values;
 	defect_get_fields_ftn *int_defect_get_fields;
 	defect_get_field_ftn *int_defect_get_field;
 	defect_save_ftn *int_defect_save;
@@ -71,10 +149,21 @@ class DTGModule {
 	dt_get_message_ftn *int_dt_get_message;
 	proj_referenced_fields_ftn *int_proj_referenced_fields;
 	proj_segment_filters_ftn *int_proj_segment_filters;
+	proj_get_defects_ftn *int_proj_get_defects;
+	proj_save_defects_ftn *int_proj_save_defects;
+	proj_describe_fixes_ftn *int_proj_describe_fixes;
+	proj_open_changed_defects_ftn *int_proj_open_changed_defects;
+	cursor_next_defects_ftn *int_cursor_next_defects;
+	cursor_free_ftn *int_cursor_free;
+	dt_thread_begin_ftn *int_dt_thread_begin;
+	dt_thread_end_ftn *int_dt_thread_end;
 
     public:
 	int has_perforce_extensions();
 	int has_attribute_extensions();
+	int has_bulk_extensions();
+	int has_bulk_save();
+	int has_bulk_describe();
 
 	struct DTGDate *extract_date( const char *date_string );
 	char *format_date( struct DTGDate *date );
@@ -94,6 +183,9 @@ class DTGModule {
 	struct DTGFixDesc *proj_describe_fix( void *projID, 
 					const char *fixid,
 					struct DTGError *error );
+	int proj_describe_fixes( void *projID, struct DTGStrList *fixids,
+					struct DTGFixDesc **fixes,
+					struct DTGError *error );
 	struct DTGStrList *proj_list_changed_defects( void *projID, 
 					int max_rows,
 					struct DTGDate *since, 
@@ -101,10 +193,24 @@ class DTGModule {
 					const char *mod_by_field,
 					const char *exclude_mod_user,
 					struct DTGError *error );
+	void *proj_open_changed_defects( void *projID, 
+					int page_size,
+					struct DTGDate *since, 
+					const char *mod_date_field,
+					const char *mod_by_field,
+					const char *exclude_mod_user,
+					struct DTGError *error );
+	struct DTGStrList *cursor_next_defects( void *cursorID,
+					struct DTGError *error );
+	void cursor_free( void *cursorID, struct DTGError *error );
 	struct DTGStrList *proj_find_defects( void *projID, 
 					int max_rows,
 					const char *qualification,
 					struct DTGError *error );
+	struct DTGField *proj_find_defect_values( void *projID, 
+					const char *qualification,
+					const char *field,
+					struct DTGError *error );
 	void proj_referenced_fields( void *projID, struct DTGStrList *fields );
 	void proj_segment_filters( void *projID, struct DTGFieldDesc *filters );
 	struct DTGField *defect_get_fields( void *defectID, 
@@ -121,11 +227,18 @@ class DTGModule {
 					const struct DTGField *attrs,
 					struct DTGError *error );
 	void dt_free( void *dtID, struct DTGError *error );
+	void dt_thread_begin();
+	void dt_thread_end();
 	void *dt_get_project( void *dtID, const char *project,
 					struct DTGError *error );
 	void proj_free( void *projID, struct DTGError *error );
 	void *proj_get_defect( void *projID, const char *defect,
 					struct DTGError *error );
+	int proj_get_defects( void *projID, struct DTGStrList *defects,
+					void **defectIDs,
+					struct DTGError *error );
+	int proj_save_defects( void *projID, int count, void **defectIDs,
+					char **ids, struct DTGError *errors );
 	void *proj_new_defect( void *projID, struct DTGError *error );
 	void defect_free( void *defectID, struct DTGError *error );
 	void defect_set_field( void *defectID,
@@ -150,6 +263,7 @@ class DTGModule {
 	~DTGModule();
 
 	void test_module();
+	void enable_stats();
 
     private:
 	struct DTGField *pseudo_attrs;
@@ -324,9 +324,13 @@ struct DTGStrList *remove_DTGStrList( struct DTGStrList *base,
 struct DTGStrList *copy_DTGStrList( const struct DTGStrList *list )
 {
 	struct DTGStrList *dup = NULL;
+	struct DTGStrList **last = &dup;
 	const struct DTGStrList *tmp;
 	for( tmp = list; tmp; tmp = tmp->next )
-	    dup = append_DTGStrList( dup, tmp->value );
+	{
+	    *last = new_DTGStrList( tmp->value );
+	    last = &(*last)->next;
+	}
 	return dup;
 }
 
@@ -85,6 +85,8 @@ struct DTGStrList *smart_split_DTGStrList( const char *txt, char sep );
 char *join_DTGStrList( struct DTGStrList *list, const char *sep );
 struct DTGStrList *remove_DTGStrList( struct DTGStrList *list, 
 					struct DTGStrList *rem );
+struct DTGStrList *remove_item_DTGStrList( struct DTGStrList *list, 
+					const char *item );
 struct DTGStrList *purge_DTGStrList( struct DTGStrList *list );
 int in_DTGStrList( const char *item, struct DTGStrList *list );
 
@@ -0,0 +1,427 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+extern "C" {
+#include <dtg-utils.h>
+}
+#include "CycleJournal.h"
+#include "Logger.h"
+#include <genutils.h>
+
+/*
+	Journal format, one record per line:
+		P4DTG-CYCLE 1			header
+		S\t<since scm>\t<since dts>\t<scm date>\t<dts date>\t<force>
+		D\t<id>				DTS defect unified
+		C\t<id>				SCM defect unified
+		R\t<id>				SCM defect to retry
+		F\t<id>\t<message>		SCM defect failed
+		E				retries done
+	Dates are YYYY/MM/DD HH:MM:SS. Tabs, newlines and backslashes in
+	a message are escaped with a backslash and long messages cut. A last line without its
+	newline is an interrupted write and is ignored.
+*/
+
+static const char *JOURNAL_HEADER = "P4DTG-CYCLE 1";
+static const int JOURNAL_LINE = 4096;
+static const int JOURNAL_MSG = 1024;	// message characters kept
+
+static int valid_id( const char *id )
+{
+	return id && *id && strlen( id ) < JOURNAL_MSG && 
+		!strpbrk( id, "\t\r\n" );
+}
+
+static void put_date( FILE *out, struct DTGDate *d )
+{
+	fprintf( out, "\t%4.4d/%2.2d/%2.2d %2.2d:%2.2d:%2.2d",
+		d->year, d->month, d->day, d->hour, d->minute, d->second );
+}
+
+static struct DTGDate *get_date( const char *str )
+{
+	int y, mo, d, h, mi, s;
+	if( !str || sscanf( str, "%d/%d/%d %d:%d:%d",
+			&y, &mo, &d, &h, &mi, &s ) != 6 )
+	    return NULL;
+	return new_DTGDate( y, mo, d, h, mi, s );
+}
+
+static void put_escaped( FILE *out, const char *msg )
+{
+	for( int i = 0; *msg && i < JOURNAL_MSG; msg++, i++ )
+	    switch( *msg )
+	    {
+	    case '\\': fputs( "\\\\", out ); break;
+	    case '\t': fputs( "\\t", out ); break;
+	    case '\n': fputs( "\\n", out ); break;
+	    case '\r': fputs( "\\r", out ); break;
+	    default: fputc( *msg, out ); break;
+	    }
+}
+
+static void unescape( char *msg )
+{
+	char *out = msg;
+	for( ; *msg; msg++ )
+	    if( *msg == '\\' && msg[1] )
+	        switch( *++msg )
+	        {
+	        case 't': *out++ = '\t'; break;
+	        case 'n': *out++ = '\n'; break;
+	        case 'r': *out++ = '\r'; break;
+	        default: *out++ = *msg; break;
+	        }
+	    else
+	        *out++ = *msg;
+	*out = '\0';
+}
+
+CycleJournal::CycleJournal( const char *path, Logger *my_log )
+{
+	size = 1024;
+	count = 0;
+	buckets = new Entry *[size];
+	memset( buckets, 0, sizeof(Entry *) * size );
+	since_scm = since_dts = scm_date = dts_date = NULL;
+	force = 0;
+	recheck = NULL;
+	failed = NULL;
+	recheck_cnt = failed_cnt = 0;
+	file = cp_string( path );
+	fd = NULL;
+	log = my_log;
+}
+
+CycleJournal::~CycleJournal()
+{
+	if( fd )
+	    fclose( fd );
+	clear();
+	delete[] buckets;
+	delete[] file;
+}
+
+unsigned int CycleJournal::hash( char phase, const char *id )
+{
+	unsigned int h = ( 2166136261u ^ (unsigned char)phase ) * 16777619u;
+	for( ; *id; id++ )
+	    h = ( h ^ (unsigned char)*id ) * 16777619u;
+	return h;
+}
+
+int CycleJournal::done( char phase, const char *id )
+{
+	if( !count || !id )
+	    return 0;
+	for( Entry *e = buckets[hash( phase, id ) % size]; e; e = e->next )
+	    if( e->phase == phase && !strcmp( e->id, id ) )
+	        return 1;
+	return 0;
+}
+
+void CycleJournal::insert( char phase, const char *id )
+{
+	if( done( phase, id ) )
+	    return;
+
+	if( count >= size )
+	{
+	    // Grow and rehash
+	    int new_size = size * 2;
+	    Entry **table = new Entry *[new_size];
+	    memset( table, 0, sizeof(Entry *) * new_size );
+	    for( int i = 0; i < size; i++ )
+	        while( buckets[i] )
+	        {
+	            Entry *item = buckets[i];
+	            buckets[i] = item->next;
+	            unsigned int b = hash( item->phase, item->id ) % new_size;
+	            item->next = table[b];
+	            table[b] = item;
+	        }
+	    delete[] buckets;
+	    buckets = table;
+	    size = new_size;
+	}
+
+	unsigned int b = hash( phase, id ) % size;
+	Entry *e = new Entry;
+	e->phase = phase;
+	e->id = cp_string( id );
+	e->next = buckets[b];
+	buckets[b] = e;
+	count++;
+}
+
+void CycleJournal::clear()
+{
+	for( int i = 0; i < size; i++ )
+	    while( buckets[i] )
+	    {
+	        Entry *item = buckets[i];
+	        buckets[i] = item->next;
+	        delete[] item->id;
+	        delete item;
+	    }
+	count = 0;
+
+	delete_DTGDate( since_scm );
+	delete_DTGDate( since_dts );
+	delete_DTGDate( scm_date );
+	delete_DTGDate( dts_date );
+	since_scm = since_dts = scm_date = dts_date = NULL;
+	delete_DTGStrList( recheck );
+	delete_DTGField( failed );
+	recheck = NULL;
+	failed = NULL;
+}
+
+/* Returns 0 when there is no cycle on disk to resume */
+
+int CycleJournal::load()
+{
+	clear();
+	FILE *in = fopen( file, "r" );
+	if( !in )
+	    return 0;
+
+	char *line = new char[JOURNAL_LINE];
+	if( !fgets( line, JOURNAL_LINE, in ) ||
+	    strncmp( line, JOURNAL_HEADER, strlen( JOURNAL_HEADER ) ) )
+	{
+	    log->log( 0, "Error: Ignoring unrecognized journal: %s", file );
+	    fclose( in );
+	    delete[] line;
+	    return 0;
+	}
+	while( fgets( line, JOURNAL_LINE, in ) )
+	{
+	    int len = strlen( line );
+	    if( !len || line[len - 1] != '\n' )
+	        break; // interrupted write or corrupt record
+	    line[len - 1] = '\0';
+
+	    struct DTGStrList *cols = split_DTGStrList( line, '\t' );
+	    struct DTGStrList *id = cols ? cols->next : NULL;
+	    switch( *line )
+	    {
+	    case 'S':
+	        if( since_scm )
+	            break; // one cycle per journal
+	        {
+	            struct DTGStrList *c = id;
+	            since_scm = get_date( c ? c->value : NULL );
+	            c = c ? c->next : NULL;
+	            since_dts = get_date( c ? c->value : NULL );
+	            c = c ? c->next : NULL;
+	            scm_date = get_date( c ? c->value : NULL );
+	            c = c ? c->next : NULL;
+	            dts_date = get_date( c ? c->value : NULL );
+	            c = c ? c->next : NULL;
+	            force = c ? atoi( c->value ) : 0;
+	        }
+	        break;
+	    case DTS:
+	    case SCM:
+	        if( id && valid_id( id->value ) )
+	            insert( *line, id->value );
+	        break;
+	    case 'R':
+	        if( id && valid_id( id->value ) &&
+		    !in_DTGStrList( id->value, recheck ) )
+	            recheck = append_DTGStrList( recheck, id->value );
+	        break;
+	    case 'F':
+	        if( id && valid_id( id->value ) )
+	        {
+	            char *msg = strchr( &line[2], '\t' );
+	            msg = msg ? &msg[1] : &line[len - 1];
+	            unescape( msg );
+	            failed = append_DTGField( failed,
+				new_DTGField( id->value, msg ) );
+	        }
+	        break;
+	    case 'E':
+	        delete_DTGStrList( recheck );
+	        recheck = NULL;
+	        break;
+	    }
+	    delete_DTGStrList( cols );
+	}
+	fclose( in );
+	delete[] line;
+
+	if( !since_scm || !since_dts || !scm_date || !dts_date )
+	{
+	    clear();
+	    return 0;
+	}
+	return 1;
+}
+
+/*
+	Starts a cycle over the changes since since_scm and since_dts. When
+	the journal holds that cycle, returns 1 with scm_date and dts_date
+	set to the dates it captured and any journaled retries and failures
+	given back in empty lists. Otherwise starts a new journal and
+	returns 0.
+*/
+
+int CycleJournal::begin( struct DTGDate *in_since_scm,
+			struct DTGDate *in_since_dts, int in_force,
+			struct DTGDate *in_scm_date, struct DTGDate *in_dts_date,
+			struct DTGStrList *&in_recheck,
+			struct DTGField *&in_failed )
+{
+	if( since_scm &&
+	    !compare_DTGDate( since_scm, in_since_scm ) &&
+	    !compare_DTGDate( since_dts, in_since_dts ) &&
+	    force == ( in_force != 0 ) )
+	{
+	    set_DTGDate( in_scm_date, scm_date );
+	    set_DTGDate( in_dts_date, dts_date );
+	    if( !in_recheck )
+	    {
+	        in_recheck = recheck;
+	        recheck = NULL;
+	        recheck_cnt = 0;
+	        for( struct DTGStrList *r = in_recheck; r; r = r->next )
+	            recheck_cnt++;
+	    }
+	    if( !in_failed )
+	    {
+	        in_failed = failed;
+	        failed = NULL;
+	        failed_cnt = 0;
+	        for( struct DTGField *f = in_failed; f; f = f->next )
+	            failed_cnt++;
+	    }
+	    if( !fd )
+	        fd = fopen( file, "a" );
+	    return 1;
+	}
+
+	clear();
+	since_scm = copy_DTGDate( in_since_scm );
+	since_dts = copy_DTGDate( in_since_dts );
+	scm_date = copy_DTGDate( in_scm_date );
+	dts_date = copy_DTGDate( in_dts_date );
+	force = in_force != 0;
+	recheck_cnt = failed_cnt = 0;
+
+	if( fd )
+	    fclose( fd );
+	fd = fopen( file, "w" );
+	if( !fd )
+	{
+	    log->log( 0, "Error: Unable to write journal: %s", file );
+	    return 0;
+	}
+	fprintf( fd, "%s\nS", JOURNAL_HEADER );
+	put_date( fd, since_scm );
+	put_date( fd, since_dts );
+	put_date( fd, scm_date );
+	put_date( fd, dts_date );
+	fprintf( fd, "\t%d\n", force );
+	fflush( fd );
+	return 0;
+}
+
+void CycleJournal::write_line( char type, const char *id, const char *msg )
+{
+	if( !fd )
+	    return;
+	fprintf( fd, "%c\t%s", type, id );
+	if( msg )
+	{
+	    fputc( '\t', fd );
+	    put_escaped( fd, msg );
+	}
+	fputc( '\n', fd );
+}
+
+/* Removes the defects already unified this cycle from list */
+
+struct DTGStrList *CycleJournal::skip_done( char phase,
+					struct DTGStrList *list )
+{
+	if( !count )
+	    return list;
+	struct DTGStrList **p = &list;
+	while( *p )
+	    if( done( phase, (*p)->value ) )
+	    {
+	        struct DTGStrList *item = *p;
+	        *p = item->next;
+	        item->next = NULL;
+	        delete_DTGStrList( item );
+	    }
+	    else
+	        p = &(*p)->next;
+	return list;
+}
+
+/* Journals the defects from up to, not including, to as unified */
+
+void CycleJournal::record( char phase, struct DTGStrList *from,
+				struct DTGStrList *to )
+{
+	for( struct DTGStrList *d = from; d && d != to; d = d->next )
+	    if( valid_id( d->value ) )
+	    {
+	        insert( phase, d->value );
+	        write_line( phase, d->value );
+	    }
+}
+
+/* Journals the retries and failures added since the last call */
+
+void CycleJournal::record_lists( struct DTGStrList *in_recheck,
+				struct DTGField *in_failed )
+{
+	int i = 0;
+	for( struct DTGStrList *r = in_recheck; r; r = r->next, i++ )
+	    if( i >= recheck_cnt && valid_id( r->value ) )
+	        write_line( 'R', r->value );
+	if( i > recheck_cnt )
+	    recheck_cnt = i;
+
+	i = 0;
+	for( struct DTGField *f = in_failed; f; f = f->next, i++ )
+	    if( i >= failed_cnt && valid_id( f->name ) )
+	        write_line( 'F', f->name, f->value ? f->value : "" );
+	if( i > failed_cnt )
+	    failed_cnt = i;
+}
+
+void CycleJournal::end_recheck()
+{
+	recheck_cnt = 0;
+	if( fd )
+	    fprintf( fd, "E\n" );
+}
+
+void CycleJournal::checkpoint()
+{
+	if( fd )
+	    fflush( fd );
+}
@@ -0,0 +1,94 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CYCLEJOURNAL_HEADER
+#define CYCLEJOURNAL_HEADER
+
+#include <stdio.h>
+
+class Logger;
+struct DTGDate;
+struct DTGStrList;
+struct DTGField;
+
+/*
+	Progress of the current replication cycle of one map, journaled
+	to repl/cycle-<map> as each page of defects is finished. A cycle
+	begun with the same watermarks as the journal is resuming it: it
+	keeps the server dates the journal captured, so it covers the
+	same window, skips the defects already unified and takes back the
+	retry and failure lists. Anything changed after those dates is
+	picked up by the next cycle as usual.
+*/
+
+class CycleJournal {
+    public:
+	enum Phase { DTS = 'D', SCM = 'C' };
+
+    protected:
+	struct Entry {
+	    char phase;
+	    char *id;
+	    Entry *next;
+	};
+
+	Entry **buckets;
+	int size;
+	int count;
+
+	struct DTGDate *since_scm;
+	struct DTGDate *since_dts;
+	struct DTGDate *scm_date;
+	struct DTGDate *dts_date;
+	int force;
+
+	struct DTGStrList *recheck;	// as read from the journal
+	struct DTGField *failed;
+	int recheck_cnt;		// entries of each list journaled
+	int failed_cnt;
+
+	char *file;
+	FILE *fd;
+	Logger *log;
+
+	unsigned int hash( char phase, const char *id );
+	void insert( char phase, const char *id );
+	void clear();
+	void write_line( char type, const char *id, const char *msg = NULL );
+
+    public:
+	CycleJournal( const char *path, Logger *log );
+	~CycleJournal();
+
+	int load();
+	int begin( struct DTGDate *since_scm, struct DTGDate *since_dts,
+		int force, struct DTGDate *scm_date, struct DTGDate *dts_date,
+		struct DTGStrList *&recheck, struct DTGField *&failed );
+	int entries() { return count; };
+
+	int done( char phase, const char *id );
+	struct DTGStrList *skip_done( char phase, struct DTGStrList *list );
+	void record( char phase, struct DTGStrList *from,
+			struct DTGStrList *to );
+	void record_lists( struct DTGStrList *recheck,
+			struct DTGField *failed );
+	void end_recheck();
+	void checkpoint();
+};
+
+#endif
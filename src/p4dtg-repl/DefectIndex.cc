@@ -0,0 +1,332 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+extern "C" {
+#include <dtg-utils.h>
+}
+#include "DefectIndex.h"
+#include "Logger.h"
+#include <genutils.h>
+
+/*
+	Journal format, one record per line:
+		P4DTG-INDEX 1		header
+		+<dts id>\t<scm id>	add or replace
+		-<dts id>		remove
+	A last line without its newline is an interrupted write; it and
+	any malformed record fail the load so the index is rebuilt.
+*/
+
+static const char *INDEX_HEADER = "P4DTG-INDEX 1";
+static const int INDEX_LINE = 1024;
+
+static int valid_id( const char *id )
+{
+	return id && *id && !strpbrk( id, "\t\r\n" );
+}
+
+/* Flush fd through to the disk, returns 0 on failure */
+
+static int sync_file( FILE *fd )
+{
+	if( fflush( fd ) )
+	    return 0;
+#ifdef _WIN32
+	return !_commit( _fileno( fd ) );
+#else
+	return !fsync( fileno( fd ) );
+#endif
+}
+
+DefectIndex::DefectIndex( const char *path, Logger *my_log )
+{
+	size = 1024;
+	count = 0;
+	records = 0;
+	buckets = new Entry *[size];
+	memset( buckets, 0, sizeof(Entry *) * size );
+	file = cp_string( path );
+	fd = NULL;
+	log = my_log;
+}
+
+DefectIndex::~DefectIndex()
+{
+	if( fd )
+	    fclose( fd );
+	clear();
+	delete[] buckets;
+	delete[] file;
+}
+
+unsigned int DefectIndex::hash( const char *id )
+{
+	unsigned int h = 2166136261u;
+	for( ; *id; id++ )
+	    h = ( h ^ (unsigned char)*id ) * 16777619u;
+	return h;
+}
+
+DefectIndex::Entry *DefectIndex::lookup( const char *dts_id )
+{
+	for( Entry *e = buckets[hash( dts_id ) % size]; e; e = e->next )
+	    if( !strcmp( e->dts_id, dts_id ) )
+	        return e;
+	return NULL;
+}
+
+void DefectIndex::insert( const char *dts_id, const char *scm_id )
+{
+	Entry *e = lookup( dts_id );
+	if( e )
+	{
+	    delete[] e->scm_id;
+	    e->scm_id = cp_string( scm_id );
+	    return;
+	}
+
+	if( count >= size )
+	{
+	    // Grow and rehash
+	    int new_size = size * 2;
+	    Entry **table = new Entry *[new_size];
+	    memset( table, 0, sizeof(Entry *) * new_size );
+	    for( int i = 0; i < size; i++ )
+	        while( buckets[i] )
+	        {
+	            Entry *item = buckets[i];
+	            buckets[i] = item->next;
+	            unsigned int b = hash( item->dts_id ) % new_size;
+	            item->next = table[b];
+	            table[b] = item;
+	        }
+	    delete[] buckets;
+	    buckets = table;
+	    size = new_size;
+	}
+
+	unsigned int b = hash( dts_id ) % size;
+	e = new Entry;
+	e->dts_id = cp_string( dts_id );
+	e->scm_id = cp_string( scm_id );
+	e->next = buckets[b];
+	buckets[b] = e;
+	count++;
+}
+
+int DefectIndex::erase( const char *dts_id )
+{
+	for( Entry **e = &buckets[hash( dts_id ) % size]; *e; e = &(*e)->next )
+	    if( !strcmp( (*e)->dts_id, dts_id ) )
+	    {
+	        Entry *item = *e;
+	        *e = item->next;
+	        delete[] item->dts_id;
+	        delete[] item->scm_id;
+	        delete item;
+	        count--;
+	        return 1;
+	    }
+	return 0;
+}
+
+void DefectIndex::clear()
+{
+	for( int i = 0; i < size; i++ )
+	    while( buckets[i] )
+	    {
+	        Entry *item = buckets[i];
+	        buckets[i] = item->next;
+	        delete[] item->dts_id;
+	        delete[] item->scm_id;
+	        delete item;
+	    }
+	count = 0;
+}
+
+void DefectIndex::append( const char *dts_id, const char *scm_id )
+{
+	if( !fd )
+	    return;
+	if( scm_id )
+	    fprintf( fd, "+%s\t%s\n", dts_id, scm_id );
+	else
+	    fprintf( fd, "-%s\n", dts_id );
+	fflush( fd );
+	records++;
+}
+
+/* Write out the live entries and replace the journal with them */
+
+int DefectIndex::rewrite()
+{
+	if( fd )
+	    fclose( fd );
+	fd = NULL;
+
+	char *tmp_file = mk_string( file, ".tmp" );
+	FILE *out = fopen( tmp_file, "w" );
+	if( !out )
+	{
+	    log->log( 0, "Error: Unable to write index: %s", tmp_file );
+	    delete[] tmp_file;
+	    return 0;
+	}
+	fprintf( out, "%s\n", INDEX_HEADER );
+	for( int i = 0; i < size; i++ )
+	    for( Entry *e = buckets[i]; e; e = e->next )
+	        fprintf( out, "+%s\t%s\n", e->dts_id, e->scm_id );
+	int failed = ferror( out ) || !sync_file( out );
+	if( fclose( out ) || failed )
+	{
+	    log->log( 0, "Error: Unable to write index: %s", tmp_file );
+	    unlink( tmp_file );
+	    delete[] tmp_file;
+	    return 0;
+	}
+#ifdef _WIN32
+	unlink( file );
+#endif
+	if( rename( tmp_file, file ) )
+	{
+	    log->log( 0, "Error: Unable to replace index: %s", file );
+	    unlink( tmp_file );
+	    delete[] tmp_file;
+	    return 0;
+	}
+	delete[] tmp_file;
+	records = count;
+	fd = fopen( file, "a" );
+	return fd != NULL;
+}
+
+/* Returns 0 when there is no usable index on disk */
+
+int DefectIndex::load()
+{
+	std::lock_guard<std::mutex> guard( lock );
+	clear();
+	records = 0;
+	FILE *in = fopen( file, "r" );
+	if( !in )
+	    return 0;
+
+	char line[INDEX_LINE];
+	if( !fgets( line, INDEX_LINE, in ) ||
+	    strncmp( line, INDEX_HEADER, strlen( INDEX_HEADER ) ) )
+	{
+	    log->log( 0, "Error: Ignoring unrecognized index: %s", file );
+	    fclose( in );
+	    return 0;
+	}
+	int valid = 1;
+	while( valid && fgets( line, INDEX_LINE, in ) )
+	{
+	    int len = strlen( line );
+	    if( !len || line[len - 1] != '\n' )
+	    {
+	        valid = 0; // interrupted write or overlong record
+	        break;
+	    }
+	    line[len - 1] = '\0';
+	    records++;
+	    char *tab = strchr( line, '\t' );
+	    if( *line == '+' && tab )
+	    {
+	        *tab = '\0';
+	        insert( &line[1], &tab[1] );
+	    }
+	    else if( *line == '-' && !tab && line[1] )
+	        erase( &line[1] );
+	    else
+	        valid = 0;
+	}
+	fclose( in );
+	if( !valid )
+	{
+	    // What was read stays as hints until the index is rebuilt
+	    log->log( 0, "Error: Index damaged, must be rebuilt: %s", file );
+	    return 0;
+	}
+
+	// Compact once the journal is mostly replaced entries
+	if( records > 2 * count + 1024 )
+	    return rewrite();
+
+	fd = fopen( file, "a" );
+	return fd != NULL;
+}
+
+/* Replace the index with the DTG_DTISSUE values (name: scm, value: dts) */
+
+int DefectIndex::rebuild( struct DTGField *pairs )
+{
+	std::lock_guard<std::mutex> guard( lock );
+	clear();
+	for( struct DTGField *p = pairs; p; p = p->next )
+	    if( valid_id( p->name ) && valid_id( p->value ) )
+	        insert( p->value, p->name );
+	return rewrite();
+}
+
+/* Make the entries journaled so far durable, at each cycle checkpoint */
+
+void DefectIndex::sync()
+{
+	std::lock_guard<std::mutex> guard( lock );
+	if( fd && !sync_file( fd ) )
+	    log->log( 0, "Error: Unable to sync index: %s", file );
+}
+
+char *DefectIndex::find( const char *dts_id )
+{
+	if( !dts_id )
+	    return NULL;
+	std::lock_guard<std::mutex> guard( lock );
+	Entry *e = lookup( dts_id );
+	return e ? cp_string( e->scm_id ) : NULL;
+}
+
+void DefectIndex::add( const char *dts_id, const char *scm_id )
+{
+	if( !valid_id( dts_id ) || !valid_id( scm_id ) )
+	    return;
+	std::lock_guard<std::mutex> guard( lock );
+	Entry *e = lookup( dts_id );
+	if( e && !strcmp( e->scm_id, scm_id ) )
+	    return;
+	insert( dts_id, scm_id );
+	append( dts_id, scm_id );
+}
+
+void DefectIndex::remove( const char *dts_id )
+{
+	if( !dts_id )
+	    return;
+	std::lock_guard<std::mutex> guard( lock );
+	if( erase( dts_id ) )
+	    append( dts_id, NULL );
+}
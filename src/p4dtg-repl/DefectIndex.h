@@ -0,0 +1,77 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DEFECTINDEX_HEADER
+#define DEFECTINDEX_HEADER
+
+#include <stdio.h>
+#include <mutex>
+
+class Logger;
+struct DTGField;
+
+/*
+	Maps DTS issue ids to the SCM defect replicating them for one map.
+	Kept in memory as a hash table and on disk as an append-only
+	journal (repl/index-<map>), synced at each cycle checkpoint; a
+	journal damaged by a crash is rebuilt from the SCM. Entries are hints: the caller confirms DTG_DTISSUE on the
+	SCM defect before trusting one and falls back to searching the SCM
+	on a miss, so a lost or stale entry only costs a query.
+*/
+
+class DefectIndex {
+    protected:
+	struct Entry {
+	    char *dts_id;
+	    char *scm_id;
+	    Entry *next;
+	};
+
+	Entry **buckets;
+	int size;
+	int count;
+	int records;	// journal lines, live or not
+
+	char *file;
+	FILE *fd;
+	Logger *log;
+	std::mutex lock;
+
+	unsigned int hash( const char *id );
+	Entry *lookup( const char *dts_id );
+	void insert( const char *dts_id, const char *scm_id );
+	int erase( const char *dts_id );
+	void clear();
+	void append( const char *dts_id, const char *scm_id );
+	int rewrite();
+
+    public:
+	DefectIndex( const char *path, Logger *log );
+	~DefectIndex();
+
+	int load();
+	int rebuild( struct DTGField *pairs );
+	void sync();
+	int entries() { return count; };
+
+	char *find( const char *dts_id );
+	void add( const char *dts_id, const char *scm_id );
+	void remove( const char *dts_id );
+};
+
+#endif
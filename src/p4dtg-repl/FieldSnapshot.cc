@@ -0,0 +1,129 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <DTGModule.h>
+extern "C" {
+#include <dtg-utils.h>
+}
+#include "FieldSnapshot.h"
+#include <genutils.h>
+
+FieldSnapshot::FieldSnapshot( DTGModule *my_mod )
+{
+	mod = my_mod;
+	defects = NULL;
+}
+
+FieldSnapshot::~FieldSnapshot()
+{
+	clear();
+}
+
+FieldSnapshot::Defect *FieldSnapshot::find( void *defectID )
+{
+	for( Defect *d = defects; d; d = d->next )
+	    if( d->defectID == defectID )
+	        return d;
+	return NULL;
+}
+
+void FieldSnapshot::forget( void *defectID )
+{
+	for( Defect **d = &defects; *d; d = &(*d)->next )
+	    if( (*d)->defectID == defectID )
+	    {
+	        Defect *item = *d;
+	        *d = item->next;
+	        while( item->fields )
+	        {
+	            Field *f = item->fields;
+	            item->fields = f->next;
+	            delete[] f->name;
+	            if( f->value )
+	                free( f->value );
+	            delete f;
+	        }
+	        delete item;
+	        return;
+	    }
+}
+
+void FieldSnapshot::clear()
+{
+	while( defects )
+	    forget( defects->defectID );
+}
+
+char *FieldSnapshot::get( void *defectID, const char *field, 
+				struct DTGError *err )
+{
+	Defect *d = find( defectID );
+	if( d )
+	    for( Field *f = d->fields; f; f = f->next )
+	        if( !strcmp( f->name, field ) )
+	        {
+	            clear_DTGError( err );
+	            return f->value ? strdup( f->value ) : NULL;
+	        }
+
+	char *value = mod->defect_get_field( defectID, field, err );
+	if( err->message )
+	    return value; // not kept, the next read tries again
+	if( !d )
+	{
+	    d = new Defect;
+	    d->defectID = defectID;
+	    d->fields = NULL;
+	    d->next = defects;
+	    defects = d;
+	}
+	Field *f = new Field;
+	f->name = cp_string( field );
+	f->value = value;
+	f->next = d->fields;
+	d->fields = f;
+	return value ? strdup( value ) : NULL;
+}
+
+void FieldSnapshot::set( void *defectID, const char *field, 
+				const char *value, struct DTGError *err )
+{
+	Defect *d = find( defectID );
+	if( d )
+	    for( Field **f = &d->fields; *f; f = &(*f)->next )
+	        if( !strcmp( (*f)->name, field ) )
+	        {
+	            Field *item = *f;
+	            *f = item->next;
+	            delete[] item->name;
+	            if( item->value )
+	                free( item->value );
+	            delete item;
+	            break;
+	        }
+	mod->defect_set_field( defectID, field, value, err );
+}
+
+void FieldSnapshot::free_defect( void *defectID, struct DTGError *err )
+{
+	forget( defectID );
+	mod->defect_free( defectID, err );
+}
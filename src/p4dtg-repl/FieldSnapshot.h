@@ -0,0 +1,67 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FIELDSNAPSHOT_HEADER
+#define FIELDSNAPSHOT_HEADER
+
+class DTGModule;
+struct DTGError;
+
+/*
+	Field values of the defects being unified on one side, each read
+	from the plug-in on first use and then served from here. Setting a
+	field drops its value so the next read asks the plug-in again.
+	Defects must be freed through free_defect() so a handle the plug-in
+	reuses is not served the values of the defect it replaced. One per
+	Unify, so not shared between the replication workers.
+*/
+
+class FieldSnapshot {
+    protected:
+	struct Field {
+	    char *name;
+	    char *value;	// malloc'd, as returned by the plug-in
+	    Field *next;
+	};
+	struct Defect {
+	    void *defectID;
+	    Field *fields;
+	    Defect *next;
+	};
+
+	DTGModule *mod;
+	Defect *defects;
+
+	Defect *find( void *defectID );
+
+    public:
+	FieldSnapshot( DTGModule *mod );
+	~FieldSnapshot();
+
+	// As the DTGModule calls they replace; get returns a malloc'd copy
+	char *get( void *defectID, const char *field, struct DTGError *err );
+	void set( void *defectID, const char *field, const char *value,
+			struct DTGError *err );
+	void free_defect( void *defectID, struct DTGError *err );
+
+	// Drop the values of a defect, as after a save
+	void forget( void *defectID );
+	void clear();
+};
+
+#endif
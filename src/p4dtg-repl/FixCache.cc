@@ -0,0 +1,159 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+extern "C" {
+#include <dtg-utils.h>
+}
+#include "FixCache.h"
+#include <genutils.h>
+
+FixCache::FixCache( int max_changes )
+{
+	limit = max_changes > 0 ? max_changes : 1;
+	count = 0;
+	buckets = new Entry *[limit];
+	memset( buckets, 0, sizeof(Entry *) * limit );
+	newest = oldest = NULL;
+	hits = misses = 0L;
+}
+
+FixCache::~FixCache()
+{
+	while( oldest )
+	    drop_oldest();
+	delete[] buckets;
+}
+
+unsigned int FixCache::hash( const char *change )
+{
+	unsigned int h = 2166136261u;
+	for( ; *change; change++ )
+	    h = ( h ^ (unsigned char)*change ) * 16777619u;
+	return h;
+}
+
+FixCache::Entry *FixCache::lookup( const char *change )
+{
+	for( Entry *e = buckets[hash( change ) % limit]; e; e = e->next )
+	    if( !strcmp( e->change, change ) )
+	        return e;
+	return NULL;
+}
+
+/* Take e out of the recently used list */
+
+void FixCache::unlink( Entry *e )
+{
+	if( e->newer )
+	    e->newer->older = e->older;
+	else
+	    newest = e->older;
+	if( e->older )
+	    e->older->newer = e->newer;
+	else
+	    oldest = e->newer;
+	e->newer = e->older = NULL;
+}
+
+void FixCache::drop_oldest()
+{
+	Entry *item = oldest;
+	unlink( item );
+	for( Entry **e = &buckets[hash( item->change ) % limit]; 
+		*e; 
+		e = &(*e)->next )
+	    if( *e == item )
+	    {
+	        *e = item->next;
+	        break;
+	    }
+	delete[] item->change;
+	delete_DTGFixDesc( item->fix );
+	delete item;
+	count--;
+}
+
+/* Returns a copy for the caller to delete, NULL when not cached */
+
+struct DTGFixDesc *FixCache::find( const char *change )
+{
+	if( !change )
+	    return NULL;
+	std::lock_guard<std::mutex> guard( lock );
+	Entry *e = lookup( change );
+	if( !e )
+	{
+	    misses++;
+	    return NULL;
+	}
+	hits++;
+	if( e != newest )
+	{
+	    unlink( e );
+	    e->older = newest;
+	    newest->newer = e;
+	    newest = e;
+	}
+	return copy_DTGFixDesc( e->fix );
+}
+
+/* Checks for a change without counting it as a hit or miss */
+
+int FixCache::contains( const char *change )
+{
+	if( !change )
+	    return 0;
+	std::lock_guard<std::mutex> guard( lock );
+	return lookup( change ) != NULL;
+}
+
+void FixCache::add( const char *change, const struct DTGFixDesc *fix )
+{
+	if( !change || !fix )
+	    return;
+	std::lock_guard<std::mutex> guard( lock );
+	if( lookup( change ) )
+	    return; // described meanwhile by another worker
+	if( count >= limit )
+	    drop_oldest();
+
+	Entry *e = new Entry;
+	e->change = cp_string( change );
+	e->fix = copy_DTGFixDesc( fix );
+	unsigned int b = hash( change ) % limit;
+	e->next = buckets[b];
+	buckets[b] = e;
+	e->newer = NULL;
+	e->older = newest;
+	if( newest )
+	    newest->newer = e;
+	else
+	    oldest = e;
+	newest = e;
+	count++;
+}
+
+void FixCache::get_counts( long &hit_cnt, long &miss_cnt )
+{
+	std::lock_guard<std::mutex> guard( lock );
+	hit_cnt = hits;
+	miss_cnt = misses;
+}
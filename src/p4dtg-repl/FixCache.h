@@ -0,0 +1,67 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FIXCACHE_HEADER
+#define FIXCACHE_HEADER
+
+#include <mutex>
+
+struct DTGFixDesc;
+
+/*
+	Descriptions of submitted changes by change number, so each is
+	described once however many fix rules and defects refer to it.
+	Holds at most limit changes, dropping the least recently used.
+	Shared by the replication workers.
+*/
+
+class FixCache {
+    protected:
+	struct Entry {
+	    char *change;
+	    struct DTGFixDesc *fix;
+	    Entry *next;	// hash chain
+	    Entry *newer;
+	    Entry *older;
+	};
+
+	Entry **buckets;
+	int limit;
+	int count;
+	Entry *newest;
+	Entry *oldest;
+	long hits;
+	long misses;
+	std::mutex lock;
+
+	unsigned int hash( const char *change );
+	Entry *lookup( const char *change );
+	void unlink( Entry *e );
+	void drop_oldest();
+
+    public:
+	FixCache( int limit );
+	~FixCache();
+
+	struct DTGFixDesc *find( const char *change );
+	int contains( const char *change );
+	void add( const char *change, const struct DTGFixDesc *fix );
+	void get_counts( long &hit_cnt, long &miss_cnt );
+};
+
+#endif
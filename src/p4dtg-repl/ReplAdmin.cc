@@ -0,0 +1,280 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#endif
+extern "C" {
+#include <dtg-utils.h>
+}
+#include "ReplAdmin.h"
+#include "ReplControl.h"
+#include "Logger.h"
+#include <genutils.h>
+
+static const int ADMIN_LINE = 256;
+static const int ADMIN_REPLY = 1024;
+static const int ADMIN_TIMEOUT = 2;	// seconds a client has to send
+
+static const char *pass_names[] = { "idle", "DTS", "SCM", "recheck" };
+
+ReplAdmin::ReplAdmin( const char *my_path, ReplControl *my_control,
+			Logger *my_log )
+{
+	path = cp_string( my_path );
+	control = my_control;
+	log = my_log;
+	listen_fd = -1;
+	quit_fd[0] = quit_fd[1] = -1;
+	server = NULL;
+}
+
+ReplAdmin::~ReplAdmin()
+{
+#ifndef _WIN32
+	if( server )
+	{
+	    // serve() polls the pipe, it cannot be full
+	    (void)!write( quit_fd[1], "q", 1 );
+	    server->join();
+	    delete server;
+	}
+	if( quit_fd[0] >= 0 )
+	{
+	    close( quit_fd[0] );
+	    close( quit_fd[1] );
+	}
+	if( listen_fd >= 0 )
+	{
+	    close( listen_fd );
+	    unlink( path );
+	}
+#endif
+	delete[] path;
+}
+
+/* Returns 0 if the socket could not be opened */
+
+int ReplAdmin::start()
+{
+#ifdef _WIN32
+	log->log( 1, "Admin socket not supported on this platform" );
+	return 0;
+#else
+	struct sockaddr_un addr;
+	memset( &addr, 0, sizeof( addr ) );
+	addr.sun_family = AF_UNIX;
+	if( strlen( path ) >= sizeof( addr.sun_path ) )
+	{
+	    log->log( 0, "Error: Admin socket path too long: %s", path );
+	    return 0;
+	}
+	strcpy( addr.sun_path, path );
+
+	// The run file keeps a second engine away, so any socket is stale
+	unlink( path );
+	listen_fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+	if( listen_fd < 0 ||
+	    bind( listen_fd, (struct sockaddr *)&addr, sizeof( addr ) ) ||
+	    chmod( path, 0660 ) ||
+	    listen( listen_fd, 4 ) ||
+	    pipe( quit_fd ) )
+	{
+	    log->log( 0, "Error: Unable to open admin socket %s: %s",
+			path, strerror( errno ) );
+	    if( listen_fd >= 0 )
+	    {
+	        close( listen_fd );
+	        unlink( path );
+	    }
+	    listen_fd = -1;
+	    quit_fd[0] = quit_fd[1] = -1;
+	    return 0;
+	}
+	fcntl( listen_fd, F_SETFD, FD_CLOEXEC );
+	fcntl( quit_fd[0], F_SETFD, FD_CLOEXEC );
+	fcntl( quit_fd[1], F_SETFD, FD_CLOEXEC );
+
+	server = new std::thread( &ReplAdmin::serve, this );
+	log->log( 1, "Admin socket: %s", path );
+	return 1;
+#endif
+}
+
+void ReplAdmin::serve()
+{
+#ifndef _WIN32
+	struct pollfd pfd[2];
+	pfd[0].fd = listen_fd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = quit_fd[0];
+	pfd[1].events = POLLIN;
+	while( 1 )
+	{
+	    if( poll( pfd, 2, -1 ) < 0 )
+	    {
+	        if( errno == EINTR )
+	            continue;
+	        log->log( 0, "Error: Admin socket failed: %s",
+			strerror( errno ) );
+	        return;
+	    }
+	    if( pfd[1].revents )
+	        return;
+	    if( !( pfd[0].revents & POLLIN ) )
+	        continue;
+
+	    int fd = accept( listen_fd, NULL, NULL );
+	    if( fd < 0 )
+	        continue;
+	    answer( fd );
+	    close( fd );
+	}
+#endif
+}
+
+/* Reads one command and writes its reply */
+
+void ReplAdmin::answer( int fd )
+{
+#ifndef _WIN32
+	struct timeval tv;
+	tv.tv_sec = ADMIN_TIMEOUT;
+	tv.tv_usec = 0;
+	setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof( tv ) );
+	setsockopt( fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof( tv ) );
+
+	char line[ADMIN_LINE];
+	int len = 0;
+	while( len < ADMIN_LINE - 1 )
+	{
+	    int n = read( fd, &line[len], ADMIN_LINE - 1 - len );
+	    if( n <= 0 )
+	        break;
+	    len += n;
+	    if( memchr( line, '\n', len ) )
+	        break;
+	}
+	line[len] = '\0';
+	line[strcspn( line, "\r\n" )] = '\0';
+
+	char reply[ADMIN_REPLY];
+	int out;
+	if( !strcmp( line, "sync" ) )
+	{
+	    log->log( 1, "Admin: sync requested" );
+	    control->wake();
+	    out = snprintf( reply, ADMIN_REPLY, "ok\n" );
+	}
+	else if( !strcmp( line, "pause" ) )
+	{
+	    control->pause( 1 );
+	    out = snprintf( reply, ADMIN_REPLY, "ok\n" );
+	}
+	else if( !strcmp( line, "resume" ) )
+	{
+	    control->pause( 0 );
+	    out = snprintf( reply, ADMIN_REPLY, "ok\n" );
+	}
+	else if( !strcmp( line, "status" ) )
+	    out = status( reply, ADMIN_REPLY );
+	else if( !strcmp( line, "stats" ) )
+	    out = stats( reply, ADMIN_REPLY );
+	else
+	    out = snprintf( reply, ADMIN_REPLY,
+			"error: unknown command, use one of: "
+			"sync pause resume status stats\n" );
+	if( out >= ADMIN_REPLY )
+	    out = ADMIN_REPLY - 1;
+
+	for( int sent = 0; sent < out; )
+	{
+	    int n = write( fd, &reply[sent], out - sent );
+	    if( n <= 0 )
+	        break;
+	    sent += n;
+	}
+#endif
+}
+
+static void format_time( long when, char *buf, int len )
+{
+	if( !when )
+	{
+	    snprintf( buf, len, "never" );
+	    return;
+	}
+	time_t t = (time_t)when;
+	struct tm tm;
+#ifdef _WIN32
+	gmtime_s( &tm, &t );
+#else
+	gmtime_r( &t, &tm );
+#endif
+	strftime( buf, len, "%Y/%m/%d %H:%M:%S UTC", &tm );
+}
+
+int ReplAdmin::status( char *buf, int len )
+{
+	ReplProgress &p = control->progress;
+	const char *state;
+	if( p.running )
+	    state = control->paused() ? "pausing" : "replicating";
+	else
+	    state = control->paused() ? "paused" : "sleeping";
+
+	char start_str[64], end_str[64];
+	format_time( p.started, start_str, sizeof( start_str ) );
+	format_time( p.finished, end_str, sizeof( end_str ) );
+	int pass = p.pass;
+	if( pass < 0 || pass > ReplProgress::RECHECK )
+	    pass = ReplProgress::IDLE;
+	return snprintf( buf, len,
+		"state: %s\n"
+		"pass: %s\n"
+		"done: %ld\n"
+		"listed: %ld\n"
+		"cycle_started: %s\n"
+		"cycle_finished: %s\n",
+		state, pass_names[pass],
+		(long)p.done, (long)p.listed, start_str, end_str );
+}
+
+int ReplAdmin::stats( char *buf, int len )
+{
+	ReplProgress &p = control->progress;
+	return snprintf( buf, len,
+		"cycles: %ld\n"
+		"failed_cycles: %ld\n"
+		"defects: %ld\n"
+		"fix_cache_hits: %ld\n"
+		"fix_cache_misses: %ld\n",
+		(long)p.cycles, (long)p.failed, (long)p.defects,
+		(long)p.fix_hits, (long)p.fix_misses );
+}
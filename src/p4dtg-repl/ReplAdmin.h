@@ -0,0 +1,60 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPLADMIN_HEADER
+#define REPLADMIN_HEADER
+
+#include <thread>
+
+class Logger;
+class ReplControl;
+
+/*
+	Unix-domain socket (repl/ctl-<map>) taking one command per
+	connection and answering with text lines:
+		sync		end the current sleep and replicate now
+		pause		finish the current cycle, then wait
+		resume		leave pause
+		status		state and progress of the current pass
+		stats		counters since startup
+	Served by its own thread. Not available on Windows.
+*/
+
+class ReplAdmin {
+    protected:
+	char *path;
+	ReplControl *control;
+	Logger *log;
+
+	int listen_fd;
+	int quit_fd[2];
+	std::thread *server;
+
+	void serve();
+	void answer( int fd );
+	int status( char *buf, int len );
+	int stats( char *buf, int len );
+
+    public:
+	ReplAdmin( const char *path, ReplControl *control, Logger *log );
+	~ReplAdmin();
+
+	int start();
+};
+
+#endif
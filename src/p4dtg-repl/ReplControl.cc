@@ -0,0 +1,394 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+extern "C" {
+#include <dtg-utils.h>
+}
+#include <DTG-platforms.h>
+#include "ReplControl.h"
+#include "Logger.h"
+#include <genutils.h>
+
+// Without inotify the stop file is looked for this often while asleep
+static const int STOP_POLL = 2;
+
+ReplControl *ReplControl::active = NULL;
+
+static const char *last_component( const char *path )
+{
+	const char *sep = strrchr( path, DIRSEPARATOR[0] );
+	return sep ? &sep[1] : path;
+}
+
+ReplControl::ReplControl( const char *my_dir, const char *stop,
+			const char *run, Logger *my_log )
+{
+	dir = cp_string( my_dir );
+	stop_file = cp_string( stop );
+	run_file = cp_string( run );
+	stop_name = last_component( stop_file );
+	run_name = last_component( run_file );
+	log = my_log;
+	flags = 0;
+	held = 0;
+	progress.running = 0;
+	progress.pass = ReplProgress::IDLE;
+	progress.done = progress.listed = 0L;
+	progress.cycles = progress.failed = progress.defects = 0L;
+	progress.fix_hits = progress.fix_misses = 0L;
+	progress.started = progress.finished = 0L;
+	wake_fd[0] = wake_fd[1] = -1;
+	notify_fd = -1;
+	watch = -1;
+	watching = 0;
+	watcher = NULL;
+}
+
+ReplControl::~ReplControl()
+{
+#ifndef _WIN32
+	if( active == this )
+	{
+	    signal( SIGTERM, SIG_DFL );
+	    signal( SIGUSR1, SIG_DFL );
+	    active = NULL;
+	}
+#endif
+#ifdef __linux__
+	if( watcher )
+	{
+	    // Removing the watch queues IN_IGNORED, which ends watch_loop
+	    inotify_rm_watch( notify_fd, watch );
+	    watcher->join();
+	    delete watcher;
+	}
+	if( notify_fd >= 0 )
+	    close( notify_fd );
+#endif
+#ifndef _WIN32
+	if( wake_fd[0] >= 0 )
+	{
+	    close( wake_fd[0] );
+	    close( wake_fd[1] );
+	}
+#endif
+	delete[] dir;
+	delete[] stop_file;
+	delete[] run_file;
+}
+
+/* Signal handler: only sets flags and writes to the pipe */
+
+void ReplControl::on_signal( int sig )
+{
+#ifndef _WIN32
+	ReplControl *c = active;
+	if( !c )
+	    return;
+	c->flags |= sig == SIGUSR1 ? WAKE : SIGNALLED;
+	c->notify();
+#endif
+}
+
+void ReplControl::notify()
+{
+#ifndef _WIN32
+	if( wake_fd[1] < 0 )
+	    return;
+	int saved = errno;
+	// A full pipe means a wakeup is already pending
+	(void)!write( wake_fd[1], "x", 1 );
+	errno = saved;
+#endif
+}
+
+void ReplControl::start()
+{
+#ifndef _WIN32
+	if( !pipe( wake_fd ) )
+	    for( int i = 0; i < 2; i++ )
+	    {
+	        fcntl( wake_fd[i], F_SETFL,
+			fcntl( wake_fd[i], F_GETFL ) | O_NONBLOCK );
+	        fcntl( wake_fd[i], F_SETFD, FD_CLOEXEC );
+	    }
+	else
+	{
+	    log->log( 0, "Error: Unable to create control pipe: %s",
+			strerror( errno ) );
+	    wake_fd[0] = wake_fd[1] = -1;
+	}
+
+	active = this;
+	struct sigaction sa;
+	memset( &sa, 0, sizeof( sa ) );
+	sa.sa_handler = on_signal;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset( &sa.sa_mask );
+	sigaction( SIGTERM, &sa, NULL );
+	sigaction( SIGUSR1, &sa, NULL );
+#endif
+#ifdef __linux__
+	notify_fd = inotify_init1( IN_CLOEXEC );
+	if( notify_fd >= 0 )
+	    watch = inotify_add_watch( notify_fd, dir,
+			IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+			IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR );
+	if( watch >= 0 )
+	{
+	    watching = 1;
+	    watcher = new std::thread( &ReplControl::watch_loop, this );
+	}
+	else
+	    log->log( 0, "Warning: Unable to watch %s, polling for stop_file: %s",
+			dir, strerror( errno ) );
+#endif
+	refresh();
+	log->log( 1, "Stop control: %s",
+		watching ? "inotify" : "polling stop_file" );
+}
+
+/* Brings the file flags in line with the files themselves */
+
+void ReplControl::refresh()
+{
+	struct stat buf;
+	if( !stat( stop_file, &buf ) )
+	    flags |= STOP_FILE;
+	else
+	    flags &= ~STOP_FILE;
+	if( stat( run_file, &buf ) )
+	    flags |= RUN_GONE;
+	else
+	    flags &= ~RUN_GONE;
+}
+
+void ReplControl::watch_loop()
+{
+#ifdef __linux__
+	char buf[4096] __attribute__(( aligned( __alignof__( struct inotify_event ) ) ));
+	while( watching )
+	{
+	    int len = read( notify_fd, buf, sizeof( buf ) );
+	    if( len < 0 && errno == EINTR )
+	        continue;
+	    if( len <= 0 )
+	        break;
+
+	    for( char *p = buf; p < buf + len; )
+	    {
+	        struct inotify_event *ev = (struct inotify_event *)p;
+	        p += sizeof( struct inotify_event ) + ev->len;
+
+	        if( ev->mask & ( IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF ) )
+	        {
+	            watching = 0;
+	            break;
+	        }
+	        if( ev->mask & IN_Q_OVERFLOW )
+	        {
+	            refresh();
+	            notify();
+	            continue;
+	        }
+	        if( !ev->len )
+	            continue;
+
+	        int gone = ev->mask & ( IN_DELETE | IN_MOVED_FROM );
+	        if( !strcmp( ev->name, stop_name ) )
+	        {
+	            if( gone )
+	                flags &= ~STOP_FILE;
+	            else
+	            {
+	                flags |= STOP_FILE;
+	                notify();
+	            }
+	        }
+	        else if( !strcmp( ev->name, run_name ) )
+	        {
+	            if( gone )
+	                flags |= RUN_GONE;
+	            else
+	                flags &= ~RUN_GONE;
+	        }
+	    }
+	}
+	watching = 0;
+	notify(); // sleep() goes back to polling
+#endif
+}
+
+int ReplControl::stop_pending()
+{
+	int f = flags;
+	if( f & SIGNALLED )
+	{
+	    log->log( 0, "Received stop signal, beginning shutdown" );
+	    if( !( f & STOP_FILE ) )
+	    {
+	        // Leave a stop file so the stop counts as requested
+	        FILE *fd = fopen( stop_file, "a" );
+	        if( fd )
+	            fclose( fd );
+	        flags |= STOP_FILE;
+	    }
+	    return 1;
+	}
+	if( f & STOP_FILE )
+	{
+	    log->log( 0, "Discovered stop_file, beginning shutdown" );
+	    return 1;
+	}
+	return 0;
+}
+
+int ReplControl::poll_files()
+{
+	refresh();
+	if( flags & RUN_GONE )
+	{
+	    log->log( 0, "Error: run_file missing, recreating: %s", run_file );
+	    FILE *fd = fopen( run_file, "a" );
+	    if( fd )
+	        fclose( fd );
+	    flags &= ~RUN_GONE;
+	}
+	return stop_pending();
+}
+
+/*
+	Returns 1 when the map is to stop. Recreates a missing run file.
+	While the directory is watched this only reads the flags.
+*/
+
+int ReplControl::check()
+{
+	if( !watching )
+	    return poll_files();
+
+	int f = flags;
+	if( !( f & ( STOP_FILE | RUN_GONE | SIGNALLED ) ) )
+	    return 0;
+	if( f & RUN_GONE )
+	{
+	    log->log( 0, "Error: run_file missing, recreating: %s", run_file );
+	    flags &= ~RUN_GONE;
+	    FILE *fd = fopen( run_file, "a" );
+	    if( fd )
+	        fclose( fd );
+	}
+	return stop_pending();
+}
+
+/* Sleeps until the time is up, a stop is requested or SIGUSR1 */
+
+void ReplControl::sleep( int seconds )
+{
+	time_t end = time( NULL ) + seconds;
+	while( 1 )
+	{
+	    int f = flags;
+	    if( f & ( STOP_FILE | SIGNALLED ) )
+	        break;
+	    if( f & WAKE )
+	    {
+	        log->log( 1, "Wakeup requested, starting next cycle" );
+	        break;
+	    }
+	    time_t now = time( NULL );
+	    if( now >= end && !held )
+	        break;
+
+	    int wait = (int)( end - now );
+	    if( held )
+	        wait = STOP_POLL * 30;
+	    if( !watching && wait > STOP_POLL )
+	        wait = STOP_POLL;
+#ifndef _WIN32
+	    if( wake_fd[0] >= 0 )
+	    {
+	        struct pollfd pfd;
+	        pfd.fd = wake_fd[0];
+	        pfd.events = POLLIN;
+	        if( poll( &pfd, 1, wait * 1000 ) > 0 )
+	        {
+	            char drain[64];
+	            while( read( wake_fd[0], drain, sizeof( drain ) ) > 0 )
+	                ;
+	        }
+	    }
+	    else
+#endif
+	        do_sleep( wait );
+
+	    if( !watching )
+	        refresh();
+	}
+	flags &= ~WAKE;
+}
+
+/* Ends the current sleep, even while paused */
+
+void ReplControl::wake()
+{
+	flags |= WAKE;
+	notify();
+}
+
+void ReplControl::pause( int on )
+{
+	held = on;
+	log->log( 0, "Replication %s", on ? "paused" : "resumed" );
+	notify();
+}
+
+void ReplControl::begin_cycle()
+{
+	progress.pass = ReplProgress::IDLE;
+	progress.done = 0L;
+	progress.listed = 0L;
+	progress.started = (long)time( NULL );
+	progress.running = 1;
+}
+
+void ReplControl::end_cycle( int ret )
+{
+	progress.running = 0;
+	progress.pass = ReplProgress::IDLE;
+	progress.finished = (long)time( NULL );
+	if( ret > 0 )
+	    progress.cycles++;
+	else if( ret < 0 )
+	    progress.failed++;
+}
@@ -0,0 +1,115 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPLCONTROL_HEADER
+#define REPLCONTROL_HEADER
+
+#include <atomic>
+#include <thread>
+
+class Logger;
+
+/*
+	What the engine is doing, for the admin socket. Written by the
+	replication thread, read by the admin thread.
+*/
+
+struct ReplProgress {
+	enum Pass { IDLE, DTS, SCM, RECHECK };
+
+	std::atomic<int> running;	// in a cycle
+	std::atomic<int> pass;
+	std::atomic<long> done;		// defects processed this pass
+	std::atomic<long> listed;	// defects listed so far this pass
+	std::atomic<long> cycles;	// cycles completed since startup
+	std::atomic<long> failed;	// cycles ended by an offline server
+	std::atomic<long> defects;	// defects processed since startup
+	std::atomic<long> fix_hits;
+	std::atomic<long> fix_misses;
+	std::atomic<long> started;	// time the current or last cycle began
+	std::atomic<long> finished;	// time the last cycle ended
+};
+
+/*
+	Stop and run control of one map: the repl/stop-<map> and
+	repl/run-<map> files plus, off Windows, SIGTERM (stop) and SIGUSR1
+	(end the current sleep and replicate now). On Linux a thread
+	follows the repl directory with inotify and keeps flags in step
+	with the two files, so check() is a load of the flags until
+	something happens. Elsewhere, or if the directory cannot be
+	watched, check() falls back to stat()ing both files.
+
+	Signals and file events are also written to a pipe that sleep()
+	waits on, so a stop request ends the sleep at once. While paused
+	sleep() only returns for a stop or a wakeup.
+*/
+
+class ReplControl {
+    protected:
+	enum {
+	    STOP_FILE = 0x1,	// stop file exists
+	    RUN_GONE = 0x2,	// run file was removed
+	    SIGNALLED = 0x4,	// SIGTERM received
+	    WAKE = 0x8		// SIGUSR1 received
+	};
+
+	char *dir;
+	char *stop_file;
+	char *run_file;
+	const char *stop_name;	// last component of stop_file
+	const char *run_name;	// last component of run_file
+	Logger *log;
+
+	std::atomic<int> flags;
+	std::atomic<int> held;	// paused
+	int wake_fd[2];		// self-pipe, -1 when unavailable
+
+	int notify_fd;
+	int watch;
+	std::atomic<int> watching;
+	std::thread *watcher;
+
+	static ReplControl *active;	// receives the signals
+	static void on_signal( int sig );
+
+	void notify();
+	void watch_loop();
+	int stop_pending();
+	int poll_files();
+
+    public:
+	ReplControl( const char *dir, const char *stop, const char *run,
+			Logger *log );
+	~ReplControl();
+
+	ReplProgress progress;
+
+	void start();
+	void refresh();
+	int check();
+	void sleep( int seconds );
+
+	void wake();
+	void pause( int on );
+	int paused() { return held; }
+
+	void begin_cycle();
+	void end_cycle( int ret );
+};
+
+#endif
@@ -0,0 +1,98 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <chrono>
+#include <DTGModule.h>
+extern "C" {
+#include <dtg-utils.h>
+}
+#include "ServerClock.h"
+
+ServerClock::ServerClock()
+{
+	base = 0;
+	base_at = 0.0;
+	calibrated = 0;
+}
+
+double ServerClock::steady()
+{
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+/*
+	Seconds since 1970/01/01 of the date taken as is, whatever time
+	zone the server gives it in. Only differences are used.
+*/
+
+long long ServerClock::to_seconds( struct DTGDate *d )
+{
+	long long y = d->year - ( d->month <= 2 );
+	long long era = ( y >= 0 ? y : y - 399 ) / 400;
+	long long yoe = y - era * 400;
+	long long mp = ( d->month + 9 ) % 12;
+	long long doy = ( 153 * mp + 2 ) / 5 + d->day - 1;
+	long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	long long days = era * 146097 + doe - 719468;
+	return ( ( days * 24 + d->hour ) * 60 + d->minute ) * 60 + d->second;
+}
+
+struct DTGDate *ServerClock::from_seconds( long long secs )
+{
+	long long days = secs >= 0 ? secs / 86400 : ( secs - 86399 ) / 86400;
+	long long rem = secs - days * 86400;
+	days += 719468;
+	long long era = ( days >= 0 ? days : days - 146096 ) / 146097;
+	long long doe = days - era * 146097;
+	long long yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+	long long doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+	long long mp = ( 5 * doy + 2 ) / 153;
+	int day = (int)( doy - ( 153 * mp + 2 ) / 5 + 1 );
+	int month = (int)( mp < 10 ? mp + 3 : mp - 9 );
+	int year = (int)( yoe + era * 400 + ( month <= 2 ) );
+	return new_DTGDate( year, month, day, (int)( rem / 3600 ),
+			(int)( rem / 60 % 60 ), (int)( rem % 60 ) );
+}
+
+/* Reads the server date and returns the server date at steady() at */
+
+struct DTGDate *ServerClock::date_at( DTGModule *mod, void *dtID, double at,
+				struct DTGError *err )
+{
+	struct DTGDate *now = mod->dt_get_server_date( dtID, err );
+	if( err->message || !now )
+	    return now;
+	double read_at = steady();
+	long long secs = to_seconds( now );
+	delete_DTGDate( now );
+
+	// The server date is truncated to the second, round the gap up
+	long long date = secs - (long long)ceil( read_at - at );
+	if( calibrated )
+	{
+	    long long prior = base + (long long)floor( at - base_at );
+	    if( prior < date )
+	        date = prior;
+	}
+	base = secs;
+	base_at = read_at;
+	calibrated = 1;
+	return from_seconds( date );
+}
@@ -0,0 +1,53 @@
+/*
+*    P4DTG - Defect tracking integration tool.
+*    Copyright (C) 2024 Perforce Software, Inc.
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU General Public License as published by
+*    the Free Software Foundation, either version 3 of the License, or
+*    (at your option) any later version.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU General Public License for more details.
+*
+*    You should have received a copy of the GNU General Public License
+*    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SERVERCLOCK_HEADER
+#define SERVERCLOCK_HEADER
+
+class DTGModule;
+struct DTGDate;
+struct DTGError;
+
+/*
+	The clock of one data source against the local steady clock, so a
+	cycle can read the server date once it knows it has work and still
+	date the cycle from when it began listing. Each reading calibrates
+	the clock; date_at() returns the earlier of the date the reading
+	puts at that moment and the date the previous calibration does, so
+	a server clock stepped while a cycle ran can only move the date
+	back, never past a change the cycle did not list.
+*/
+
+class ServerClock {
+    protected:
+	long long base;		// server seconds at the last reading
+	double base_at;		// steady() at the last reading
+	int calibrated;
+
+    public:
+	ServerClock();
+
+	static double steady();
+	static long long to_seconds( struct DTGDate *date );
+	static struct DTGDate *from_seconds( long long secs );
+
+	struct DTGDate *date_at( DTGModule *mod, void *dtID, double at,
+				struct DTGError *err );
+};
+
+#endif
@@ -20,6 +20,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 #include <DTGModule.h>
 extern "C" {
 #include <dtg-utils.h>
@@ -28,8 +31,16 @@ extern "C" {
 #include "DataMapping.h"
 #include "Unify.h"
 #include "Logger.h"
+#include "DefectIndex.h"
+#include "CycleJournal.h"
+#include "ServerClock.h"
+#include "FixCache.h"
+#include "ReplControl.h"
+#include "FieldSnapshot.h"
 #include <genutils.h>
 
+static const int FIX_CACHE = 1000;	// change descriptions kept
+
 void Unify::get_project_id( DataSource *src, void *&dtID, void *&projID )
 {
 	DTGError *err = new_DTGError( NULL );
@@ -108,34 +119,316 @@ Unify::Unify( DataMapping *my_map, Logger *my_log )
 	since_scm = NULL;
 	log = my_log;
 	stop_file = run_file = err_file = NULL;
+	control = NULL;
 	cur_scm = NULL;
 	cur_dts = NULL;
 	report_id = 0;
 	scm_dirty = dts_dirty = 0;
 	scm_recheck = NULL;
 	scm_failed = NULL;
+	set = NULL;
+	parent = NULL;
+	pool = NULL;
+	workers = NULL;
+	worker_cnt = 0;
+	claims = NULL;
+	scm_index = NULL;
+	journal = NULL;
+	scm_clock = NULL;
+	dts_clock = NULL;
+	cycle_start = 0.0;
+	scm_date = dts_date = NULL;
+	cycle_ret = 0;
+	last_advance = 0L;
+	fetched_ids = NULL;
+	fetched = NULL;
+	fetched_cnt = 0;
+	fetched_dts = 0;
+	pending = NULL;
+	defer_saves = 0;
+	stats_file = NULL;
+	scm_last = NULL;
+	dts_last = NULL;
+	fix_cache = new FixCache( FIX_CACHE );
+	scm_clock = new ServerClock();
+	dts_clock = new ServerClock();
+	fix_hits = fix_misses = 0L;
 
 	// Convert "List of Change Numbers" to DTG_FIXES
 	for( CopyRule *cr = map->scm_to_dts_rules; cr; cr = cr->next )
 	    if( !strcmp( cr->scm_field, "List of Change Numbers" ) )
 	        sprintf( cr->scm_field, "DTG_FIXES" );
 
+	// Plan the copy rules are run from
+	map->compile();
+
 	// Connect to servers
 	scm = map->scm;
 	scm_mod = scm->my_mod;
+	scm_snap = new FieldSnapshot( scm_mod );
 	scm_dtID = NULL;
 	scm_projID = NULL;
 	get_project_id( scm, scm_dtID, scm_projID );
 
 	dts = map->dts;
 	dts_mod = dts->my_mod;
+	dts_snap = new FieldSnapshot( dts_mod );
 	dts_dtID = NULL;
 	dts_projID = NULL;
 	get_project_id( dts, dts_dtID, dts_projID );
 }
 
+/*
+	Replication worker: shares the map, log and settings of the parent
+	but holds its own connections so defects can be processed in
+	parallel. Recheck and failure lists are merged back by the parent
+	at the end of each pass.
+*/
+
+Unify::Unify( Unify *my_parent )
+{
+	abort_run = 0;
+	force_exit = 0;
+	query_cnt = 0;
+	parent = my_parent;
+	pool = parent->pool;
+	workers = NULL;
+	worker_cnt = 0;
+	claims = NULL;
+	scm_index = parent->scm_index;
+	journal = NULL;
+	scm_clock = NULL;
+	dts_clock = NULL;
+	cycle_start = 0.0;
+	scm_date = dts_date = NULL;
+	cycle_ret = 0;
+	last_advance = 0L;
+	fetched_ids = NULL;
+	fetched = NULL;
+	fetched_cnt = 0;
+	fetched_dts = 0;
+	pending = NULL;
+	defer_saves = 0;
+	stats_file = NULL;
+	scm_last = NULL;
+	dts_last = NULL;
+	fix_cache = parent->fix_cache;
+	fix_hits = fix_misses = 0L;
+	map = parent->map;
+	set = parent->set;
+	since_dts = parent->since_dts;
+	since_scm = parent->since_scm;
+	log = parent->log;
+	stop_file = run_file = err_file = NULL;
+	control = NULL;
+	cur_scm = NULL;
+	cur_dts = NULL;
+	report_id = 0;
+	scm_dirty = dts_dirty = 0;
+	scm_recheck = NULL;
+	scm_failed = NULL;
+
+	// Connect to servers
+	scm = map->scm;
+	scm_mod = scm->my_mod;
+	scm_snap = new FieldSnapshot( scm_mod );
+	scm_dtID = NULL;
+	scm_projID = NULL;
+	get_project_id( scm, scm_dtID, scm_projID );
+
+	dts = map->dts;
+	dts_mod = dts->my_mod;
+	dts_snap = new FieldSnapshot( dts_mod );
+	dts_dtID = NULL;
+	dts_projID = NULL;
+	get_project_id( dts, dts_dtID, dts_projID );
+}
+
+/*
+	Load the DTS issue index for this map, rebuilding it with a single
+	listing of the map's SCM defects when missing or damaged.
+*/
+
+void Unify::open_index( const char *path )
+{
+	scm_index = new DefectIndex( path, log );
+	if( scm_index->load() )
+	{
+	    char cnt[32];
+	    sprintf( cnt, "%d", scm_index->entries() );
+	    log->log( 2, "Info: Loaded index with %s entries", cnt );
+	    return;
+	}
+	if( !scm_projID )
+	    return; // Work from memory only, retried at the next start
+
+	// Unsegmented, any defect replicating an issue is this map's
+	log->log( 1, "Warning: Rebuilding index: %s", path );
+	char *qual = map->scm->seg_ok ? 
+			mk_string( "DTG_MAPID=", map->id ) :
+			cp_string( "DTG_DTISSUE=*" );
+	DTGError *err = new_DTGError( NULL );
+	struct DTGField *pairs = scm_mod->proj_find_defect_values( 
+				scm_projID, qual, "DTG_DTISSUE", err );
+	delete[] qual;
+	if( err->message )
+	    // Work from memory only, retried at the next start
+	    log->log( 0, "Error: Unable to rebuild index: %s", err->message );
+	else
+	{
+	    scm_index->rebuild( pairs );
+	    char cnt[32];
+	    sprintf( cnt, "%d", scm_index->entries() );
+	    log->log( 2, "Info: Rebuilt index with %s entries", cnt );
+	}
+	delete_DTGField( pairs );
+	delete_DTGError( err );
+}
+
+/*
+	Load the progress journal of this map, left behind when the last
+	cycle was interrupted.
+*/
+
+void Unify::open_journal( const char *path )
+{
+	journal = new CycleJournal( path, log );
+	if( journal->load() )
+	{
+	    char cnt[32];
+	    sprintf( cnt, "%d", journal->entries() );
+	    log->log( 1, "Info: Found interrupted cycle, %s defects done", 
+			cnt );
+	}
+}
+
+/*
+	Time the plug-in calls of both data sources. Each cycle's calls are
+	logged by report_stats() and the totals since startup written to
+	path, one tab separated line per data source and call:
+		source call calls usecs max_usecs hist[0] .. hist[BUCKETS-1]
+	hist[i] counting the calls under 2^i microseconds.
+*/
+
+void Unify::open_stats( const char *path )
+{
+	stats_file = cp_string( path );
+	scm_mod->enable_stats();
+	dts_mod->enable_stats();
+	scm_last = new DTGCallCounts[DTGCallStats::CALLS];
+	memset( scm_last, 0, sizeof( DTGCallCounts ) * DTGCallStats::CALLS );
+	if( dts_mod != scm_mod )
+	{
+	    dts_last = new DTGCallCounts[DTGCallStats::CALLS];
+	    memset( dts_last, 0, 
+		sizeof( DTGCallCounts ) * DTGCallStats::CALLS );
+	}
+}
+
+// Upper bound of the bucket holding the pct percentile of this cycle
+static long call_percentile( struct DTGCallCounts *cur, 
+				struct DTGCallCounts *last, int pct )
+{
+	long calls = cur->calls - last->calls;
+	long want = ( calls * pct + 99 ) / 100;
+	long seen = 0L;
+	for( int j = 0; j < DTGCallCounts::BUCKETS; j++ )
+	{
+	    seen += cur->hist[j] - last->hist[j];
+	    if( seen >= want )
+	        return 1L << j;
+	}
+	return 1L << ( DTGCallCounts::BUCKETS - 1 );
+}
+
+void Unify::report_calls( const char *src, DTGModule *mod, 
+				struct DTGCallCounts *last, FILE *out )
+{
+	for( int i = 0; i < DTGCallStats::CALLS; i++ )
+	{
+	    struct DTGCallCounts cur;
+	    mod->stats->read( i, &cur );
+	    if( out && cur.calls )
+	    {
+	        fprintf( out, "%s\t%s\t%ld\t%lld\t%ld", src,
+			DTGCallStats::names[i], 
+			cur.calls, cur.usecs, cur.max_usecs );
+	        for( int j = 0; j < DTGCallCounts::BUCKETS; j++ )
+	            fprintf( out, "\t%ld", cur.hist[j] );
+	        fprintf( out, "\n" );
+	    }
+	    long calls = cur.calls - last[i].calls;
+	    if( calls > 0 )
+	    {
+	        long long usecs = cur.usecs - last[i].usecs;
+	        char line[256];
+	        snprintf( line, sizeof( line ), 
+			"%s %s: %ld calls, %lld ms, "
+			"avg %lld us, p50 < %ld us, p99 < %ld us",
+			src, DTGCallStats::names[i], calls, usecs / 1000, 
+			usecs / calls, call_percentile( &cur, &last[i], 50 ),
+			call_percentile( &cur, &last[i], 99 ) );
+	        log->log( 1, "Stats: %s", line );
+	    }
+	    last[i] = cur;
+	}
+}
+
+/* Called at the end of each replication cycle */
+
+void Unify::report_stats()
+{
+	long hits, misses;
+	fix_cache->get_counts( hits, misses );
+	if( hits + misses > fix_hits + fix_misses )
+	{
+	    char hit_cnt[32], miss_cnt[32];
+	    sprintf( hit_cnt, "%ld", hits - fix_hits );
+	    sprintf( miss_cnt, "%ld", misses - fix_misses );
+	    log->log( 2, "Info: Fix descriptions cached: %s, described: %s",
+			hit_cnt, miss_cnt );
+	    fix_hits = hits;
+	    fix_misses = misses;
+	}
+	if( control )
+	{
+	    control->progress.fix_hits = hits;
+	    control->progress.fix_misses = misses;
+	}
+
+	if( !stats_file )
+	    return;
+
+	char *tmp_file = mk_string( stats_file, ".tmp" );
+	FILE *out = fopen( tmp_file, "w" );
+	if( !out )
+	    log->log( 0, "Error: Unable to write stats: %s", tmp_file );
+	report_calls( dts_last ? "SCM" : "SCM+DTS", scm_mod, scm_last, out );
+	if( dts_last )
+	    report_calls( "DTS", dts_mod, dts_last, out );
+	if( out )
+	{
+	    int failed = ferror( out );
+	    if( fclose( out ) || failed )
+	        log->log( 0, "Error: Unable to write stats: %s", tmp_file );
+	    else
+	    {
+#ifdef _WIN32
+	        unlink( stats_file );
+#endif
+	        if( rename( tmp_file, stats_file ) )
+	            log->log( 0, "Error: Unable to replace stats: %s", 
+				stats_file );
+	    }
+	}
+	delete[] tmp_file;
+}
+
 int Unify::reset_scm()
 {
+	// Workers reconnect at the start of the next cycle
+	stop_workers();
+
 	// Disconnect from server
 	DTGError *err = new_DTGError( NULL );
 	if( scm_projID )
@@ -144,6 +437,9 @@ int Unify::reset_scm()
 	    scm_mod->dt_free( scm_dtID, err );
 	delete_DTGError( err );
 
+	// Values held for the old connection are no longer current
+	scm_snap->clear();
+
 	// Connect to server
 	scm_dtID = NULL;
 	scm_projID = NULL;
@@ -154,6 +450,9 @@ int Unify::reset_scm()
 
 int Unify::reset_dts()
 {
+	// Workers reconnect at the start of the next cycle
+	stop_workers();
+
 	// Disconnect from server
 	DTGError *err = new_DTGError( NULL );
 	if( dts_projID )
@@ -162,6 +461,9 @@ int Unify::reset_dts()
 	    dts_mod->dt_free( dts_dtID, err );
 	delete_DTGError( err );
 
+	// Values held for the old connection are no longer current
+	dts_snap->clear();
+
 	// Connect to server
 	dts_dtID = NULL;
 	dts_projID = NULL;
@@ -179,12 +481,36 @@ int Unify::reset_servers()
 
 Unify::~Unify()
 {
+	stop_workers();
+	commit_saves();
+	drop_fetched();
+	if( claims )
+	    delete_DTGStrList( claims );
+	if( scm_index && !parent )
+	    delete scm_index;
+	if( journal )
+	    delete journal;
+	drop_dates();
+	if( scm_clock )
+	    delete scm_clock;
+	if( dts_clock )
+	    delete dts_clock;
+	if( fix_cache && !parent )
+	    delete fix_cache;
+	delete scm_snap;
+	delete dts_snap;
 	if( stop_file )
 	    delete[] stop_file;
 	if( run_file )
 	    delete[] run_file;
 	if( err_file )
 	    delete[] err_file;
+	if( stats_file )
+	    delete[] stats_file;
+	if( scm_last )
+	    delete[] scm_last;
+	if( dts_last )
+	    delete[] dts_last;
 	if( cur_scm )
 	    delete[] cur_scm;
 	if( cur_dts )
@@ -204,41 +530,27 @@ Unify::~Unify()
 }
 
 char *Unify::convert( DTGModule *from, const char *new_val, 
-			CopyRule *cr, DTGModule *to, int rev )
+			PlanRule *pr, DTGModule *to, int rev )
 {
 	char *tmp_free = NULL;
 	char *i;
 	struct DTGDate *date;
+	const char *mapped;
 	if( !new_val )
 	    new_val = "";
-	switch( cr->copy_type )
+	switch( pr->kind )
 	{
 	case CopyRule::MAP:
-	    if( rev )
-	    {
-	        for( CopyMap *cm = cr->mappings; cm; cm = cm->next )
-	            if( !strcasecmp( new_val, cm->value2 ) )
-	            {
-	                tmp_free = strdup( cm->value1 );
-	                break;
-	            }
-	    }
-	    else
-	    {
-	        for( CopyMap *cm = cr->mappings; cm; cm = cm->next )
-	            if( !strcasecmp( new_val, cm->value1 ) )
-	            {
-	                tmp_free = strdup( cm->value2 );
-	                break;
-	            }
-	    }
+	    mapped = ( rev ? pr->to_dts : pr->to_scm )->find( new_val );
+	    if( mapped )
+	        tmp_free = strdup( mapped );
 	    if( !tmp_free )
 	    {
 	        if( *new_val )
 	        {
 	            log->log( 0, "Error: DTS(%s) SCM(%s)", cur_dts, cur_scm, 1);
 	            log->log( 0, "Error: Field: DTS(%s) SCM(%s)", 
-			    cr->dts_field, cr->scm_field, 1 );
+			    pr->rule->dts_field, pr->rule->scm_field, 1 );
 	            log->log( 0, "Error: Unknown map value: %s", new_val );
 	        }
 	        tmp_free = strdup( "" );
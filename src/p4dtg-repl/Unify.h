@@ -19,6 +19,8 @@
 #ifndef UNIFY_HEADER
 #define UNIFY_HEADER
 
+#include <stdio.h>
+
 class DataMapping;
 class DataSource;
 class DTGModule;
@@ -29,6 +31,16 @@ struct DTGDate;
 struct DTGStrList;
 struct DTGField;
 struct DTGSettings;
+struct DTGError;
+class UnifyPool;
+class UnifySave;
+class DefectIndex;
+class CycleJournal;
+class ServerClock;
+class FixCache;
+class FieldSnapshot;
+class ReplControl;
+struct DTGCallCounts;
 
 class Unify {
     protected:
@@ -65,21 +77,101 @@ class Unify {
 	struct DTGStrList *scm_recheck;
 	struct DTGField *scm_failed;
 
+	// Replication workers (worker_threads > 1)
+	Unify *parent;		// owning engine, NULL unless a worker
+	UnifyPool *pool;	// work queue and in-flight defects
+	Unify **workers;
+	int worker_cnt;
+	struct DTGStrList *claims; // defects held by this worker
+
+	int start_workers();
+	void stop_workers();
+	void begin_workers( struct DTGStrList *defects, int dts_pass );
+	int end_workers();
+	int run_pass( int dts_pass, void *cursor, long &listed, 
+			struct DTGError *err );
+	void worker_main();
+	void worker_loop( int dts_pass );
+	void claim( const char *type, const char *id );
+	void unclaim( const char *type, const char *id );
+	void release_claims();
+
+	// Defects loaded ahead with proj_get_defects
+	struct DTGStrList *fetched_ids;
+	void **fetched;
+	int fetched_cnt;
+	int fetched_dts;
+
+	void prefetch( struct DTGStrList *from, int cnt, int dts_side );
+	void *get_defect( int dts_side, const char *id, struct DTGError *err );
+	void drop_fetched();
+
+	// Saves held until the end of a chunk (proj_save_defects)
+	UnifySave *pending;
+	int defer_saves;
+
+	void save_defects( UnifySave *pair );
+	void commit_saves();
+	void swap_save( UnifySave *pair );
+	void saved_dts( UnifySave *pair, const char *id, struct DTGError *err );
+	void saving_scm( UnifySave *pair );
+	void saved_scm( UnifySave *pair, const char *id, struct DTGError *err );
+
+	// DTS issue -> SCM defect, shared with the workers
+	DefectIndex *scm_index;
+	void *get_scm_match( const char *defect, char *&scm_id,
+				struct DTGError *err );
+
+	// Progress of the current cycle, NULL in the workers
+	CycleJournal *journal;
+	struct DTGStrList *list_page( DTGModule *mod, void *cursor, 
+				int dts_pass, long &skipped,
+				struct DTGError *err );
+
+	// Server dates of the cycle, read once it finds work
+	ServerClock *scm_clock;
+	ServerClock *dts_clock;
+	double cycle_start;	// ServerClock::steady() as the cycle began
+	struct DTGDate *scm_date;
+	struct DTGDate *dts_date;
+	int cycle_ret;		// start_cycle() failure, returned by unify()
+	long last_advance;	// time() the watermarks last moved
+	int start_cycle();
+	void drop_dates();
+
+	// Field values of the defects in hand, per side
+	FieldSnapshot *scm_snap;
+	FieldSnapshot *dts_snap;
+
+	// Change descriptions for format_fix, shared with the workers
+	FixCache *fix_cache;
+	long fix_hits;
+	long fix_misses;
+
+	// Plug-in call statistics (call_stats), totals at the last report
+	char *stats_file;
+	struct DTGCallCounts *scm_last;
+	struct DTGCallCounts *dts_last;
+	void report_calls( const char *src, DTGModule *mod, 
+				struct DTGCallCounts *last, FILE *out );
+
     public:
 	Logger *log;
 	char *stop_file;
 	char *run_file;
 	char *err_file;
+	ReplControl *control;	// stop and run control, owned by the caller
 
     public:
 	Unify( DataMapping *my_map, Logger *my_log );
+	Unify( Unify *my_parent );
 	~Unify();
 
 	void *get_scmID() { return scm_dtID; }
 	void *get_dtsID() { return dts_dtID; }
 
 	char *convert( DTGModule *from, const char *new_val, 
-			CopyRule *cr, DTGModule *to, int rev = 0 );
+			struct PlanRule *pr, DTGModule *to, int rev = 0 );
 	void log_fatal( int last_chance, const char *msg );
 	void fail_scm( struct DTGField *pair );
 	void process_scm_defect( const char *defect, int last_chance = 0 );
@@ -96,6 +188,12 @@ class Unify {
 		struct DTGStrList *&add_fixes, 
 		struct DTGStrList *&del_fixes );
 	char *format_fix( FixRule *fr, char *fixid );
+	void describe_fixes( struct DTGStrList *fixids );
+
+	void open_index( const char *path );
+	void open_journal( const char *path );
+	void open_stats( const char *path );
+	void report_stats();
 
 	int reset_servers();
 	int reset_scm();
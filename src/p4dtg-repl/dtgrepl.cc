@@ -31,6 +31,8 @@ extern "C" {
 #include <DTGxml.h>
 #include <plugins.h>
 #include "Unify.h"
+#include "ReplControl.h"
+#include "ReplAdmin.h"
 #include "utils.h"
 #include "Logger.h"
 #include <genutils.h>
@@ -43,6 +45,8 @@ int QUERYLIMIT = 1000;
 int WAITTIME = 150;
 long CYCLE_THRESHOLD = 0L;
 long UPDATE_PERIOD = 0L;
+long WATERMARK_PERIOD = 600L;
+int WORKER_THREADS = 1;
 
 #ifndef LOGLEVEL
 #define LOGLEVEL 1
@@ -72,26 +76,36 @@ void cleanup( const char *id, Logger *log, const char *file )
 	}
 }
 
-static void process_sleep( int dur, const char *stop_file )
-{
-	if( !stop_file )
-	    return;
-
-	const int period = 2; // check every 2 seconds for stop request
-	struct stat buf;
-	while( dur > 0 )
-	{
-	    if( dur < period )
-	        do_sleep( dur );
-	    else
-	        do_sleep( period );
+/*
+	Seconds to wait after a cycle. Adaptive when polling_min or
+	polling_max differ from polling_period: a cycle that found changes
+	sets the wait to polling_min, or none if the cycle itself ran that
+	long since more changes have likely arrived meanwhile; each idle
+	cycle then multiplies it by polling_backoff up to polling_max.
+*/
 
-	    dur -= period;
+struct PollSchedule {
+	int period;
+	int min;
+	int max;
+	int backoff;
+	int wait;
 
-	    if( !stat( stop_file, &buf ) )
-	        break;
+	int next( long found, long secs )
+	{
+	    if( min == period && max == period )
+	        return period;
+	    if( found > 0 )
+	    {
+	        wait = min;
+	        return secs >= min ? 0 : min;
+	    }
+	    int cur = wait;
+	    if( wait < max )
+	        wait = wait * backoff < max ? wait * backoff : max;
+	    return cur;
 	}
-}
+};
 
 #ifdef _WIN32
 int __stdcall
@@ -441,7 +455,13 @@ main( int argc, char *argv[] )
 
 	// Process Map Level Attributes
 	int polling_period = 5;
+	int polling_min = 0;
+	int polling_max = 0;
+	int polling_backoff = 2;
 	int enable_write_to_readonly = 0;
+	int log_queue = 0;
+	int log_queue_drop = 0;
+	int call_stats = 0;
 	DataAttr *a;
 	for( a = map->attrs; a; a = a->next )
 	{
@@ -451,6 +471,14 @@ main( int argc, char *argv[] )
 	            log->set_level( atoi( a->value ) );
 	        else if( !strcmp( a->name, "polling_period" ) )
 	            polling_period = atoi( a->value );
+	        else if( !strcmp( a->name, "polling_min" ) )
+	            polling_min = atoi( a->value );
+	        else if( !strcmp( a->name, "polling_max" ) )
+	            polling_max = atoi( a->value );
+	        else if( !strcmp( a->name, "polling_backoff" ) )
+	            polling_backoff = atoi( a->value );
+	        else if( !strcmp( a->name, "watermark_period" ) )
+	            WATERMARK_PERIOD = atol( a->value );
 	        else if( !strcmp( a->name, "connection_reset" ) )
 	            QUERYLIMIT = atoi( a->value );
 	        else if( !strcmp( a->name, "wait_duration" ) )
@@ -461,6 +489,14 @@ main( int argc, char *argv[] )
 	            UPDATE_PERIOD = atol( a->value );
 	        else if( !strcmp( a->name, "enable_write_to_readonly" ) )
 	            enable_write_to_readonly = atol( a->value );
+	        else if( !strcmp( a->name, "worker_threads" ) )
+	            WORKER_THREADS = atoi( a->value );
+	        else if( !strcmp( a->name, "log_queue" ) )
+	            log_queue = atoi( a->value );
+	        else if( !strcmp( a->name, "log_queue_drop" ) )
+	            log_queue_drop = atoi( a->value );
+	        else if( !strcmp( a->name, "call_stats" ) )
+	            call_stats = atoi( a->value );
 	}
 	if( polling_period < 1 )
 	    polling_period = 1;
@@ -473,6 +509,36 @@ main( int argc, char *argv[] )
 	sprintf( intstr, "%d", polling_period );
 	log->log( 0, "Polling Period: %s", intstr );
 
+	PollSchedule poll;
+	poll.period = polling_period;
+	poll.min = polling_min < 1 ? polling_period : polling_min;
+	if( poll.min > 100 )
+	    poll.min = 100;
+	poll.max = polling_max < 1 ? polling_period : polling_max;
+	if( poll.max > 3600 )
+	    poll.max = 3600;
+	if( poll.max < poll.min )
+	    poll.max = poll.min;
+	poll.backoff = polling_backoff;
+	if( poll.backoff < 1 )
+	    poll.backoff = 1;
+	else if( poll.backoff > 10 )
+	    poll.backoff = 10;
+	poll.wait = polling_period;
+	sprintf( intstr, "%d", poll.min );
+	log->log( 0, "Minimum Polling Period: %s", intstr );
+	sprintf( intstr, "%d", poll.max );
+	log->log( 0, "Maximum Polling Period: %s", intstr );
+	sprintf( intstr, "%d", poll.backoff );
+	log->log( 0, "Polling Backoff: %s", intstr );
+
+	if( WATERMARK_PERIOD < 0 )
+	    WATERMARK_PERIOD = 0L;
+	else if( WATERMARK_PERIOD > 86400 )
+	    WATERMARK_PERIOD = 86400L;
+	sprintf( intstr, "%ld", WATERMARK_PERIOD );
+	log->log( 0, "Idle Watermark Period: %s", intstr );
+
 	if( QUERYLIMIT < 1 )
 	    QUERYLIMIT = 1;
 	else if( QUERYLIMIT > 1000000 )
@@ -502,6 +568,27 @@ main( int argc, char *argv[] )
 	sprintf( intstr, "%ld", enable_write_to_readonly );
 	log->log( 0, "Enable write to SCM read-only: %s", intstr );
 
+	if( WORKER_THREADS < 1 )
+	    WORKER_THREADS = 1;
+	else if( WORKER_THREADS > DataMapping::MAX_WORKER_THREADS )
+	    WORKER_THREADS = DataMapping::MAX_WORKER_THREADS;
+	sprintf( intstr, "%d", WORKER_THREADS );
+	log->log( 0, "Worker Threads: %s", intstr );
+
+	if( log_queue < 0 )
+	    log_queue = 0;
+	else if( log_queue > 1000000 )
+	    log_queue = 1000000;
+	sprintf( intstr, "%d", log_queue );
+	log->log( 0, "Log Queue Size: %s", intstr );
+	if( log_queue )
+	    log->log( 0, "Log Queue Full: %s", 
+			log_queue_drop ? "drop entries" : "wait" );
+	log->set_async( log_queue, !log_queue_drop );
+
+	sprintf( intstr, "%d", call_stats );
+	log->log( 0, "Plug-in Call Statistics: %s", intstr );
+
 	char *stop_file = 
 		mk_string( root, "repl", DIRSEPARATOR, "stop-", map->id );
 	if( !stat( stop_file, &buf ) )
@@ -509,6 +596,11 @@ main( int argc, char *argv[] )
 	    log->log( 0, "Removing stop_file: %s", stop_file );
 	    unlink( stop_file );
 	}
+	char *repl_dir = mk_string( root, "repl" );
+	ReplControl *control = 
+		new ReplControl( repl_dir, stop_file, run_file, log );
+	delete[] repl_dir;
+	control->start();
 
 	for( DataSource *src = sources; src; src = src->next )
 	{
@@ -527,13 +619,10 @@ main( int argc, char *argv[] )
 	    
 	    int n = WAITTIME;
 
-	    process_sleep( n, stop_file );
+	    control->sleep( n );
 
-	    if( !stat( stop_file, &buf ) )
-	    {
-	        log->log( 0, "Discovered stop_file, beginning shutdown" );
+	    if( control->check() )
 	        break;
-	    }
 
 	    for( DataSource *src = sources; src; src = src->next )
 	        src->check_connection();
@@ -678,11 +767,33 @@ main( int argc, char *argv[] )
 	    {
 	        log->log( 0, "Removing stop_file: %s", uni_map->stop_file );
 	        unlink( uni_map->stop_file );
+	        control->refresh();
 	    }
+	    uni_map->control = control;
+	    char *admin_file =
+		mk_string( root, "repl", DIRSEPARATOR, "ctl-", map->id );
+	    ReplAdmin *admin = new ReplAdmin( admin_file, control, log );
+	    delete[] admin_file;
+	    admin->start();
 	    uni_map->run_file = 
 		mk_string( root, "repl", DIRSEPARATOR, "run-", map->id );
 	    uni_map->err_file = 
 		mk_string( root, "repl", DIRSEPARATOR, "err-", map->id );
+	    char *index_file =
+		mk_string( root, "repl", DIRSEPARATOR, "index-", map->id );
+	    uni_map->open_index( index_file );
+	    delete[] index_file;
+	    char *journal_file =
+		mk_string( root, "repl", DIRSEPARATOR, "cycle-", map->id );
+	    uni_map->open_journal( journal_file );
+	    delete[] journal_file;
+	    if( call_stats )
+	    {
+	        char *stats_file = 
+		    mk_string( root, "repl", DIRSEPARATOR, "stats-", map->id );
+	        uni_map->open_stats( stats_file );
+	        delete[] stats_file;
+	    }
 
 	    // Check for any pending messages from plug-ins
 	    DTGError *err = new_DTGError( NULL );
@@ -696,12 +807,21 @@ main( int argc, char *argv[] )
 	        log->log( i, err->message );
 	    delete_DTGError( err );
 
+	    // Settings are only rewritten when a cycle moves the watermarks
+	    struct DTGDate *saved_scm = 
+		copy_DTGDate( settings->last_update_scm );
+	    struct DTGDate *saved_dts = 
+		copy_DTGDate( settings->last_update_dts );
 	    while( 1 )
 	    {
 	        if( uni_map->stop_exists() )
 	            break;
 
+	        long defects = control->progress.defects;
+	        control->begin_cycle();
 	        int ret = uni_map->unify( settings );
+	        control->end_cycle( ret );
+	        uni_map->report_stats();
 
 	        if( !ret )
 	            break;
@@ -784,7 +904,7 @@ main( int argc, char *argv[] )
 
 	            int n = wait_time;
 
-	            process_sleep( n, uni_map->stop_file );
+	            control->sleep( n );
 
 	            continue;
 	        } 
@@ -808,7 +928,7 @@ main( int argc, char *argv[] )
 	                sprintf( sec, "%d", n );
 	                log->log( 0, "Sleeping for:  %s seconds.", sec );
 
-	                process_sleep( n, uni_map->stop_file );
+	                control->sleep( n );
 
 	                log->log( 0, "Attempting to reset servers" );
 	                if( uni_map->stop_exists() )
@@ -817,6 +937,9 @@ main( int argc, char *argv[] )
 	            continue;
 	        }
 
+	        int changed = settings->force ||
+		    compare_DTGDate( saved_scm, settings->last_update_scm ) ||
+		    compare_DTGDate( saved_dts, settings->last_update_dts );
 	        if( settings->force )
 	        {
 	            settings->force = 0;
@@ -826,7 +949,9 @@ main( int argc, char *argv[] )
 	            set_DTGDate( settings->last_update_dts, 
 				settings->starting_date );
 	        }
-	        if( lock_file( setting_file ) ) // will block
+	        if( changed && !lock_file( setting_file ) ) // will block
+	            log->log( 0, "Error obtaining lock on: %s", setting_file );
+	        else if( changed )
 	        {
 	            int failed = save_p4dtg_settings( setting_file, settings );
 	            unlock_file( setting_file );
@@ -835,11 +960,21 @@ main( int argc, char *argv[] )
 	                log->log( 0, "Fatal: Failed to save settings file" );
 	                break;
 	            }
+	            set_DTGDate( saved_scm, settings->last_update_scm );
+	            set_DTGDate( saved_dts, settings->last_update_dts );
 	        }
-	        else
-	            log->log( 0, "Error obtaining lock on: %s", setting_file );
-	        process_sleep( polling_period, uni_map->stop_file );
+	        int wait = poll.next( control->progress.defects - defects,
+			control->progress.finished - control->progress.started );
+	        if( wait != polling_period )
+	        {
+	            sprintf( intstr, "%d", wait );
+	            log->log( 2, "Next cycle in %s seconds", intstr );
+	        }
+	        control->sleep( wait );
 	    }
+	    delete_DTGDate( saved_scm );
+	    delete_DTGDate( saved_dts );
+	    delete admin;
 	    delete uni_map;
 	}
 	else
@@ -853,6 +988,7 @@ main( int argc, char *argv[] )
 	    delete map;
 	if( plugins )
 	    delete plugins;
+	delete control;
 
 	stop_file = mk_string( root, "repl", DIRSEPARATOR, "stop-", mapname );
 	if( stat( stop_file, &buf ) )
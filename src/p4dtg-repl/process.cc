@@ -20,7 +20,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include <sys/stat.h>
+#include <time.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <DTGModule.h>
 extern "C" {
 #include <dtg-utils.h>
@@ -32,11 +35,129 @@ extern "C" {
 
 #include "utils.h"
 #include "Logger.h"
+#include "DefectIndex.h"
+#include "CycleJournal.h"
+#include "ServerClock.h"
+#include "FixCache.h"
+#include "FieldSnapshot.h"
+#include "ReplControl.h"
 #include <genutils.h>
 
 extern int QUERYLIMIT;
 extern long CYCLE_THRESHOLD;
 extern long UPDATE_PERIOD;
+extern long WATERMARK_PERIOD;
+extern int WORKER_THREADS;
+
+// Defects loaded per proj_get_defects call
+static const int FETCH_CHUNK = 50;
+static const int LIST_PAGE = 1000;
+
+/*
+	Shared state for the replication workers of one pass: the list
+	of defects still to be handed out and the SCM/DTS defects that
+	are currently being unified. A worker claims its defect and, once
+	known, the matching defect on the other side so no pair is ever
+	unified by two workers at the same time.
+*/
+
+class UnifyPool {
+    public:
+	std::mutex lock;
+	std::condition_variable released;
+	std::condition_variable work;	// a page was handed out, or quit
+	std::condition_variable idle;	// the last worker left the page
+	struct DTGStrList *next;
+	struct DTGStrList *in_flight;
+	long items;
+	long remaining;
+	int stop_process;
+	long page;		// pages handed out, workers wait for a new one
+	int dts_pass;		// pass of the current page
+	int busy;		// workers still on the current page, or starting
+	int quit;
+	std::thread **threads;	// one per worker, for the life of the pool
+
+	UnifyPool()
+	{
+	    next = NULL;
+	    in_flight = NULL;
+	    threads = NULL;
+	    items = 0L;
+	    remaining = 0L;
+	    stop_process = 0;
+	    page = 0L;
+	    dts_pass = 0;
+	    busy = 0;
+	    quit = 0;
+	}
+	~UnifyPool()
+	{
+	    if( in_flight )
+	        delete_DTGStrList( in_flight );
+	}
+};
+
+/*
+	A unified pair waiting to be saved: what the end of
+	process_scm_defect/process_dts_defect needs once the save results
+	are known. With deferred saves the pairs of a chunk are written
+	with one proj_save_defects call per side in commit_saves().
+*/
+
+class UnifySave {
+    public:
+	int dts_pass;
+	int is_new;
+	int last_chance;
+	char *defect;
+	void *scm_defect;
+	void *dts_defect;
+	char *old_fixes;
+	struct DTGStrList *add;
+	struct DTGStrList *del;
+
+	// Unify state of the pair, swapped in while it is finished
+	char *cur_scm;
+	char *cur_dts;
+	int report_id;
+	int scm_dirty;
+	int dts_dirty;
+	struct DTGStrList *claims;
+
+	UnifySave *next;
+
+	UnifySave( int pass, const char *id, int new_defect, int last )
+	{
+	    dts_pass = pass;
+	    is_new = new_defect;
+	    last_chance = last;
+	    defect = cp_string( id );
+	    scm_defect = dts_defect = NULL;
+	    old_fixes = NULL;
+	    add = del = NULL;
+	    cur_scm = cur_dts = NULL;
+	    report_id = scm_dirty = dts_dirty = 0;
+	    claims = NULL;
+	    next = NULL;
+	}
+	~UnifySave()
+	{
+	    delete[] defect;
+	    if( old_fixes )
+	        delete[] old_fixes;
+	    if( add )
+	        delete_DTGStrList( add );
+	    if( del )
+	        delete_DTGStrList( del );
+	    if( cur_scm )
+	        delete[] cur_scm;
+	    if( cur_dts )
+	        delete[] cur_dts;
+	    if( claims )
+	        delete_DTGStrList( claims );
+	}
+};
 
 static void log_large_cycles( Logger *log, long &cnt )
 {
@@ -53,13 +174,10 @@ static void log_large_cycles( Logger *log, long &cnt )
 	}
 }
 
-static void log_large_cycles( Logger *log, 
-				struct DTGStrList *list, const char *type )
+static void log_large_cycles( Logger *log, long cnt, const char *type )
 {
 	if( CYCLE_THRESHOLD <= 0 )
 	    return;
-	long cnt = 0L;
-	for( struct DTGStrList *s = list; s; cnt++, s = s->next );
 	if( cnt >= CYCLE_THRESHOLD )
 	{
 	    char tmp[64];
@@ -68,14 +186,62 @@ static void log_large_cycles( Logger *log,
 	}
 }
 
+/*
+	Describes the fixes not yet in fix_cache with one proj_describe_fixes
+	call, so format_fix finds each of several new fixes cached. Any the
+	plug-in leaves out are described by format_fix, which reports why.
+*/
+
+void Unify::describe_fixes( struct DTGStrList *fixids )
+{
+	if( !scm_mod->has_bulk_describe() )
+	    return;
+
+	struct DTGStrList *need = NULL;
+	int cnt = 0;
+	for( struct DTGStrList *f = fixids; f; f = f->next )
+	    if( !fix_cache->contains( f->value ) && 
+		!in_DTGStrList( f->value, need ) )
+	    {
+	        need = append_DTGStrList( need, f->value );
+	        cnt++;
+	    }
+	if( cnt < 2 )
+	{
+	    delete_DTGStrList( need );
+	    return;
+	}
+
+	struct DTGFixDesc **fixes = new struct DTGFixDesc *[cnt];
+	struct DTGError *err = new_DTGError( NULL );
+	scm_mod->proj_describe_fixes( scm_projID, need, fixes, err );
+	if( err->message )
+	    log->log( 2, "Info: Describing fixes: %s", err->message );
+	int i = 0;
+	for( struct DTGStrList *f = need; f; f = f->next, i++ )
+	    if( fixes[i] )
+	    {
+	        fix_cache->add( f->value, fixes[i] );
+	        delete_DTGFixDesc( fixes[i] );
+	    }
+	delete_DTGError( err );
+	delete[] fixes;
+	delete_DTGStrList( need );
+}
+
 char *Unify::format_fix( FixRule *fr, char *fixid )
 {
 	char *result = NULL;
 	if( !fr || !fixid )
 	    return cp_string( "Details unknown" );
 	struct DTGError *err = new_DTGError( NULL );
-	struct DTGFixDesc *fix = 
-		scm_mod->proj_describe_fix( scm_projID, fixid, err );
+	struct DTGFixDesc *fix = fix_cache->find( fixid );
+	if( !fix )
+	{
+	    fix = scm_mod->proj_describe_fix( scm_projID, fixid, err );
+	    if( !err->message )
+	        fix_cache->add( fixid, fix );
+	}
 	if( err->message )
 	{
 	    log->log( 0, "Error: DTS(%s), SCM(%s)", cur_dts, cur_scm, 1 );
@@ -207,6 +373,20 @@ char *Unify::format_fix( FixRule *fr, char *fixid )
 
 #define SAFE_FREE( x ) { if( x ) free( x ); }
 
+// Field values read by unify_defects, updated as the rules set them
+static void set_value( char **vals, int slot, const char *new_val )
+{
+	SAFE_FREE( vals[slot] );
+	vals[slot] = new_val ? strdup( new_val ) : NULL;
+}
+
+static void free_values( char **vals, int cnt )
+{
+	for( int i = 0; i < cnt; i++ )
+	    SAFE_FREE( vals[i] );
+	delete[] vals;
+}
+
 int Unify::fail_on_read_err( struct DTGError *err, const char *type,
 				const char *id, const char *field )
 {
@@ -231,6 +411,8 @@ void Unify::unify_defects( int scm_stat, void *scm_defect,
 	char *dts_val = NULL, *scm_val = NULL;
 	struct DTGStrList *item = NULL;
 	log->log( 2, "Info: Processing DTS:%s SCM:%s", cur_dts, cur_scm );
+	if( map->fix_rules && add && add->next )
+	    describe_fixes( add );
 	for( FixRule *fr = map->fix_rules; fr; fr = fr->next )
 	{
 	    char *newval = NULL;
@@ -267,7 +449,7 @@ void Unify::unify_defects( int scm_stat, void *scm_defect,
 	    if( newval )
 	    {
 	        dts_dirty++;
-	        char *old_dtsval = dts_mod->defect_get_field( dts_defect,
+	        char *old_dtsval = dts_snap->get( dts_defect,
 	                                                      fr->dts_field,
 	                                                      err );
 	        // ignoring err
@@ -283,32 +465,58 @@ void Unify::unify_defects( int scm_stat, void *scm_defect,
 	            SAFE_FREE( old_dtsval );
 	            delete[] tmp;
 	        }
-	        dts_mod->defect_set_field( dts_defect, fr->dts_field,
+	        dts_snap->set( dts_defect, fr->dts_field,
 	                               newval, err );
 	        delete[] newval;
 	    }
 	}
-	for( CopyRule *cr = map->mirror_rules; cr; cr = cr->next )
+
+	// Read each field the copy rules use once, keeping it current
+	MapPlan *plan = map->plan;
+	char **scm_vals = new char *[plan->scm_cnt + 1];
+	char **dts_vals = new char *[plan->dts_cnt + 1];
+	memset( scm_vals, 0, sizeof(char *) * ( plan->scm_cnt + 1 ) );
+	memset( dts_vals, 0, sizeof(char *) * ( plan->dts_cnt + 1 ) );
+	int failed = 0;
+	for( int i = 0; i < plan->scm_cnt && !failed; i++ )
+	{
+	    scm_vals[i] = scm_snap->get( scm_defect, 
+						plan->scm_fields[i], err );
+	    failed = fail_on_read_err( err, "SCM", cur_scm, 
+						plan->scm_fields[i] );
+	}
+	for( int i = 0; i < plan->dts_cnt && !failed; i++ )
 	{
-	    scm_val = 
-		scm_mod->defect_get_field( scm_defect, cr->scm_field, err );
-	    if( fail_on_read_err( err, "SCM", cur_scm, cr->scm_field ) )
-	        return;
-	    dts_val = 
-		dts_mod->defect_get_field( dts_defect, cr->dts_field, err );
-	    if( fail_on_read_err( err, "DTS", cur_dts, cr->dts_field ) )
-	        return;
+	    dts_vals[i] = dts_snap->get( dts_defect, 
+						plan->dts_fields[i], err );
+	    failed = fail_on_read_err( err, "DTS", cur_dts, 
+						plan->dts_fields[i] );
+	}
+	if( failed )
+	{
+	    free_values( scm_vals, plan->scm_cnt );
+	    free_values( dts_vals, plan->dts_cnt );
+	    delete_DTGError( err );
+	    return;
+	}
+
+	for( int r = 0; r < plan->mirror_cnt; r++ )
+	{
+	    PlanRule *pr = &plan->mirror[r];
+	    CopyRule *cr = pr->rule;
+	    scm_val = scm_vals[pr->scm_slot];
+	    dts_val = dts_vals[pr->dts_slot];
 	    if( scm_stat > 0 && dts_stat > 0 )
 	    {
 	        char *new_scm_val = 
-			convert( dts_mod, dts_val, cr, scm_mod );
+			convert( dts_mod, dts_val, pr, scm_mod );
 	        char *new_dts_val = 
-			convert( scm_mod, scm_val, cr, dts_mod, 1 );
+			convert( scm_mod, scm_val, pr, dts_mod, 1 );
 	        switch( cr->mirror_conflicts )
 	        {
 	          case CopyRule::DTS:
 	          default:
-	            if( set_field( scm_mod, scm_defect, cr->scm_field, 
+	            if( set_field( scm_snap, scm_defect, cr->scm_field, 
 					new_scm_val, scm_val, err ) )
 	            {
 	                log->log( 1, "Warning: DTS(%s), SCM(%s)", 
@@ -319,10 +527,11 @@ void Unify::unify_defects( int scm_stat, void *scm_defect,
 	                log->log( 3, "Info: Old[%s] New[%s]", 
 				    scm_val, new_scm_val);
 	                scm_dirty++;
+	                set_value( scm_vals, pr->scm_slot, new_scm_val );
 	            }
 	            break;
 	          case CopyRule::SCM:
-	            if( set_field( dts_mod, dts_defect, cr->dts_field, 
+	            if( set_field( dts_snap, dts_defect, cr->dts_field, 
 					new_dts_val, dts_val, err ) )
 	            {
 	                log->log( 1, "Warning: DTS(%s), SCM(%s)", 
@@ -333,6 +542,7 @@ void Unify::unify_defects( int scm_stat, void *scm_defect,
 	                log->log( 3, "Info: Old[%s] New[%s]", 
 				    dts_val, new_dts_val);
 	                dts_dirty++;
+	                set_value( dts_vals, pr->dts_slot, new_dts_val );
 	            }
 	            break;
 	        }
@@ -342,8 +552,8 @@ void Unify::unify_defects( int scm_stat, void *scm_defect,
 	    else if( scm_stat > 0 )
 	    {
 	        char *new_val = 
-			convert( scm_mod, scm_val, cr, dts_mod, 1 );
-	        if( set_field( dts_mod, dts_defect, cr->dts_field, 
+			convert( scm_mod, scm_val, pr, dts_mod, 1 );
+	        if( set_field( dts_snap, dts_defect, cr->dts_field, 
 					new_val, dts_val, err ) )
 	        {
 	            log->log( 3, "Info: Set DTS:%s from SCM:%s",
@@ -351,14 +561,15 @@ void Unify::unify_defects( int scm_stat, void *scm_defect,
 	            log->log( 3, "Info: Old[%s] New[%s]", 
 				dts_val, new_val);
 	            dts_dirty++;
+	            set_value( dts_vals, pr->dts_slot, new_val );
 	        }
 	        delete[] new_val;
 	    }
 	    else if( dts_stat > 0 )
 	    {
 	        char *new_val = 
-			convert( dts_mod, dts_val, cr, scm_mod );
-	        if( set_field( scm_mod, scm_defect, cr->scm_field, 
+			convert( dts_mod, dts_val, pr, scm_mod );
+	        if( set_field( scm_snap, scm_defect, cr->scm_field, 
 					new_val, scm_val, err ) )
 	        {
 	            log->log( 3, "Info: Set SCM:%s from DTS:%s",
@@ -366,24 +577,19 @@ void Unify::unify_defects( int scm_stat, void *scm_defect,
 	            log->log( 3, "Info: Old[%s] New[%s]", 
 				scm_val, new_val);
 	            scm_dirty++;
+	            set_value( scm_vals, pr->scm_slot, new_val );
 	        }
 	        delete[] new_val;
 	    }
-	    SAFE_FREE( scm_val );
-	    SAFE_FREE( dts_val );
 	}
-	for( CopyRule *cr = map->dts_to_scm_rules; cr; cr = cr->next )
+	for( int r = 0; r < plan->dts_to_scm_cnt; r++ )
 	{
-	    scm_val = 
-		scm_mod->defect_get_field( scm_defect, cr->scm_field, err );
-	    if( fail_on_read_err( err, "SCM", cur_scm, cr->scm_field ) )
-	        return;
-	    dts_val = 
-		dts_mod->defect_get_field( dts_defect, cr->dts_field, err );
-	    if( fail_on_read_err( err, "DTS", cur_dts, cr->dts_field ) )
-	        return;
-	    char *new_val = convert( dts_mod, dts_val, cr, scm_mod );
-	    if( set_field( scm_mod, scm_defect, cr->scm_field, 
+	    PlanRule *pr = &plan->dts_to_scm[r];
+	    CopyRule *cr = pr->rule;
+	    scm_val = scm_vals[pr->scm_slot];
+	    dts_val = dts_vals[pr->dts_slot];
+	    char *new_val = convert( dts_mod, dts_val, pr, scm_mod );
+	    if( set_field( scm_snap, scm_defect, cr->scm_field, 
 			   new_val, scm_val, err ) )
 	    {
 	        log->log( 3, "Info: Set SCM:%s from DTS:%s",
@@ -391,23 +597,18 @@ void Unify::unify_defects( int scm_stat, void *scm_defect,
 	        log->log( 3, "Info: Old[%s] New[%s]", 
 				scm_val, new_val);
 	        scm_dirty++;
+	        set_value( scm_vals, pr->scm_slot, new_val );
 	    }
 	    delete[] new_val;
-	    SAFE_FREE( scm_val );
-	    SAFE_FREE( dts_val );
 	}
-	for( CopyRule *cr = map->scm_to_dts_rules; cr; cr = cr->next )
+	for( int r = 0; r < plan->scm_to_dts_cnt; r++ )
 	{
-	    scm_val = 
-		scm_mod->defect_get_field( scm_defect, cr->scm_field, err );
-	    if( fail_on_read_err( err, "SCM", cur_scm, cr->scm_field ) )
-	        return;
-	    dts_val = 
-		dts_mod->defect_get_field( dts_defect, cr->dts_field, err );
-	    if( fail_on_read_err( err, "DTS", cur_dts, cr->dts_field ) )
-	        return;
-	    char *new_val = convert( scm_mod, scm_val, cr, dts_mod );
-	    if( set_field( dts_mod, dts_defect, cr->dts_field, 
+	    PlanRule *pr = &plan->scm_to_dts[r];
+	    CopyRule *cr = pr->rule;
+	    scm_val = scm_vals[pr->scm_slot];
+	    dts_val = dts_vals[pr->dts_slot];
+	    char *new_val = convert( scm_mod, scm_val, pr, dts_mod );
+	    if( set_field( dts_snap, dts_defect, cr->dts_field, 
 				new_val, dts_val, err ) )
 	    {
 	        log->log( 3, "Info: Set DTS:%s from SCM:%s",
@@ -415,11 +616,12 @@ void Unify::unify_defects( int scm_stat, void *scm_defect,
 	        log->log( 3, "Info: Old[%s] New[%s]", 
 			dts_val, new_val);
 	        dts_dirty++;
+	        set_value( dts_vals, pr->dts_slot, new_val );
 	    }
 	    delete[] new_val;
-	    SAFE_FREE( scm_val );
-	    SAFE_FREE( dts_val );
 	}
+	free_values( scm_vals, plan->scm_cnt );
+	free_values( dts_vals, plan->dts_cnt );
 	delete_DTGError( err );
 }
 
@@ -448,7 +650,7 @@ char *Unify::update_fix_record( const char *id, void *scm_defect,
 	struct DTGStrList *fixes = 
 		scm_mod->proj_list_fixes( scm_projID, id, err );
 	char *oldval = 
-		scm_mod->defect_get_field( scm_defect, "DTG_FIXES", err );
+		scm_snap->get( scm_defect, "DTG_FIXES", err );
 	// ignore err
 	clear_DTGError( err );
 
@@ -478,7 +680,7 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 	log->log( 3, "Info: process_scm_defect( %s )", defect );
 	report_id = scm_dirty = dts_dirty = 0;
 	struct DTGError *err = new_DTGError( NULL );
-	void *scm_defect = scm_mod->proj_get_defect( scm_projID, defect, err );
+	void *scm_defect = get_defect( 0, defect, err );
 	if( !scm_defect )
 	{
 	    log->log( 0, "Error: Unable to retrieve scm defect: %s", defect );
@@ -495,7 +697,7 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 	    scm_failed = append_DTGField( scm_failed,
 					new_DTGField( cur_scm, err_msg ) );
 	    delete[] err_msg;
-	    scm_mod->defect_free( scm_defect, err );
+	    scm_snap->free_defect( scm_defect, err );
 	    delete_DTGError( err );
 	    return;
 	}
@@ -504,7 +706,7 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 	    log->log( ll, err->message );
 
 	char *value = 
-		scm_mod->defect_get_field( scm_defect, "DTG_ERROR", err );
+		scm_snap->get( scm_defect, "DTG_ERROR", err );
 	// ignore err
 	clear_DTGError( err );
 	if( value && *value )
@@ -512,19 +714,19 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 	    free( value );
 	    log->log( 1, "Warning: Skipping broken scm defect: %s", defect );
 	    log->log( 1, "Warning: Any changes from scm are not replicated" );
-	    scm_mod->defect_free( scm_defect, err );
+	    scm_snap->free_defect( scm_defect, err );
 	    delete_DTGError( err );
 	    return;
 	}
 	char *filter_msg = NULL;
 	if( map->scm_filter_desc && 
 		(filter_msg = 
-		    pass_filter( map->scm_filter_desc, scm_mod, scm_defect ) ) )
+		    pass_filter( map->scm_filter_desc, scm_snap, scm_defect ) ) )
 	{
 	    if( map->scm->seg_ok ) // DTG_MAPID exists
 	    {
 	        value = 
-		    scm_mod->defect_get_field( scm_defect, "DTG_MAPID", err );
+		    scm_snap->get( scm_defect, "DTG_MAPID", err );
 	        // ignore err
 	        clear_DTGError( err );
 	        if( value && !strcasecmp( value, map->id ) )
@@ -537,14 +739,14 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 	    log->log( 2, "Notice: Filtering scm defect: %s", defect );
 	    log->log( 2, "Notice: %s", filter_msg );
 	    delete[] filter_msg;
-	    scm_mod->defect_free( scm_defect, err );
+	    scm_snap->free_defect( scm_defect, err );
 	    delete_DTGError( err );
 	    return;
 	}
 
 	if( map->scm->seg_ok ) // DTG_MAPID exists
 	{
-	    value = scm_mod->defect_get_field( scm_defect, "DTG_MAPID", err );
+	    value = scm_snap->get( scm_defect, "DTG_MAPID", err );
 	    // ignore err
 	    clear_DTGError( err );
 	    if( value && 
@@ -556,7 +758,7 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 	    }
 	    if( !value || !*value )
 	    {
-	        scm_mod->defect_set_field( scm_defect, 
+	        scm_snap->set( scm_defect, 
 						"DTG_MAPID", map->id, err );
 	        log->log( 3, "Info: Set SCM:DTG_MAPID to [%s]", map->id );
 	        scm_dirty++;
@@ -567,7 +769,7 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 			"Error: SCM(%s) DTG_MAPID does not match, has %s",
 			cur_scm, value );
 		log_fatal( 1, "DTG_MAPID does not match current map" );
-	        scm_mod->defect_free( scm_defect, err );
+	        scm_snap->free_defect( scm_defect, err );
 	        delete_DTGError( err );
 	        SAFE_FREE( value );
 	        return;
@@ -575,7 +777,7 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 	    SAFE_FREE( value );
 	}
 	
-	value = scm_mod->defect_get_field( scm_defect, "DTG_DTISSUE", err );
+	value = scm_snap->get( scm_defect, "DTG_DTISSUE", err );
 	// ignore err
 	clear_DTGError( err );
 	if( value && value[0] == '"' && value[1] == '"' && value[2] == '\0' )
@@ -603,7 +805,7 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 					new_DTGField( cur_scm, err_msg ) );
 	        delete[] err_msg;
 
-	        scm_mod->defect_free( scm_defect, err );
+	        scm_snap->free_defect( scm_defect, err );
 	        delete_DTGError( err );
 	        SAFE_FREE( value );
 	        return;
@@ -614,6 +816,9 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 	else
 	{
 	    is_new = 0;
+	    if( scm_index )
+	        scm_index->add( value, defect );
+	    claim( "DTS", value );
 	    dts_defect = dts_mod->proj_get_defect( dts_projID, value, err );
 	    cur_dts = cp_string( value );
 	}
@@ -634,7 +839,7 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 					new_DTGField( cur_scm, err_msg ) );
 	    delete[] err_msg;
 
-	    scm_mod->defect_free( scm_defect, err );
+	    scm_snap->free_defect( scm_defect, err );
 	    delete_DTGError( err );
 	    SAFE_FREE( value );
 	    return;
@@ -643,11 +848,11 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 
 	struct DTGStrList *add, *del;
 	char *rev = update_fix_record( defect, scm_defect, add, del);
-	value = scm_mod->defect_get_field( scm_defect, "DTG_FIXES", err );
+	value = scm_snap->get( scm_defect, "DTG_FIXES", err );
 	// ignore err
 	clear_DTGError( err );
 	char *old_fixes = NULL;
-	if( set_field( scm_mod, scm_defect, "DTG_FIXES", rev, value, err ) )
+	if( set_field( scm_snap, scm_defect, "DTG_FIXES", rev, value, err ) )
 	{
 	    log->log( 3, "Info: Set SCM:DTG_FIXES to [%s]", rev );
 	    scm_dirty++;
@@ -667,7 +872,7 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 	else
 	{
 	    value = 
-	      dts_mod->defect_get_field( dts_defect, dts->moddate_field, err );
+	      dts_snap->get( dts_defect, dts->moddate_field, err );
 	    // ignore err
 	    clear_DTGError( err );
 	    if( !value || !*value )
@@ -682,7 +887,7 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 					new_DTGField( cur_scm, err_msg ) );
 	        delete[] err_msg;
 
-	        scm_mod->defect_free( scm_defect, err );
+	        scm_snap->free_defect( scm_defect, err );
 	        delete_DTGError( err );
 	        delete_DTGStrList( add );
 	        delete_DTGStrList( del );
@@ -703,7 +908,7 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 					new_DTGField( cur_scm, err_msg ) );
 	        delete[] err_msg;
 
-	        scm_mod->defect_free( scm_defect, err );
+	        scm_snap->free_defect( scm_defect, err );
 	        delete_DTGError( err );
 	        delete_DTGStrList( add );
 	        delete_DTGStrList( del );
@@ -731,11 +936,9 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 	    free( value );
 	}
 
-	char *id = NULL;
-
 	if( map->dts_filter_desc && 
 		(filter_msg = 
-		    pass_filter( map->dts_filter_desc, dts_mod, dts_defect ) ) )
+		    pass_filter( map->dts_filter_desc, dts_snap, dts_defect ) ) )
 	{
 	    log->log( 0, "Error: New DTS issue fails filter test, aborted: %s", 
 		defect );
@@ -748,7 +951,7 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 	}
 	if( map->scm_filter_desc && 
 		(filter_msg = 
-		    pass_filter( map->scm_filter_desc, scm_mod, scm_defect ) ) )
+		    pass_filter( map->scm_filter_desc, scm_snap, scm_defect ) ) )
 	{
 	    log->log( 0, 
 		"Error: Updated SCM issue fails filter test, aborted: %s", 
@@ -763,95 +966,14 @@ void Unify::process_scm_defect( const char *defect, int last_chance )
 
 	log->log( 3, "Info: Finished processing mappings" );
 
-	if( dts_dirty )
-	{
-	    log->log( 3, "Info: DTS has changes" );
-	    id = dts_mod->defect_save( dts_defect, err );
-	    if( err->message )
-	    {
-	        log->log( 0, "Error: saving dts defect(%s): scm:%s", 
-			cur_dts, defect );
-	        log->log( 0, "[%s]", err->message );
-	        log->log( 1, "Warning: Set DTG_ERROR: %s", err->message );
-	        char *tmp_err = mk_string( err->message );
-	        scm_mod->defect_set_field( scm_defect, "DTG_ERROR", 
-			tmp_err, err );
-	        delete[] tmp_err;
-	        scm_dirty++;
-	        // RESTORE DTG_FIXES
-	        if( old_fixes )
-	            scm_mod->defect_set_field( scm_defect, "DTG_FIXES",
-						old_fixes, err );
-	    }
-	    else if( id )
-	    {
-	        if( is_new )
-	        {
-	            log->log( report_id ? 0 : 2, 
-			"create dts defect(%s): scm:%s", id, defect );
-	            scm_mod->defect_set_field( scm_defect, "DTG_DTISSUE", 
-						id, err );
-	            delete[] cur_dts;
-	            cur_dts = mk_string( "new:", id );
-	            scm_dirty++;
-	            /* Copy rule uses ID, schedule re-unification of defects */
-	            if( map->recheck_on_new_dts )
-	                scm_recheck = append_DTGStrList( scm_recheck, cur_scm );
-	        }
-	        else
-	            log->log( 2, "saving dts defect(%s): scm:%s", id, defect );
-	        int ll = dts_mod->dt_get_message( dts_dtID, err );
-	        if( ll < 4 )
-	            log->log( ll, err->message );
-	    }
-	    else
-	    {
-	        log->log( 0, 
-			"Error:dts defect_save returned null: dts:%s scm:%s", 
-			cur_dts, defect );
-	        log->log( 1, "Warning: Set DTG_ERROR:No id returned from DTS" );
-	        scm_mod->defect_set_field( scm_defect, "DTG_ERROR", 
-			"No id returned from DTS for save_defect", err );
-	        scm_dirty++;
-	        // RESTORE DTG_FIXES
-	        if( old_fixes )
-	            scm_mod->defect_set_field( scm_defect, "DTG_FIXES",
-						old_fixes, err );
-	    }
-	    SAFE_FREE( id );
-	}
-	if( old_fixes )
-	    delete[] old_fixes;
-	if( scm_dirty )
-	{
-	    log->log( 3, "Info: SCM has changes" );
-	    id = scm_mod->defect_save( scm_defect, err );
-	    if( err->message )
-	        // Only retry if it failed updating not creating
-	        if( is_new )
-	        {
-		    log_fatal( 1, err->message );
-	            log->log( 0, 
-			"Error: Orphan dts defect created dts:%s (scm: %s)", 
-			cur_dts, cur_scm );
-	        }
-	        else
-	            log_fatal( last_chance, err->message );
-	    else
-	    {
-	        log->log( 2, "saving scm defect: %s", id );
-	        int ll = scm_mod->dt_get_message( scm_dtID, err );
-	        if( ll < 4 )
-	            log->log( ll, err->message );
-	    }
-	    SAFE_FREE( id );
-	}
-
-	scm_mod->defect_free( scm_defect, err );
-	dts_mod->defect_free( dts_defect, err );
-	delete_DTGStrList( add );
-	delete_DTGStrList( del );
+	UnifySave *pair = new UnifySave( 0, defect, is_new, last_chance );
+	pair->scm_defect = scm_defect;
+	pair->dts_defect = dts_defect;
+	pair->old_fixes = old_fixes;
+	pair->add = add;
+	pair->del = del;
 	delete_DTGError( err );
+	save_defects( pair );
 }
 
 void
@@ -884,19 +1006,19 @@ Unify::fail_scm( struct DTGField *pair )
 	{
 	    // Set DTG_ERROR and save job
 	    log->log( 1, "Warning: Set DTG_ERROR: %s", pair->value );
-	    scm_mod->defect_set_field( scm_defect, "DTG_ERROR", pair->value, 
+	    scm_snap->set( scm_defect, "DTG_ERROR", pair->value, 
 					err );
 	    char *tmp = scm_mod->defect_save( scm_defect, err );
 	    SAFE_FREE( tmp );
 	    if( !err->message )
 	    {
-	        scm_mod->defect_free( scm_defect, err );
+	        scm_snap->free_defect( scm_defect, err );
 	        delete_DTGError( err );
 	        return;
 	    }
 	    log->log( 0, "Fatal: saving scm defect(%s):", pair->name );
 	    log->log( 0, "SaveError[%s]", err->message );
-	    scm_mod->defect_free( scm_defect, err );
+	    scm_snap->free_defect( scm_defect, err );
 	    // Time to abort replication
 	}
 	else
@@ -917,6 +1039,75 @@ Unify::fail_scm( struct DTGField *pair )
 	}
 }
 
+/*
+	Find and load the SCM defect replicating a DTS defect. An index
+	entry is only used once the loaded defect still names the DTS
+	defect, otherwise the entry is dropped and the SCM searched.
+	scm_id is NULL when there is no matching SCM defect.
+*/
+
+void *Unify::get_scm_match( const char *defect, char *&scm_id,
+				struct DTGError *err )
+{
+	void *scm_defect;
+	scm_id = scm_index ? scm_index->find( defect ) : NULL;
+	if( scm_id )
+	{
+	    claim( "SCM", scm_id );
+	    scm_defect = scm_mod->proj_get_defect( scm_projID, scm_id, err );
+	    if( !scm_defect || err->message )
+	        return scm_defect; // reported as a loading failure
+
+	    char *value = 
+		scm_snap->get( scm_defect, "DTG_DTISSUE", err );
+	    // ignore err
+	    clear_DTGError( err );
+	    int match = value && !strcmp( value, defect );
+	    SAFE_FREE( value );
+	    if( match && map->scm->seg_ok )
+	    {
+	        value = 
+		    scm_snap->get( scm_defect, "DTG_MAPID", err );
+	        // ignore err
+	        clear_DTGError( err );
+	        match = value && !strcasecmp( value, map->id );
+	        SAFE_FREE( value );
+	    }
+	    if( match )
+	        return scm_defect;
+
+	    log->log( 2, "Notice: Dropping stale index entry: DTS(%s) SCM(%s)",
+			defect, scm_id );
+	    scm_snap->free_defect( scm_defect, err );
+	    clear_DTGError( err );
+	    unclaim( "SCM", scm_id );
+	    scm_index->remove( defect );
+	    delete[] scm_id;
+	    scm_id = NULL;
+	}
+
+	char *qual;
+	if( map->scm->seg_ok )
+	    qual = mk_string( "DTG_DTISSUE=", defect, 
+				" DTG_MAPID=", map->id );
+	else
+	    qual = mk_string( "DTG_DTISSUE=", defect );
+
+	struct DTGStrList *jobs = 
+		scm_mod->proj_find_defects( scm_projID, 1, qual, err );
+	delete[] qual;
+	if( !jobs )
+	    return NULL;
+
+	scm_id = cp_string( jobs->value );
+	delete_DTGStrList( jobs );
+	claim( "SCM", scm_id );
+	scm_defect = scm_mod->proj_get_defect( scm_projID, scm_id, err );
+	if( scm_index && scm_defect && !err->message )
+	    scm_index->add( defect, scm_id );
+	return scm_defect;
+}
+
 /*
 	Retrieve dt_defect
 	if dts_filters and it doesn't match, continue
@@ -935,7 +1126,7 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	log->log( 3, "Info: process_dts_defect( %s )", defect );
 	report_id = scm_dirty = dts_dirty = 0;
 	struct DTGError *err = new_DTGError( NULL );
-	void *dts_defect = dts_mod->proj_get_defect( dts_projID, defect, err );
+	void *dts_defect = get_defect( 1, defect, err );
 	if( !dts_defect )
 	{
 	    log->log( 0, "Error: Unable to retrieve dts defect: %s", defect );
@@ -949,18 +1140,18 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	char *filter_msg = NULL;
 	if( map->dts_filter_desc && 
 		(filter_msg = 
-		    pass_filter( map->dts_filter_desc, dts_mod, dts_defect ) ) )
+		    pass_filter( map->dts_filter_desc, dts_snap, dts_defect ) ) )
 	{
 	    log->log( 2, "Notice: Filtering dts defect: %s", defect );
 	    log->log( 2, "Notice: %s", filter_msg );
 	    delete[] filter_msg;
 	    filter_msg = NULL;
-	    dts_mod->defect_free( dts_defect, err );
+	    dts_snap->free_defect( dts_defect, err );
 	    delete_DTGError( err );
 	    return;
 	}
 	char *modby = 
-	    dts_mod->defect_get_field( dts_defect, dts->moduser_field, err );
+	    dts_snap->get( dts_defect, dts->moduser_field, err );
 	// ignore err
 	clear_DTGError( err );
 	if( modby && !strcmp( modby, dts->user ) )
@@ -971,14 +1162,14 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	    // Skip if last mod was admin user for those dts that cannot 
 	    // restrict list by user
 	    free( modby );
-	    dts_mod->defect_free( dts_defect, err );
+	    dts_snap->free_defect( dts_defect, err );
 	    delete_DTGError( err );
 	    return;
 	}
 	SAFE_FREE( modby );
 	if( !set->force )
 	{
-	    char *moddate = dts_mod->defect_get_field( dts_defect, 
+	    char *moddate = dts_snap->get( dts_defect, 
 						dts->moddate_field, err );
 	    // ignore err
 	    clear_DTGError( err );
@@ -989,7 +1180,7 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 			defect );
 	        if( moddate )
 	            free( moddate );
-	        dts_mod->defect_free( dts_defect, err );
+	        dts_snap->free_defect( dts_defect, err );
 	        delete_DTGError( err );
 	        return;
 	    }
@@ -1000,7 +1191,7 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	        log->log( 0, "Error: Unable to extract dts moddate: %s date %s", 
 			defect, moddate );
 	        free( moddate );
-	        dts_mod->defect_free( dts_defect, err );
+	        dts_snap->free_defect( dts_defect, err );
 	        delete_DTGError( err );
 	        return;
 	    }
@@ -1010,7 +1201,7 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	        log->log( 2, "Notice: Skipping unmodified dts defect: %s", 
 			defect );
 	        free( moddate );
-	        dts_mod->defect_free( dts_defect, err );
+	        dts_snap->free_defect( dts_defect, err );
 	        delete_DTGError( err );
 	        delete_DTGDate( mystamp );
 	        return;
@@ -1019,23 +1210,13 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	    SAFE_FREE( moddate );
 	}
 
-	char *qual;
-	int matched_mapid = 1;
-	if( map->scm->seg_ok )
-	    qual = mk_string( "DTG_DTISSUE=", defect, 
-				" DTG_MAPID=", map->id );
-	else
-	    qual = mk_string( "DTG_DTISSUE=", defect );
-
-	struct DTGStrList *jobs = 
-		scm_mod->proj_find_defects( scm_projID, 1, qual, err );
-	delete[] qual;
+	char *scm_id;
+	void *scm_defect = get_scm_match( defect, scm_id, err );
 
 	int is_new;
-	void *scm_defect;
 
 	char *loading_err = NULL;
-	if( !jobs )
+	if( !scm_id )
 	{
 	    is_new = 1;
 	    scm_defect = scm_mod->proj_new_defect( scm_projID, err );
@@ -1045,13 +1226,10 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	else
 	{
 	    is_new = 0;
-	    scm_defect = 
-		scm_mod->proj_get_defect( scm_projID, jobs->value, err );
 	    loading_err = cp_string( err->message );
-	    cur_scm = cp_string( jobs->value );
-	    delete_DTGStrList( jobs );
+	    cur_scm = scm_id;
 	    char *value = 
-		scm_mod->defect_get_field( scm_defect, "DTG_ERROR", err );
+		scm_snap->get( scm_defect, "DTG_ERROR", err );
 	    // ignore err
 	    clear_DTGError( err );
 	    if( value && *value )
@@ -1062,8 +1240,8 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	        log->log( 1, 
 			"Warning: Any changes from dts are not replicated: %s",
 			cur_dts );
-	        scm_mod->defect_free( scm_defect, err );
-	        dts_mod->defect_free( dts_defect, err );
+	        scm_snap->free_defect( scm_defect, err );
+	        dts_snap->free_defect( dts_defect, err );
 	        if( loading_err )
 		    delete[] loading_err;
 	        delete_DTGError( err );
@@ -1075,9 +1253,9 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	    delete[] loading_err;
 	    log->log( 0, 
 		"Error: Unable to retrieve matching scm defect: %s(%s)", 
-		defect, jobs ? jobs->value : "new" );
+		defect, cur_scm );
 	    log->log( 0, "Error: %s", err->message );
-	    dts_mod->defect_free( dts_defect, err );
+	    dts_snap->free_defect( dts_defect, err );
 	    delete_DTGError( err );
 	    return;
 	}
@@ -1091,8 +1269,8 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	    scm_failed = append_DTGField( scm_failed,
 					new_DTGField( cur_scm, err_msg ) );
 	    delete[] err_msg;
-	    scm_mod->defect_free( scm_defect, err );
-	    dts_mod->defect_free( dts_defect, err );
+	    scm_snap->free_defect( scm_defect, err );
+	    dts_snap->free_defect( dts_defect, err );
 	    delete_DTGError( err );
 	    return;
 	}
@@ -1112,10 +1290,10 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	    struct DTGStrList *add, *del;
 	    char *rev = update_fix_record( cur_scm, scm_defect, add, del);
 	    char *value = 
-		scm_mod->defect_get_field( scm_defect, "DTG_FIXES", err );
+		scm_snap->get( scm_defect, "DTG_FIXES", err );
 	    // ignore err
 	    clear_DTGError( err );
-	    if( set_field( scm_mod, scm_defect, "DTG_FIXES", rev, value, err ) )
+	    if( set_field( scm_snap, scm_defect, "DTG_FIXES", rev, value, err ) )
 	    {
 	        log->log( 3, "Info: Set SCM:DTG_FIXES to [%s]", rev );
 	        scm_dirty++;
@@ -1134,7 +1312,7 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	    }
 	    else
 	    {
-	        char *tmp_free = scm_mod->defect_get_field( 
+	        char *tmp_free = scm_snap->get( 
 					scm_defect, scm->moddate_field, err );
 	        // ignore err
 	        clear_DTGError( err );
@@ -1176,11 +1354,9 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	    }
 	}
 
-	char *id = NULL;
-
 	if( map->scm_filter_desc && 
 		( filter_msg = 
-		    pass_filter( map->scm_filter_desc, scm_mod, scm_defect ) ) )
+		    pass_filter( map->scm_filter_desc, scm_snap, scm_defect ) ) )
 	{
 	    if( !is_new )
 	    {
@@ -1201,7 +1377,7 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 	}
 	if( map->dts_filter_desc && 
 		(filter_msg = 
-		    pass_filter( map->dts_filter_desc, dts_mod, dts_defect ) ) )
+		    pass_filter( map->dts_filter_desc, dts_snap, dts_defect ) ) )
 	{
 	    log->log( 0, 
 		"Error: Updated DTS issue fails filter test, aborted: %s", 
@@ -1217,142 +1393,849 @@ void Unify::process_dts_defect( const char *defect, int last_chance )
 
 	log->log( 3, "Info: Finished processing mappings" );
 
+	UnifySave *pair = new UnifySave( 1, defect, is_new, last_chance );
+	pair->scm_defect = scm_defect;
+	pair->dts_defect = dts_defect;
+	pair->old_fixes = old_fixes;
+	delete_DTGError( err );
+	save_defects( pair );
+}
+
+/*
+	Save a unified pair: DTS first, as its result decides what is
+	written back to the SCM defect (DTG_ERROR, restored DTG_FIXES or the
+	new DTG_DTISSUE), then the SCM. While deferring the pair is held,
+	with its claims, for commit_saves().
+*/
+
+void Unify::save_defects( UnifySave *pair )
+{
+	if( defer_saves )
+	{
+	    pair->cur_scm = cur_scm ? cp_string( cur_scm ) : NULL;
+	    pair->cur_dts = cur_dts ? cp_string( cur_dts ) : NULL;
+	    pair->report_id = report_id;
+	    pair->scm_dirty = scm_dirty;
+	    pair->dts_dirty = dts_dirty;
+	    pair->claims = claims;
+	    claims = NULL;
+	    UnifySave **last = &pending;
+	    while( *last )
+	        last = &(*last)->next;
+	    *last = pair;
+	    return;
+	}
+
+	struct DTGError *err = new_DTGError( NULL );
 	if( dts_dirty )
 	{
 	    log->log( 3, "Info: DTS has changes" );
-	    id = dts_mod->defect_save( dts_defect, err );
-	    if( err->message )
-	    {
-	        log->log( 0, "Error: saving dts defect(%s): scm: %s", 
-			defect, cur_scm );
-	        log->log( 0, "[%s]", err->message );
-	        log->log( 1, "Warning: Set DTG_ERROR: %s", err->message );
-	        char *tmp_err = mk_string( err->message );
-	        scm_mod->defect_set_field( scm_defect, "DTG_ERROR",
-					tmp_err, err );
-	        delete[] tmp_err;
-	        scm_dirty++;
-	        // RESTORE DTG_FIXES
-	        if( old_fixes )
-	            scm_mod->defect_set_field( scm_defect, "DTG_FIXES",
-						old_fixes, err );
-	    }
-	    else if( id )
+	    char *id = dts_mod->defect_save( pair->dts_defect, err );
+	    dts_snap->forget( pair->dts_defect );
+	    saved_dts( pair, id, err );
+	    SAFE_FREE( id );
+	}
+	saving_scm( pair );
+	if( scm_dirty )
+	{
+	    log->log( 3, "Info: SCM has changes" );
+	    char *id = scm_mod->defect_save( pair->scm_defect, err );
+	    scm_snap->forget( pair->scm_defect );
+	    saved_scm( pair, id, err );
+	    SAFE_FREE( id );
+	}
+	scm_snap->free_defect( pair->scm_defect, err );
+	dts_snap->free_defect( pair->dts_defect, err );
+	delete pair;
+	delete_DTGError( err );
+}
+
+void Unify::commit_saves()
+{
+	if( !pending )
+	    return;
+
+	UnifySave *list = pending;
+	pending = NULL;
+	int cnt = 0;
+	UnifySave *pair;
+	for( pair = list; pair; pair = pair->next )
+	    cnt++;
+	UnifySave **items = new UnifySave *[cnt];
+	void **defects = new void *[cnt];
+	char **ids = new char *[cnt];
+	struct DTGError *errs = new struct DTGError[cnt];
+	memset( errs, 0, sizeof(struct DTGError) * cnt );
+	char tmp[32];
+
+	int n = 0;
+	for( pair = list; pair; pair = pair->next )
+	    if( pair->dts_dirty )
 	    {
-	        log->log( 2, "saving dts defect: %s", id );
-	        int ll = dts_mod->dt_get_message( dts_dtID, err );
-	        if( ll < 4 )
-	            log->log( ll, err->message );
+	        items[n] = pair;
+	        defects[n++] = pair->dts_defect;
 	    }
-	    else
+	if( n )
+	{
+	    sprintf( tmp, "%d", n );
+	    log->log( 3, "Info: Saving %s DTS defects", tmp );
+	    dts_mod->proj_save_defects( dts_projID, n, defects, ids, errs );
+	    for( int i = 0; i < n; i++ )
 	    {
-	        log->log( 0, 
-			"Error:dts defect_save returned null: dts:%s scm:%s", 
-			cur_dts, cur_scm );
-	        log->log( 1, "Warning: Set DTG_ERROR:No id returned from DTS" );
-	        scm_mod->defect_set_field( scm_defect, "DTG_ERROR", 
-			"No id returned from DTS for save_defect", err );
-	        scm_dirty++;
-	        // RESTORE DTG_FIXES
-	        if( old_fixes )
-	            scm_mod->defect_set_field( scm_defect, "DTG_FIXES",
-						old_fixes, err );
+	        swap_save( items[i] );
+	        saved_dts( items[i], ids[i], &errs[i] );
+	        swap_save( items[i] );
+	        SAFE_FREE( ids[i] );
+	        clear_DTGError( &errs[i] );
 	    }
-	    SAFE_FREE( id );
 	}
-	if( old_fixes )
-	    delete[] old_fixes;
 
-	if( is_new && ( scm_dirty || dts_dirty ) )
+	n = 0;
+	for( pair = list; pair; pair = pair->next )
 	{
-	    scm_mod->defect_set_field( scm_defect, "DTG_DTISSUE", defect, err );
-	    if( map->scm->seg_ok )
-	        scm_mod->defect_set_field( scm_defect, 
-						"DTG_MAPID", map->id, err );
-	    scm_dirty++;
-	}
-	if( scm_dirty )
-	{
-	    log->log( 3, "Info: SCM has changes" );
-	    id = scm_mod->defect_save( scm_defect, err );
-	    if( err->message )
+	    swap_save( pair );
+	    saving_scm( pair );
+	    swap_save( pair );
+	    if( pair->scm_dirty )
 	    {
-	        log->log( 0, "Error: saving scm defect(%s): dts:%s", 
-			cur_scm, cur_dts );
-	        log->log( 0, "[%s]", err->message );
-	        if( !is_new )
-	            log_fatal( last_chance, err->message );
-	        // else error?
+	        items[n] = pair;
+	        defects[n++] = pair->scm_defect;
 	    }
-	    else 
+	}
+	if( n )
+	{
+	    sprintf( tmp, "%d", n );
+	    log->log( 3, "Info: Saving %s SCM defects", tmp );
+	    scm_mod->proj_save_defects( scm_projID, n, defects, ids, errs );
+	    for( int i = 0; i < n; i++ )
 	    {
-	        if( is_new )
-	        {
-	            log->log( report_id ? 0 : 2, "create scm defect: %s", id );
-	            /* Copy rule uses ID, schedule re-unification of defects */
-	            if( map->recheck_on_new_scm )
-	                scm_recheck = append_DTGStrList( scm_recheck, id );
-	        }
-	        else
-	            log->log( 2, "saving scm defect: %s", id );
-	        int ll = scm_mod->dt_get_message( scm_dtID, err );
-	        if( ll < 4 )
-	            log->log( ll, err->message );
+	        swap_save( items[i] );
+	        saved_scm( items[i], ids[i], &errs[i] );
+	        swap_save( items[i] );
+	        SAFE_FREE( ids[i] );
+	        clear_DTGError( &errs[i] );
 	    }
-	    SAFE_FREE( id );
 	}
 
-	scm_mod->defect_free( scm_defect, err );
-	dts_mod->defect_free( dts_defect, err );
+	struct DTGError *err = new_DTGError( NULL );
+	while( list )
+	{
+	    pair = list;
+	    list = list->next;
+	    scm_snap->free_defect( pair->scm_defect, err );
+	    dts_snap->free_defect( pair->dts_defect, err );
+	    swap_save( pair );
+	    release_claims();
+	    swap_save( pair );
+	    delete pair;
+	}
 	delete_DTGError( err );
+	delete[] items;
+	delete[] defects;
+	delete[] ids;
+	delete[] errs;
 }
 
-int Unify::stop_exists()
+/* Exchange the per-defect state of the engine with that of a held pair */
+
+void Unify::swap_save( UnifySave *pair )
+{
+	char *tmp = cur_scm;
+	cur_scm = pair->cur_scm;
+	pair->cur_scm = tmp;
+	tmp = cur_dts;
+	cur_dts = pair->cur_dts;
+	pair->cur_dts = tmp;
+	int i = report_id;
+	report_id = pair->report_id;
+	pair->report_id = i;
+	i = scm_dirty;
+	scm_dirty = pair->scm_dirty;
+	pair->scm_dirty = i;
+	i = dts_dirty;
+	dts_dirty = pair->dts_dirty;
+	pair->dts_dirty = i;
+	struct DTGStrList *held = claims;
+	claims = pair->claims;
+	pair->claims = held;
+}
+
+void Unify::saved_dts( UnifySave *pair, const char *id, 
+			struct DTGError *err )
 {
-	struct stat buf;
-	if( stat( run_file, &buf ) )
+	if( err->message )
 	{
-	    log->log( 0, "Error: run_file missing, recreating: %s", run_file );
-	    FILE *fd = fopen( run_file, "a" );
-	    if( fd )
-	        fclose( fd );
+	    if( pair->dts_pass )
+	        log->log( 0, "Error: saving dts defect(%s): scm: %s", 
+			pair->defect, cur_scm );
+	    else
+	        log->log( 0, "Error: saving dts defect(%s): scm:%s", 
+			cur_dts, pair->defect );
+	    log->log( 0, "[%s]", err->message );
+	    log->log( 1, "Warning: Set DTG_ERROR: %s", err->message );
+	    char *tmp_err = mk_string( err->message );
+	    scm_snap->set( pair->scm_defect, "DTG_ERROR", 
+			tmp_err, err );
+	    delete[] tmp_err;
+	    scm_dirty++;
+	    // RESTORE DTG_FIXES
+	    if( pair->old_fixes )
+	        scm_snap->set( pair->scm_defect, "DTG_FIXES",
+					pair->old_fixes, err );
 	}
-	if( !stat( stop_file, &buf ) )
+	else if( id )
 	{
-	    log->log( 0, "Discovered stop_file, beginning shutdown" );
-	    return 1;
+	    if( pair->dts_pass )
+	        log->log( 2, "saving dts defect: %s", id );
+	    else if( pair->is_new )
+	    {
+	        log->log( report_id ? 0 : 2, 
+			"create dts defect(%s): scm:%s", id, pair->defect );
+	        scm_snap->set( pair->scm_defect, "DTG_DTISSUE", 
+					id, err );
+	        if( scm_index )
+	            scm_index->add( id, pair->defect );
+	        delete[] cur_dts;
+	        cur_dts = mk_string( "new:", id );
+	        scm_dirty++;
+	        /* Copy rule uses ID, schedule re-unification of defects */
+	        if( map->recheck_on_new_dts )
+	            scm_recheck = append_DTGStrList( scm_recheck, cur_scm );
+	    }
+	    else
+	        log->log( 2, "saving dts defect(%s): scm:%s", 
+			id, pair->defect );
+	    int ll = dts_mod->dt_get_message( dts_dtID, err );
+	    if( ll < 4 )
+	        log->log( ll, err->message );
 	}
-	if( force_exit )
+	else
 	{
-	    log->log( 0, "Forcing exit, beginning shutdown" );
-	    FILE *fd = fopen( stop_file, "a" );
-	    if( fd )
-	        fclose( fd );
-	    return 1;
+	    log->log( 0, 
+		"Error:dts defect_save returned null: dts:%s scm:%s", 
+		cur_dts, pair->dts_pass ? cur_scm : pair->defect );
+	    log->log( 1, "Warning: Set DTG_ERROR:No id returned from DTS" );
+	    scm_snap->set( pair->scm_defect, "DTG_ERROR", 
+			"No id returned from DTS for save_defect", err );
+	    scm_dirty++;
+	    // RESTORE DTG_FIXES
+	    if( pair->old_fixes )
+	        scm_snap->set( pair->scm_defect, "DTG_FIXES",
+					pair->old_fixes, err );
 	}
-	return 0;
 }
 
-int Unify::unify( DTGSettings *in_set )
+void Unify::saving_scm( UnifySave *pair )
 {
-	set = in_set;
-	DTGError *err = new_DTGError( NULL );
+	if( pair->old_fixes )
+	    delete[] pair->old_fixes;
+	pair->old_fixes = NULL;
 
-	if( set->force )
+	if( pair->dts_pass && pair->is_new && ( scm_dirty || dts_dirty ) )
 	{
-	    set_DTGDate( set->last_update_scm, set->starting_date );
-	    set_DTGDate( set->last_update_dts, set->starting_date );
+	    struct DTGError *err = new_DTGError( NULL );
+	    scm_snap->set( pair->scm_defect, "DTG_DTISSUE", 
+					pair->defect, err );
+	    if( map->scm->seg_ok )
+	        scm_snap->set( pair->scm_defect, 
+					"DTG_MAPID", map->id, err );
+	    delete_DTGError( err );
+	    scm_dirty++;
 	}
-	since_scm = set->last_update_scm;
-	since_dts = set->last_update_dts;
+}
 
-	struct DTGDate *scm_date = scm_mod->dt_get_server_date( scm_dtID, err );
-	if( err->message )
+void Unify::saved_scm( UnifySave *pair, const char *id, 
+			struct DTGError *err )
+{
+	if( !pair->dts_pass )
+	{
+	    if( err->message )
+	        // Only retry if it failed updating not creating
+	        if( pair->is_new )
+	        {
+	            log_fatal( 1, err->message );
+	            log->log( 0, 
+			"Error: Orphan dts defect created dts:%s (scm: %s)", 
+			cur_dts, cur_scm );
+	        }
+	        else
+	            log_fatal( pair->last_chance, err->message );
+	    else
+	    {
+	        log->log( 2, "saving scm defect: %s", id );
+	        int ll = scm_mod->dt_get_message( scm_dtID, err );
+	        if( ll < 4 )
+	            log->log( ll, err->message );
+	    }
+	    return;
+	}
+
+	if( err->message )
+	{
+	    log->log( 0, "Error: saving scm defect(%s): dts:%s", 
+			cur_scm, cur_dts );
+	    log->log( 0, "[%s]", err->message );
+	    if( !pair->is_new )
+	        log_fatal( pair->last_chance, err->message );
+	    // else error?
+	}
+	else 
+	{
+	    if( pair->is_new )
+	    {
+	        log->log( report_id ? 0 : 2, "create scm defect: %s", id );
+	        if( scm_index )
+	            scm_index->add( pair->defect, id );
+	        /* Copy rule uses ID, schedule re-unification of defects */
+	        if( map->recheck_on_new_scm )
+	            scm_recheck = append_DTGStrList( scm_recheck, id );
+	    }
+	    else
+	        log->log( 2, "saving scm defect: %s", id );
+	    int ll = scm_mod->dt_get_message( scm_dtID, err );
+	    if( ll < 4 )
+	        log->log( ll, err->message );
+	}
+}
+
+int Unify::stop_exists()
+{
+	if( control->check() )
+	    return 1;
+	if( force_exit )
+	{
+	    log->log( 0, "Forcing exit, beginning shutdown" );
+	    FILE *fd = fopen( stop_file, "a" );
+	    if( fd )
+	        fclose( fd );
+	    return 1;
+	}
+	return 0;
+}
+
+/*
+	Worker pool: started on the first cycle when worker_threads > 1,
+	each worker holding its own SCM and DTS connection. Dropped on a
+	server reset and reconnected at the start of the next cycle.
+*/
+
+int Unify::start_workers()
+{
+	if( parent || WORKER_THREADS <= 1 )
+	    return 0;
+	if( workers )
+	    return worker_cnt;
+
+	pool = new UnifyPool();
+	workers = new Unify *[WORKER_THREADS];
+	worker_cnt = 0;
+	for( int i = 0; i < WORKER_THREADS; i++ )
+	{
+	    Unify *worker = new Unify( this );
+	    if( !worker->scm_projID || !worker->dts_projID )
+	    {
+	        log->log( 0, "Error: Unable to connect replication worker" );
+	        delete worker;
+	        break;
+	    }
+	    workers[worker_cnt++] = worker;
+	}
+
+	// The threads wait in worker_main() for pages until stop_workers().
+	// Each has begun with the plug-ins before the first page is listed.
+	pool->threads = new std::thread *[worker_cnt];
+	pool->busy = worker_cnt;
+	for( int i = 0; i < worker_cnt; i++ )
+	    pool->threads[i] = new std::thread( &Unify::worker_main, workers[i] );
+	{
+	    std::unique_lock<std::mutex> guard( pool->lock );
+	    while( pool->busy )
+	        pool->idle.wait( guard );
+	}
+	char cnt[32];
+	sprintf( cnt, "%d", worker_cnt );
+	log->log( 2, "Info: Started %s replication workers", cnt );
+	return worker_cnt;
+}
+
+void Unify::stop_workers()
+{
+	if( parent || !workers )
+	    return;
+	{
+	    std::lock_guard<std::mutex> guard( pool->lock );
+	    pool->quit = 1;
+	}
+	pool->work.notify_all();
+	for( int i = 0; i < worker_cnt; i++ )
+	{
+	    pool->threads[i]->join();
+	    delete pool->threads[i];
+	}
+	delete[] pool->threads;
+	pool->threads = NULL;
+	for( int i = 0; i < worker_cnt; i++ )
+	    delete workers[i];
+	delete[] workers;
+	workers = NULL;
+	worker_cnt = 0;
+	delete pool;
+	pool = NULL;
+}
+
+/*
+	Hand one page to the workers. They run until end_workers(), leaving
+	the parent connection free to list the next page meanwhile.
+*/
+
+void Unify::begin_workers( struct DTGStrList *defects, int dts_pass )
+{
+	// The workers are idle between pages, so their state is ours
+	for( int i = 0; i < worker_cnt; i++ )
+	{
+	    workers[i]->set = set;
+	    workers[i]->since_scm = since_scm;
+	    workers[i]->since_dts = since_dts;
+	    workers[i]->defer_saves = defer_saves;
+	}
+
+	{
+	    std::lock_guard<std::mutex> guard( pool->lock );
+	    pool->next = defects;
+	    pool->remaining = 0L;
+	    for( struct DTGStrList *d = defects; d; d = d->next )
+	        pool->remaining++;
+	    pool->stop_process = 0;
+	    pool->dts_pass = dts_pass;
+	    pool->busy = worker_cnt;
+	    pool->page++;
+	}
+	pool->work.notify_all();
+}
+
+int Unify::end_workers()
+{
+	std::unique_lock<std::mutex> guard( pool->lock );
+	while( pool->busy )
+	    pool->idle.wait( guard );
+	pool->next = NULL;
+	guard.unlock();
+
+	// Collect the retry and failure lists for the serial passes
+	for( int i = 0; i < worker_cnt; i++ )
+	{
+	    scm_recheck = merge_DTGStrList( scm_recheck, 
+					workers[i]->scm_recheck );
+	    workers[i]->scm_recheck = NULL;
+	    scm_failed = append_DTGField( scm_failed, 
+					workers[i]->scm_failed );
+	    workers[i]->scm_failed = NULL;
+	}
+	return pool->stop_process;
+}
+
+/*
+	A worker thread: takes its share of each page handed out until the
+	pool quits. Plug-ins keeping per-thread client state (MySQL) are
+	told when the thread starts and ends using their connections.
+*/
+
+void Unify::worker_main()
+{
+	scm_mod->dt_thread_begin();
+	dts_mod->dt_thread_begin();
+	{
+	    std::lock_guard<std::mutex> guard( pool->lock );
+	    if( !--pool->busy )
+	        pool->idle.notify_all();
+	}
+	long page = 0L;
+	while( 1 )
+	{
+	    int dts_pass;
+	    {
+	        std::unique_lock<std::mutex> guard( pool->lock );
+	        while( !pool->quit && pool->page == page )
+	            pool->work.wait( guard );
+	        if( pool->quit )
+	            break;
+	        page = pool->page;
+	        dts_pass = pool->dts_pass;
+	    }
+
+	    worker_loop( dts_pass );
+
+	    std::lock_guard<std::mutex> guard( pool->lock );
+	    if( !--pool->busy )
+	        pool->idle.notify_all();
+	}
+	scm_mod->dt_thread_end();
+	dts_mod->dt_thread_end();
+}
+
+void Unify::worker_loop( int dts_pass )
+{
+	while( 1 )
+	{
+	    struct DTGStrList *chunk;
+	    int cnt = 0;
+	    {
+	        std::lock_guard<std::mutex> guard( pool->lock );
+	        if( pool->stop_process || !pool->next )
+	            break;
+
+	        // Split what is left so the workers finish together
+	        long want = pool->remaining / parent->worker_cnt;
+	        if( want > FETCH_CHUNK )
+	            want = FETCH_CHUNK;
+	        chunk = pool->next;
+	        do
+	        {
+	            pool->next = pool->next->next;
+	            cnt++;
+	        } while( cnt < want && pool->next );
+	        pool->remaining -= cnt;
+	    }
+
+	    prefetch( chunk, cnt, dts_pass );
+	    for( int i = 0; i < cnt; i++, chunk = chunk->next )
+	    {
+	        {
+	            std::lock_guard<std::mutex> guard( pool->lock );
+	            if( pool->stop_process )
+	                break;
+	            log_large_cycles( log, ++pool->items );
+	        }
+
+	        const char *defect = chunk->value;
+	        if( cur_dts ) delete[] cur_dts;
+	        if( cur_scm ) delete[] cur_scm;
+	        cur_dts = cur_scm = NULL;
+	        if( dts_pass )
+	        {
+	            cur_dts = cp_string( defect );
+	            claim( "DTS", defect );
+	            process_dts_defect( defect );
+	        }
+	        else
+	        {
+	            cur_scm = cp_string( defect );
+	            claim( "SCM", defect );
+	            process_scm_defect( defect );
+	        }
+	        release_claims();
+
+	        parent->control->progress.done++;
+	        parent->control->progress.defects++;
+
+	        std::lock_guard<std::mutex> guard( pool->lock );
+	        if( force_exit )
+	            parent->force_exit = 1;
+	        if( !pool->stop_process )
+	            pool->stop_process = parent->stop_exists();
+	    }
+	    commit_saves();
+	    drop_fetched();
+	}
+}
+
+/*
+	Process the changed defects of one pass a page at a time from a
+	proj_open_changed_defects cursor. With workers the next page is
+	listed while they work through the current one. Each page is
+	journaled once done. Returns -1 if the list could not be
+	retrieved, otherwise whether to stop.
+*/
+
+int Unify::run_pass( int dts_pass, void *cursor, long &listed,
+			struct DTGError *err )
+{
+	DTGModule *mod = dts_pass ? dts_mod : scm_mod;
+	int stop_process = 0;
+	long items = 0L;
+	int threaded = start_workers();
+	if( threaded )
+	    pool->items = 0L;
+	ReplProgress &progress = control->progress;
+	progress.pass = dts_pass ? ReplProgress::DTS : ReplProgress::SCM;
+	progress.done = 0L;
+	progress.listed = 0L;
+	char phase = dts_pass ? CycleJournal::DTS : CycleJournal::SCM;
+	long skipped = 0L;
+
+	struct DTGStrList *page = 
+		list_page( mod, cursor, dts_pass, skipped, err );
+	while( page && !err->message && !stop_process )
+	{
+	    long page_cnt = 0L;
+	    for( struct DTGStrList *d = page; d; d = d->next )
+	        page_cnt++;
+	    listed += page_cnt;
+	    progress.listed += page_cnt;
+
+	    struct DTGStrList *next_page = NULL;
+	    if( threaded )
+	    {
+	        begin_workers( page, dts_pass );
+	        next_page = list_page( mod, cursor, dts_pass, skipped, err );
+	        stop_process = end_workers();
+	        if( journal && !stop_process )
+	            journal->record( phase, page, NULL );
+	    }
+	    else
+	    {
+	        long pos = 0L;
+	        struct DTGStrList *d;
+	        for( d = page; d && !stop_process; d = d->next, pos++ )
+	        {
+	            if( cur_dts ) delete[] cur_dts;
+	            if( cur_scm ) delete[] cur_scm;
+	            cur_dts = cur_scm = NULL;
+	            if( dts_pass )
+	                cur_dts = cp_string( d->value );
+	            else
+	                cur_scm = cp_string( d->value );
+	            if( !( pos % FETCH_CHUNK ) )
+	            {
+	                commit_saves();
+	                prefetch( d, FETCH_CHUNK, dts_pass );
+	            }
+	            log_large_cycles( log, ++items );
+	            if( dts_pass )
+	                process_dts_defect( d->value );
+	            else
+	                process_scm_defect( d->value );
+	            progress.done++;
+	            progress.defects++;
+	            stop_process = stop_exists();
+	        }
+	        commit_saves();
+	        drop_fetched();
+	        if( journal )
+	            journal->record( phase, page, d );
+	        if( !stop_process )
+	            next_page = 
+			list_page( mod, cursor, dts_pass, skipped, err );
+	    }
+	    if( journal )
+	    {
+	        journal->record_lists( scm_recheck, scm_failed );
+	        journal->checkpoint();
+	    }
+	    if( scm_index )
+	        scm_index->sync();
+	    delete_DTGStrList( page );
+	    page = next_page;
+	}
+	if( page )
+	    delete_DTGStrList( page );
+
+	log_large_cycles( log, listed, dts_pass ? "DTS" : "SCM" );
+	if( skipped )
+	{
+	    char cnt[32];
+	    sprintf( cnt, "%ld", skipped );
+	    log->log( 1, "Info: Skipped %s defects unified before the "
+			"cycle was interrupted", cnt );
+	}
+	if( err->message && !stop_process )
+	    return -1;
+	return stop_process;
+}
+
+/*
+	The next page of a pass less the defects the journal has as done,
+	listing on while a page is left empty. The first page with work
+	starts the cycle.
+*/
+
+struct DTGStrList *Unify::list_page( DTGModule *mod, void *cursor, 
+				int dts_pass, long &skipped,
+				struct DTGError *err )
+{
+	char phase = dts_pass ? CycleJournal::DTS : CycleJournal::SCM;
+	while( 1 )
+	{
+	    struct DTGStrList *page = mod->cursor_next_defects( cursor, err );
+	    if( page && !err->message && !scm_date &&
+		( cycle_ret = start_cycle() ) < 0 )
+	    {
+	        delete_DTGStrList( page );
+	        set_DTGError( err, "Unable to retrieve server dates" );
+	        return NULL;
+	    }
+	    if( !page || err->message || !journal || !journal->entries() )
+	        return page;
+	    long cnt = 0L;
+	    for( struct DTGStrList *d = page; d; d = d->next )
+	        cnt++;
+	    page = journal->skip_done( phase, page );
+	    for( struct DTGStrList *d = page; d; d = d->next )
+	        cnt--;
+	    skipped += cnt;
+	    if( page )
+	        return page;
+	}
+}
+
+/*
+	Load the next defects of a pass in one proj_get_defects call when
+	the plug-in supports it. Each is taken by get_defect() when its turn
+	comes; anything not taken is freed by drop_fetched(). The handles
+	belong to this connection, so every worker prefetches its own.
+*/
+
+void Unify::prefetch( struct DTGStrList *from, int cnt, int dts_side )
+{
+	drop_fetched();
+	DTGModule *mod = dts_side ? dts_mod : scm_mod;
+	if( !mod->has_bulk_extensions() || cnt <= 1 )
+	    return;
+
+	for( ; from && fetched_cnt < cnt; from = from->next, fetched_cnt++ )
+	    fetched_ids = append_DTGStrList( fetched_ids, from->value );
+	fetched = new void *[fetched_cnt];
+	memset( fetched, 0, sizeof(void *) * fetched_cnt );
+	fetched_dts = dts_side;
+
+	DTGError *err = new_DTGError( NULL );
+	int got = mod->proj_get_defects( dts_side ? dts_projID : scm_projID,
+					fetched_ids, fetched, err );
+	if( err->message )
+	    // Each defect is loaded on its own instead
+	    log->log( 1, "Warning: Unable to prefetch %s defects: %s",
+			dts_side ? "DTS" : "SCM", err->message );
+	else
+	{
+	    char tmp[64];
+	    sprintf( tmp, "%d of %d", got, fetched_cnt );
+	    log->log( 3, "Info: Prefetched %s defects", tmp );
+	}
+	delete_DTGError( err );
+}
+
+void *Unify::get_defect( int dts_side, const char *id, struct DTGError *err )
+{
+	if( fetched && fetched_dts == dts_side )
+	{
+	    int i = 0;
+	    for( struct DTGStrList *f = fetched_ids; f; f = f->next, i++ )
+	        if( fetched[i] && !strcmp( f->value, id ) )
+	        {
+	            void *defect = fetched[i];
+	            fetched[i] = NULL;
+	            clear_DTGError( err );
+	            return defect;
+	        }
+	}
+	if( dts_side )
+	    return dts_mod->proj_get_defect( dts_projID, id, err );
+	return scm_mod->proj_get_defect( scm_projID, id, err );
+}
+
+void Unify::drop_fetched()
+{
+	if( fetched )
+	{
+	    FieldSnapshot *snap = fetched_dts ? dts_snap : scm_snap;
+	    DTGError *err = new_DTGError( NULL );
+	    for( int i = 0; i < fetched_cnt; i++ )
+	        if( fetched[i] )
+	            snap->free_defect( fetched[i], err );
+	    delete_DTGError( err );
+	    delete[] fetched;
+	    fetched = NULL;
+	}
+	if( fetched_ids )
+	    delete_DTGStrList( fetched_ids );
+	fetched_ids = NULL;
+	fetched_cnt = 0;
+}
+
+/*
+	Workers only: wait until no other worker is unifying the defect,
+	then hold it until release_claims(). A worker claims its own
+	defect first and the matching one second, all workers in a pass
+	claim the same side first, so the wait cannot deadlock.
+*/
+
+void Unify::claim( const char *type, const char *id )
+{
+	if( !parent || !id )
+	    return;
+
+	char *key = mk_string( type, ":", id );
+	if( in_DTGStrList( key, claims ) )
+	{
+	    delete[] key;
+	    return;
+	}
+	std::unique_lock<std::mutex> guard( pool->lock );
+	while( in_DTGStrList( key, pool->in_flight ) )
+	{
+	    if( pending )
+	    {
+	        // The other worker may be waiting on our held saves
+	        guard.unlock();
+	        commit_saves();
+	        guard.lock();
+	        continue;
+	    }
+	    log->log( 3, "Info: Waiting on in-flight defect %s", key );
+	    pool->released.wait( guard );
+	}
+	pool->in_flight = append_DTGStrList( pool->in_flight, key );
+	guard.unlock();
+	claims = append_DTGStrList( claims, key );
+	delete[] key;
+}
+
+void Unify::unclaim( const char *type, const char *id )
+{
+	if( !parent || !id )
+	    return;
+
+	char *key = mk_string( type, ":", id );
+	if( in_DTGStrList( key, claims ) )
+	{
+	    std::lock_guard<std::mutex> guard( pool->lock );
+	    pool->in_flight = remove_item_DTGStrList( pool->in_flight, key );
+	    claims = remove_item_DTGStrList( claims, key );
+	    pool->released.notify_all();
+	}
+	delete[] key;
+}
+
+void Unify::release_claims()
+{
+	if( !claims )
+	    return;
+
+	std::lock_guard<std::mutex> guard( pool->lock );
+	for( struct DTGStrList *c = claims; c; c = c->next )
+	    pool->in_flight = 
+		remove_item_DTGStrList( pool->in_flight, c->value );
+	delete_DTGStrList( claims );
+	claims = NULL;
+	pool->released.notify_all();
+}
+
+/*
+	Read the server dates the cycle replicates up to, dated back to
+	when it began listing, and begin its journal. Called once the cycle
+	finds work, so an idle cycle makes no round trip to either server.
+	Returns 1, or -1 / -2 as unify() does when a date cannot be read.
+*/
+
+int Unify::start_cycle()
+{
+	DTGError *err = new_DTGError( NULL );
+	scm_date = scm_clock->date_at( scm_mod, scm_dtID, cycle_start, err );
+	if( err->message )
 	{
 	    log->log( 0, "Error: Unable to retrieve scm date: %s", 
 			err->message );
-	    if( scm_date )
-	        delete_DTGDate( scm_date );
+	    drop_dates();
 	    clear_DTGError( err );
 	    int scm = scm_mod->dt_server_offline( scm_dtID, err );
 	    delete_DTGError( err );
@@ -1374,14 +2257,12 @@ int Unify::unify( DTGSettings *in_set )
 			// XXX may generate this so leave it as is for now
 	}
 
-	struct DTGDate *dts_date = dts_mod->dt_get_server_date( dts_dtID, err );
+	dts_date = dts_clock->date_at( dts_mod, dts_dtID, cycle_start, err );
 	if( err->message )
 	{
 	    log->log( 0, "Error: Unable to retrieve dts date: %s", 
 			err->message );
-	    delete_DTGDate( scm_date );
-	    if( dts_date )
-	        delete_DTGDate( dts_date );
+	    drop_dates();
 	    clear_DTGError( err );
 	    int dts = dts_mod->dt_server_offline( dts_dtID, err );
 	    delete_DTGError( err );
@@ -1393,7 +2274,7 @@ int Unify::unify( DTGSettings *in_set )
 	{
 	    log->log( 0, "Error: Invalid plugin behavior by DTS plugin" );
 	    log->log( 0, "Error: Neither date nor error message returned" );
-	    delete_DTGDate( scm_date );
+	    drop_dates();
 	    clear_DTGError( err );
 	    int dts = dts_mod->dt_server_offline( dts_dtID, err );
 	    delete_DTGError( err );
@@ -1403,8 +2284,13 @@ int Unify::unify( DTGSettings *in_set )
 			// XXX Though a disconnected server at the wrong time
 			// XXX may generate this so leave it as is for now
 	}
+	delete_DTGError( err );
+
+	// An interrupted cycle over the same changes picks up where it was
+	if( journal && journal->begin( since_scm, since_dts, set->force,
+				scm_date, dts_date, scm_recheck, scm_failed ) )
+	    log->log( 1, "Info: Resuming interrupted cycle" );
 
-	int stop_process = 0;
 	char since_string[255];
 	sprintf( since_string, "SCM: %4.4d/%2.2d/%2.2d %2.2d:%2.2d:%2.2d",
 		scm_date->year, scm_date->month, scm_date->day,
@@ -1414,6 +2300,37 @@ int Unify::unify( DTGSettings *in_set )
 		dts_date->year, dts_date->month, dts_date->day,
 		dts_date->hour, dts_date->minute, dts_date->second );
 	log->log( 2, "Start date at %s", since_string );
+	return 1;
+}
+
+void Unify::drop_dates()
+{
+	if( scm_date )
+	    delete_DTGDate( scm_date );
+	if( dts_date )
+	    delete_DTGDate( dts_date );
+	scm_date = dts_date = NULL;
+}
+
+int Unify::unify( DTGSettings *in_set )
+{
+	set = in_set;
+	DTGError *err = new_DTGError( NULL );
+
+	if( set->force )
+	{
+	    set_DTGDate( set->last_update_scm, set->starting_date );
+	    set_DTGDate( set->last_update_dts, set->starting_date );
+	}
+	since_scm = set->last_update_scm;
+	since_dts = set->last_update_dts;
+
+	drop_dates();
+	cycle_ret = 0;
+	cycle_start = ServerClock::steady();
+
+	int stop_process = 0;
+	char since_string[255];
 	sprintf( since_string, "%4.4d/%2.2d/%2.2d %2.2d:%2.2d:%2.2d%s",
 		since_dts->year, since_dts->month, since_dts->day,
 		since_dts->hour, since_dts->minute, since_dts->second,
@@ -1421,9 +2338,9 @@ int Unify::unify( DTGSettings *in_set )
 	log->log( 2, "List DTS Defects since: %s", since_string );
 	query_cnt++;
 
-	struct DTGStrList *dts_defects = dts_mod->proj_list_changed_defects( 
+	void *dts_cursor = dts_mod->proj_open_changed_defects( 
 						dts_projID,
-						0,
+						LIST_PAGE,
 						since_dts,
 						dts->moddate_field,
 						set->force ? NULL :
@@ -1431,56 +2348,50 @@ int Unify::unify( DTGSettings *in_set )
 						set->force ? NULL :
 							dts->user,
 						err );
-	if( err->message )
-	{
-	    log->log( 0, "Error: Retrieving DTS defect list: %s", 
+	long listed = 0L;
+	defer_saves = dts_mod->has_bulk_save() || scm_mod->has_bulk_save();
+	if( !err->message )
+	    stop_process = run_pass( 1, dts_cursor, listed, err );
+	if( err->message && stop_process <= 0 )
+	{
+	    if( cycle_ret >= 0 )
+	        log->log( 0, "Error: Retrieving DTS defect list: %s", 
 			err->message );
-	    delete_DTGDate( scm_date );
-	    delete_DTGDate( dts_date );
-	    if( dts_defects )
-	        delete_DTGStrList( dts_defects );
+	    drop_dates();
+	    if( dts_cursor )
+	        dts_mod->cursor_free( dts_cursor, err );
 	    clear_DTGError( err );
+	    if( cycle_ret < 0 )
+	    {
+	        delete_DTGError( err );
+	        return cycle_ret;
+	    }
 	    int dts = dts_mod->dt_server_offline( dts_dtID, err );
 	    delete_DTGError( err );
 	    if( dts <= 0 && !reset_dts() )
 	        return -2;
 	    return -1;
 	}
+	dts_mod->cursor_free( dts_cursor, err );
+	clear_DTGError( err );
 	int ll = dts_mod->dt_get_message( dts_dtID, err );
 	if( ll < 4 )
 	    log->log( ll, err->message );
-	long items = 0L;
-	log_large_cycles( log, dts_defects, "DTS" );
-	for( struct DTGStrList *dts_d = dts_defects; 
-		dts_d && !stop_process; 
-		dts_d = dts_d->next )
-	{
-	    if( cur_dts ) delete[] cur_dts;
-	    if( cur_scm ) delete[] cur_scm;
-	    cur_dts = cp_string( dts_d->value );
-	    cur_scm = NULL;
-	    log_large_cycles( log, ++items );
-	    process_dts_defect( dts_d->value );
-	    stop_process = stop_exists();
-	}
-	if( stop_process || !dts_defects && stop_exists() )
+	if( stop_process || !listed && stop_exists() )
 	{
-	    delete_DTGDate( scm_date );
-	    delete_DTGDate( dts_date );
+	    drop_dates();
 	    delete_DTGError( err );
-	    delete_DTGStrList( dts_defects );
 	    return 0;
 	}
-	delete_DTGStrList( dts_defects );
 	
 	sprintf( since_string, "%4.4d/%2.2d/%2.2d %2.2d:%2.2d:%2.2d%s",
 		since_scm->year, since_scm->month, since_scm->day,
 		since_scm->hour, since_scm->minute, since_scm->second,
 		set->force ? " Force" : "" );
 	log->log( 2, "List SCM Defects since: %s", since_string );
-	struct DTGStrList *scm_defects = scm_mod->proj_list_changed_defects( 
+	void *scm_cursor = scm_mod->proj_open_changed_defects( 
 						scm_projID,
-						0,
+						LIST_PAGE,
 						since_scm,
 						scm->moddate_field,
 						set->force ? NULL :
@@ -1488,47 +2399,50 @@ int Unify::unify( DTGSettings *in_set )
 						set->force ? NULL :
 							scm->user,
 						err );
-	if( err->message )
+	listed = 0L;
+	if( !err->message )
+	    stop_process = run_pass( 0, scm_cursor, listed, err );
+	if( err->message && stop_process <= 0 )
 	{
-	    log->log( 0, 
+	    if( cycle_ret >= 0 )
+	        log->log( 0, 
 		"Error: Retrieving SCM defect list: %s", err->message );
-	    delete_DTGDate( scm_date );
-	    delete_DTGDate( dts_date );
-	    if( scm_defects )
-	        delete_DTGStrList( scm_defects );
+	    drop_dates();
+	    if( scm_cursor )
+	        scm_mod->cursor_free( scm_cursor, err );
 	    clear_DTGError( err );
+	    if( cycle_ret < 0 )
+	    {
+	        delete_DTGError( err );
+	        return cycle_ret;
+	    }
 	    int scm = scm_mod->dt_server_offline( scm_dtID, err );
 	    delete_DTGError( err );
 	    if( scm <= 0 && !reset_scm() )
 	        return -2;
 	    return -1;
 	}
+	scm_mod->cursor_free( scm_cursor, err );
+	clear_DTGError( err );
 	ll = scm_mod->dt_get_message( scm_dtID, err );
 	if( ll < 4 )
 	    log->log( ll, err->message );
-	items = 0L;
-	log_large_cycles( log, scm_defects, "SCM" );
-	for( struct DTGStrList *scm_d = scm_defects; 
-		scm_d && !stop_process; 
-		scm_d = scm_d->next )
+	if( stop_process || !listed && stop_exists() )
 	{
-	    if( cur_dts ) delete[] cur_dts;
-	    if( cur_scm ) delete[] cur_scm;
-	    cur_scm = cp_string( scm_d->value );
-	    cur_dts = NULL;
-	    log_large_cycles( log, ++items );
-	    process_scm_defect( scm_d->value );
-	    stop_process = stop_exists();
+	    drop_dates();
+	    delete_DTGError( err );
+	    return 0;
 	}
-	if( stop_process || !scm_defects && stop_exists() )
+	defer_saves = 0;
+
+	// Defects left to retry by the last cycle are work for this one
+	if( ( scm_recheck || scm_failed ) && !scm_date &&
+		( cycle_ret = start_cycle() ) < 0 )
 	{
-	    delete_DTGDate( scm_date );
-	    delete_DTGDate( dts_date );
 	    delete_DTGError( err );
-	    delete_DTGStrList( scm_defects );
-	    return 0;
+	    return cycle_ret;
 	}
-	delete_DTGStrList( scm_defects );
+	control->progress.pass = ReplProgress::RECHECK;
 
 	for( struct DTGStrList *scm_d = scm_recheck; 
 		scm_d && !stop_process; 
@@ -1543,10 +2457,17 @@ int Unify::unify( DTGSettings *in_set )
 	}
 	delete_DTGStrList( scm_recheck );
 	scm_recheck = NULL;
+	if( journal && scm_date && !stop_process )
+	{
+	    journal->end_recheck();
+	    journal->record_lists( NULL, scm_failed );
+	    journal->checkpoint();
+	}
+	if( scm_index && !stop_process )
+	    scm_index->sync();
 	if( stop_process || stop_exists() )
 	{
-	    delete_DTGDate( scm_date );
-	    delete_DTGDate( dts_date );
+	    drop_dates();
 	    delete_DTGError( err );
 	    return 0;
 	}
@@ -1566,16 +2487,27 @@ int Unify::unify( DTGSettings *in_set )
 	scm_failed = NULL;
 	if( stop_process || stop_exists() )
 	{
-	    delete_DTGDate( scm_date );
-	    delete_DTGDate( dts_date );
+	    drop_dates();
 	    delete_DTGError( err );
 	    return 0;
 	}
 
-	set_DTGDate( set->last_update_scm, scm_date );
-	set_DTGDate( set->last_update_dts, dts_date );
-	delete_DTGDate( scm_date );
-	delete_DTGDate( dts_date );
+	// Nothing changed: the watermarks only move now and then, so the
+	// next cycle lists the same window and settings are left alone
+	if( !scm_date && ( set->force ||
+		(long)time( NULL ) - last_advance >= WATERMARK_PERIOD ) &&
+		( cycle_ret = start_cycle() ) < 0 )
+	{
+	    delete_DTGError( err );
+	    return cycle_ret;
+	}
+	if( scm_date )
+	{
+	    set_DTGDate( set->last_update_scm, scm_date );
+	    set_DTGDate( set->last_update_dts, dts_date );
+	    last_advance = (long)time( NULL );
+	}
+	drop_dates();
 	delete_DTGError( err );
 
 	if( abort_run )
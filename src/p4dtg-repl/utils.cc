@@ -27,21 +27,23 @@ extern "C" {
 #include "Unify.h"
 #include "DataSource.h"
 #include "DataMapping.h"
+#include "FieldSnapshot.h"
 #include <genutils.h>
 #include <Logger.h>
 
-char *pass_filter( struct DTGFieldDesc *filters, DTGModule *mod, void *defectID )
+char *pass_filter( struct DTGFieldDesc *filters, FieldSnapshot *snap, 
+			void *defectID )
 {
 	if( !filters )
 	    return NULL;
-	if( !mod || !defectID )
+	if( !snap || !defectID )
 	    return mk_string( "Unknown defect or module" );
 	struct DTGError *err = new_DTGError( NULL );
 	char *msg = NULL;
 	for( struct DTGFieldDesc *f = filters; !msg && f; f = f->next )
 	{
 	    char *value = 
-		mod->defect_get_field( defectID, f->name, err );
+		snap->get( defectID, f->name, err );
 	    if( !in_DTGStrList( value, f->select_values ) )
 	        msg = mk_string( "Field: ", f->name, "Value: ", value );
 	    free( value );
@@ -52,7 +54,7 @@ char *pass_filter( struct DTGFieldDesc *filters, DTGModule *mod, void *defectID
 
 /* scm_stat/dts_stat: -1 = new, 0 = unchanged, 1 = changed */
 
-int set_field( DTGModule *mod, void *defectID, const char *field, 
+int set_field( FieldSnapshot *snap, void *defectID, const char *field, 
 		const char *new_val, const char *old_val,
 		struct DTGError *&err )
 {
@@ -69,6 +71,6 @@ int set_field( DTGModule *mod, void *defectID, const char *field,
 	else if( !old_val || !*old_val )
 	    return 0;
 	// printf( "%s: [%s] -> [%s]\n", field, old_val, new_val );
-	mod->defect_set_field( defectID, field, new_val, err );
+	snap->set( defectID, field, new_val, err );
 	return 1;
 }
@@ -20,12 +20,13 @@
 #define UNIFYUTILS_HEADER
 
 class Logger;
+class FieldSnapshot;
 
 extern char *pass_filter( struct DTGFieldDesc *filters, 
-			DTGModule *mod, 
+			FieldSnapshot *snap, 
 			void *defectID );
 /* scm_stat/dts_stat: -1 = new, 0 = unchanged, 1 = changed */
-extern int set_field( DTGModule *mod, void *defectID, const char *field, 
+extern int set_field( FieldSnapshot *snap, void *defectID, const char *field, 
 		const char *new_val, const char *old_val,
 		struct DTGError *&err );
 
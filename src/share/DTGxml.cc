@@ -160,47 +160,31 @@ int load_p4dtg_config( const char *file,
 	return 1;
 }
 
-static int create_backup( const char *file )
+/*
+	Move a fully written tmp over file, keeping the previous file as
+	file.old. The rename is atomic, so a reader or a full disk never
+	sees a partial settings file, and the backup is a link rather
+	than a copy.
+*/
+static int replace_file( const char *tmp, const char *file )
 {
-	FILE *cur = fopen( file, "r" );
-	if( !cur )
-	    return errno == ENOENT;
- 
 	char *backup = mk_string( file, ".old" );
 	if( unlink( backup ) && errno != ENOENT )
 	{
 	    delete[] backup;
-	    fclose( cur );
 	    return 0;
 	}
-
-	FILE *old = fopen( backup, "w" );
-	if( !old )
+#ifdef _WIN32
+	int failed = rename( file, backup ) && errno != ENOENT;
+#else
+	int failed = link( file, backup ) && errno != ENOENT;
+#endif
+	delete[] backup;
+	if( failed || rename( tmp, file ) )
 	{
-	    delete[] backup;
-	    fclose( cur );
+	    unlink( tmp );
 	    return 0;
 	}
- 
-	char copybuf[1024];
-	int r = 0;
-	int w = 0;
-	while( ( r = fread( copybuf, 1, sizeof( copybuf ), cur ) ) > 0 )
-	{
-	    w = fwrite( copybuf, 1, r, old );
-	    if( w < r )
-	    {
-	        unlink( backup );
-	        delete[] backup;
-	        fclose( old );
-	        fclose( cur );
-	        return 0;
-	    }
-	}
- 
-	delete[] backup;
-	fclose( old );
-	fclose( cur );
 	return 1;
 }
 
@@ -409,10 +393,14 @@ int save_p4dtg_settings( const char *file, DTGSettings *settings )
 	if( settings )
 	    settings->save( me );
 
-	/* Try to create backup, if it fails, the previous values will be ok */
-	int failure = 1;
-	if( create_backup( file ) )
-	    failure = !docOUT->SaveFile( file );
+	/* Written aside first, if it fails, the previous values will be ok */
+	char *tmp = mk_string( file, ".tmp" );
+	int failure = !docOUT->SaveFile( tmp );
+	if( failure )
+	    unlink( tmp );
+	else
+	    failure = !replace_file( tmp, file );
+	delete[] tmp;
 	if( !failure && settings )
 	    settings->dirty = 0;
 	delete docOUT;
@@ -17,6 +17,7 @@
 */
 
 #include <stdlib.h>
+#include <ctype.h>
 
 #include <DTG-interface.h>
 #include "DataMapping.h"
@@ -72,6 +73,49 @@ struct DTGAttribute *DataMapping::get_attributes()
 		"100. The default is 5 seconds.",
                 "5",
                 0 ) );
+            cached_attributes = append_DTGAttribute( cached_attributes, 
+							new_DTGAttribute(
+                "polling_min",
+                "Minimum Polling Period",
+		"Specifies the number of seconds the replication engine waits "
+		"after a replication cycle that found changes. A cycle that "
+		"found changes and ran for longer is followed at once. "
+		"Minimum is 0, meaning the polling period; maximum is 100. "
+		"The default is 0.",
+                "0",
+                0 ) );
+            cached_attributes = append_DTGAttribute( cached_attributes, 
+							new_DTGAttribute(
+                "polling_max",
+                "Maximum Polling Period",
+		"Specifies the longest wait, in seconds, the polling period "
+		"backs off to while replication cycles find no changes. "
+		"Minimum is 0, meaning the polling period; maximum is 3600. "
+		"The default is 0. The polling period is fixed unless this or "
+		"the minimum polling period differs from it.",
+                "0",
+                0 ) );
+            cached_attributes = append_DTGAttribute( cached_attributes, 
+							new_DTGAttribute(
+                "polling_backoff",
+                "Polling Backoff",
+		"Specifies the factor the wait is multiplied by after each "
+		"replication cycle that found no changes, up to the maximum "
+		"polling period. Minimum is 1; maximum is 10. The default "
+		"is 2.",
+                "2",
+                0 ) );
+            cached_attributes = append_DTGAttribute( cached_attributes, 
+							new_DTGAttribute(
+                "watermark_period",
+                "Idle Watermark Period",
+		"Specifies how often, in seconds, replication cycles that "
+		"find no changes move the last update dates forward and save "
+		"them. A restart lists again the changes since the dates last "
+		"saved. Minimum is 0, moving them on every cycle; maximum is "
+		"86400. The default is 600.",
+                "600",
+                0 ) );
             cached_attributes = append_DTGAttribute( cached_attributes, 
 							new_DTGAttribute(
                 "connection_reset",
@@ -124,6 +168,49 @@ struct DTGAttribute *DataMapping::get_attributes()
 		"may reject such writes.",
                 "0",
                 0 ) );
+	    char workers_desc[512];
+	    sprintf( workers_desc,
+		"Specifies the number of defects/issues/jobs the replication "
+		"engine unifies in parallel during a replication cycle. Each "
+		"worker opens its own connection to both servers. Minimum is "
+		"1; maximum is %d. The default is 1, processing one defect at "
+		"a time.", MAX_WORKER_THREADS );
+            cached_attributes = append_DTGAttribute( cached_attributes, 
+							new_DTGAttribute(
+                "worker_threads",
+                "Replication Worker Threads",
+		workers_desc,
+                "1",
+                0 ) );
+            cached_attributes = append_DTGAttribute( cached_attributes, 
+							new_DTGAttribute(
+                "log_queue",
+                "Log Queue Size",
+		"Specifies the number of log entries that can wait to be "
+		"written by a background log writer, so replication does not "
+		"wait on the log file. Minimum is 0; maximum is 1,000,000. The "
+		"default is 0, writing each entry as it is logged.",
+                "0",
+                0 ) );
+            cached_attributes = append_DTGAttribute( cached_attributes, 
+							new_DTGAttribute(
+                "log_queue_drop",
+                "Drop Log Entries When Queue Full",
+		"Specifies what happens when the log queue is full: 0 waits "
+		"for room (default); 1 drops the entry and records how many "
+		"were dropped.",
+                "0",
+                0 ) );
+            cached_attributes = append_DTGAttribute( cached_attributes, 
+							new_DTGAttribute(
+                "call_stats",
+                "Plug-in Call Statistics",
+		"Specifies whether to time the calls made to the plug-ins: 1 "
+		"logs the number and duration of the calls made during each "
+		"replication cycle and writes the totals to repl/stats-MAP; "
+		"0 turns timing off (default).",
+                "0",
+                0 ) );
 	}
 	return cached_attributes;
 }
@@ -187,6 +274,50 @@ char *DataMapping::validate_attribute( DataAttr *a )
 			"Polling period: Must be a number between 1 and 100" );
 	    return NULL;
 	}
+	if( !strcmp( a->name, "polling_min" ) )
+	{
+	    if( !is_number( a->value ) )
+	        return strdup( 
+		    "Minimum polling period: Must be a number between 0 and 100" );
+	    int n = atoi( a->value );
+	    if( n < 0 || n > 100 )
+	        return strdup( 
+		    "Minimum polling period: Must be a number between 0 and 100" );
+	    return NULL;
+	}
+	if( !strcmp( a->name, "polling_max" ) )
+	{
+	    if( !is_number( a->value ) )
+	        return strdup( 
+		    "Maximum polling period: Must be a number between 0 and 3600" );
+	    int n = atoi( a->value );
+	    if( n < 0 || n > 3600 )
+	        return strdup( 
+		    "Maximum polling period: Must be a number between 0 and 3600" );
+	    return NULL;
+	}
+	if( !strcmp( a->name, "polling_backoff" ) )
+	{
+	    if( !is_number( a->value ) )
+	        return strdup( 
+			"Polling backoff: Must be a number between 1 and 10" );
+	    int n = atoi( a->value );
+	    if( n < 1 || n > 10 )
+	        return strdup( 
+			"Polling backoff: Must be a number between 1 and 10" );
+	    return NULL;
+	}
+	if( !strcmp( a->name, "watermark_period" ) )
+	{
+	    if( !is_number( a->value ) )
+	        return strdup( 
+		"Idle watermark period: Must be a number between 0 and 86400" );
+	    int n = atoi( a->value );
+	    if( n < 0 || n > 86400 )
+	        return strdup( 
+		"Idle watermark period: Must be a number between 0 and 86400" );
+	    return NULL;
+	}
 	if( !strcmp( a->name, "connection_reset" ) )
 	{
 	    if( !is_number( a->value ) )
@@ -222,6 +353,44 @@ char *DataMapping::validate_attribute( DataAttr *a )
 				"be a number equal to or greater than 0" );
 	    return NULL;
 	}
+	if( !strcmp( a->name, "worker_threads" ) )
+	{
+	    int n = atoi( a->value );
+	    if( is_number( a->value ) && n >= 1 && n <= MAX_WORKER_THREADS )
+	        return NULL;
+	    char msg[80];
+	    sprintf( msg, "Worker threads: Must be a number between 1 and %d",
+			MAX_WORKER_THREADS );
+	    return strdup( msg );
+	}
+	if( !strcmp( a->name, "log_queue" ) )
+	{
+	    if( !is_number( a->value ) )
+	        return strdup( 
+		"Log queue size: Must be a number between 0 and 1000000" );
+	    int n = atoi( a->value );
+	    if( n < 0 || n > 1000000 )
+	        return strdup( 
+		"Log queue size: Must be a number between 0 and 1000000" );
+	    return NULL;
+	}
+	if( !strcmp( a->name, "log_queue_drop" ) )
+	{
+	    if( !is_number( a->value ) || 
+		*a->value < '0' || *a->value > '1' ||
+		a->value[1] )
+	        return strdup( "Drop log entries: Must be either 0 or 1" );
+	    return NULL;
+	}
+	if( !strcmp( a->name, "call_stats" ) )
+	{
+	    if( !is_number( a->value ) || 
+		*a->value < '0' || *a->value > '1' ||
+		a->value[1] )
+	        return strdup( 
+			"Plug-in call statistics: Must be either 0 or 1" );
+	    return NULL;
+	}
 	return strdup( "Unknown attribute" );
 }
 
@@ -303,6 +472,7 @@ DataMapping::DataMapping()
 	dts_to_scm_rules = NULL;
 	attrs = NULL;
 	cached_attributes = NULL;
+	plan = NULL;
 	next = NULL;
 }
 
@@ -336,6 +506,8 @@ DataMapping::~DataMapping()
 	    delete attrs;
 	if( cached_attributes )
 	    delete_DTGAttribute( cached_attributes );
+	if( plan )
+	    delete plan;
 	if( next )
 	    delete next;
 }
@@ -1039,3 +1211,144 @@ struct DTGStrList *DataMapping::dts_field_references()
 
 	return fields;
 }
+
+/* Build the plan the replication engine runs the copy rules from */
+
+void DataMapping::compile()
+{
+	if( plan )
+	    delete plan;
+	plan = new MapPlan( this );
+}
+
+ValueMap::ValueMap( int entries )
+{
+	size = entries > 0 ? entries * 2 : 1;
+	buckets = new Entry *[size];
+	memset( buckets, 0, sizeof(Entry *) * size );
+}
+
+ValueMap::~ValueMap()
+{
+	for( int i = 0; i < size; i++ )
+	    while( buckets[i] )
+	    {
+	        Entry *item = buckets[i];
+	        buckets[i] = item->next;
+	        delete item;
+	    }
+	delete[] buckets;
+}
+
+unsigned int ValueMap::hash( const char *key )
+{
+	unsigned int h = 2166136261u;
+	for( ; *key; key++ )
+	    h = ( h ^ (unsigned char)tolower( (unsigned char)*key ) ) 
+		* 16777619u;
+	return h;
+}
+
+int ValueMap::same( const char *a, const char *b )
+{
+	for( ; *a && *b; a++, b++ )
+	    if( tolower( (unsigned char)*a ) != tolower( (unsigned char)*b ) )
+	        return 0;
+	return *a == *b;
+}
+
+void ValueMap::add( const char *key, const char *value )
+{
+	if( !key || find( key ) )
+	    return;
+	unsigned int b = hash( key ) % size;
+	Entry *e = new Entry;
+	e->key = key;
+	e->value = value;
+	e->next = buckets[b];
+	buckets[b] = e;
+}
+
+const char *ValueMap::find( const char *key )
+{
+	for( Entry *e = buckets[hash( key ) % size]; e; e = e->next )
+	    if( same( e->key, key ) )
+	        return e->value;
+	return NULL;
+}
+
+MapPlan::MapPlan( DataMapping *map )
+{
+	int rules = 0;
+	CopyRule *cr;
+	for( cr = map->mirror_rules; cr; cr = cr->next, rules++ );
+	for( cr = map->dts_to_scm_rules; cr; cr = cr->next, rules++ );
+	for( cr = map->scm_to_dts_rules; cr; cr = cr->next, rules++ );
+	scm_fields = new const char *[rules + 1];
+	dts_fields = new const char *[rules + 1];
+	scm_cnt = dts_cnt = 0;
+
+	mirror = compile( map->mirror_rules, mirror_cnt );
+	dts_to_scm = compile( map->dts_to_scm_rules, dts_to_scm_cnt );
+	scm_to_dts = compile( map->scm_to_dts_rules, scm_to_dts_cnt );
+}
+
+MapPlan::~MapPlan()
+{
+	PlanRule *lists[] = { mirror, dts_to_scm, scm_to_dts };
+	int cnts[] = { mirror_cnt, dts_to_scm_cnt, scm_to_dts_cnt };
+	for( int l = 0; l < 3; l++ )
+	{
+	    for( int i = 0; i < cnts[l]; i++ )
+	    {
+	        delete lists[l][i].to_scm;
+	        delete lists[l][i].to_dts;
+	    }
+	    delete[] lists[l];
+	}
+	delete[] scm_fields;
+	delete[] dts_fields;
+}
+
+int MapPlan::slot( const char **fields, int &cnt, const char *name )
+{
+	for( int i = 0; i < cnt; i++ )
+	    if( !strcmp( fields[i], name ) )
+	        return i;
+	fields[cnt] = name;
+	return cnt++;
+}
+
+PlanRule *MapPlan::compile( CopyRule *rules, int &cnt )
+{
+	cnt = 0;
+	CopyRule *cr;
+	for( cr = rules; cr; cr = cr->next, cnt++ );
+	PlanRule *plan = new PlanRule[cnt];
+
+	PlanRule *pr = plan;
+	for( cr = rules; cr; cr = cr->next, pr++ )
+	{
+	    pr->rule = cr;
+	    pr->kind = cr->copy_type;
+	    if( pr->kind == CopyRule::UNMAP )
+	        pr->kind = CopyRule::TEXT;
+	    pr->scm_slot = slot( scm_fields, scm_cnt, cr->scm_field );
+	    pr->dts_slot = slot( dts_fields, dts_cnt, cr->dts_field );
+	    pr->to_scm = pr->to_dts = NULL;
+	    if( pr->kind != CopyRule::MAP )
+	        continue;
+
+	    int maps = 0;
+	    CopyMap *cm;
+	    for( cm = cr->mappings; cm; cm = cm->next, maps++ );
+	    pr->to_scm = new ValueMap( maps );
+	    pr->to_dts = new ValueMap( maps );
+	    for( cm = cr->mappings; cm; cm = cm->next )
+	    {
+	        pr->to_scm->add( cm->value1, cm->value2 );
+	        pr->to_dts->add( cm->value2, cm->value1 );
+	    }
+	}
+	return plan;
+}
@@ -28,6 +28,7 @@ struct DTGFieldDesc;
 class Logger;
 struct DTGStrList;
 class DataAttr;
+class MapPlan;
 
 class DataSource;
 
@@ -64,6 +65,10 @@ class DataMapping {
 
 	struct DTGAttribute *cached_attributes;
 
+	MapPlan *plan;	// set by compile()
+
+	static const int MAX_WORKER_THREADS = 32; // worker_threads bound
+
     public:
 	DataMapping();
 	~DataMapping();
@@ -82,6 +87,8 @@ class DataMapping {
 	void set_filters();
 
 	struct DTGStrList *dts_field_references();
+
+	void compile();
 };
 
 class FixRule {
@@ -147,4 +154,68 @@ class CopyMap {
 	CopyMap *copy();
 };
 
+/*
+	MAP values looked up ignoring case as strcasecmp does; the first
+	mapping of a value wins, as in the CopyMap list.
+*/
+
+class ValueMap {
+    protected:
+	struct Entry {
+	    const char *key;
+	    const char *value;
+	    Entry *next;
+	};
+
+	Entry **buckets;
+	int size;
+
+	static unsigned int hash( const char *key );
+	static int same( const char *a, const char *b );
+
+    public:
+	ValueMap( int entries );
+	~ValueMap();
+
+	void add( const char *key, const char *value );
+	const char *find( const char *key );
+};
+
+struct PlanRule {
+	CopyRule *rule;
+	CopyRule::CopyAction kind;	// UNMAP resolved to TEXT
+	int scm_slot;			// index into MapPlan::scm_fields
+	int dts_slot;			// index into MapPlan::dts_fields
+	ValueMap *to_scm;		// MAP: rule value1 -> value2
+	ValueMap *to_dts;		// MAP: rule value2 -> value1
+};
+
+/*
+	The copy rules of a DataMapping compiled for the replication engine:
+	each rule list as an array and every field the rules read listed
+	once per side. Names point into the rules of the map.
+*/
+
+class MapPlan {
+    protected:
+	PlanRule *compile( CopyRule *rules, int &cnt );
+	int slot( const char **fields, int &cnt, const char *name );
+
+    public:
+	PlanRule *mirror;
+	int mirror_cnt;
+	PlanRule *dts_to_scm;
+	int dts_to_scm_cnt;
+	PlanRule *scm_to_dts;
+	int scm_to_dts_cnt;
+
+	const char **scm_fields;
+	int scm_cnt;
+	const char **dts_fields;
+	int dts_cnt;
+
+	MapPlan( DataMapping *map );
+	~MapPlan();
+};
+
 #endif
@@ -20,6 +20,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <chrono>
 #ifndef _WIN32
 #include <unistd.h>
 typedef struct stat STRUCTSTAT;
@@ -35,6 +36,8 @@ typedef struct _stat STRUCTSTAT;
 #include "Logger.h"
 #include <genutils.h>
 
+static const int LOG_LINE = 1024;
+
 bool Logger::log_open()
 {
 #ifdef _WIN32
@@ -48,6 +51,18 @@ Logger::Logger( const char *path, int log_level )
 	fd = fopen( path, "a+" );
 	file = mk_string( path );
 	level = log_level;
+	stamp_time = 0;
+	stamp[0] = '\0';
+	checked = 0;
+	ring = NULL;
+	ring_size = 0;
+	head = 0;
+	tail = 0;
+	block_when_full = 1;
+	dropped = 0L;
+	stopping = 0;
+	sleeping = 0;
+	writer = NULL;
 	if( !fd )
 	    return;
 #ifdef _WIN32
@@ -58,6 +73,7 @@ Logger::Logger( const char *path, int log_level )
 
 Logger::~Logger()
 {
+	stop_async();
 #ifndef _WIN32
 	delete[] file;
 	file = NULL;
@@ -72,23 +88,95 @@ Logger::~Logger()
 #endif
 }
 
-int Logger::check_log()
+/*
+	Called at startup, before the replication workers log anything:
+	callers test ring without the lock.
+*/
+
+void Logger::set_async( int queue_size, bool block )
+{
+	stop_async();
+	if( queue_size <= 0 )
+	    return;
+
+	unsigned long size = 1;
+	while( size < (unsigned long)queue_size )
+	    size <<= 1;
+	ring = new Slot[size];
+	for( unsigned long i = 0; i < size; i++ )
+	{
+	    ring[i].seq = i;
+	    ring[i].when = 0;
+	    ring[i].line = NULL;
+	}
+	ring_size = size;
+	head = 0;
+	tail = 0;
+	block_when_full = block;
+	dropped = 0L;
+	stopping = 0;
+	sleeping = 0;
+	writer = new std::thread( &Logger::writer_loop, this );
+}
+
+void Logger::stop_async()
+{
+	if( !writer )
+	    return;
+	stopping = 1;
+	wake.notify_one();
+	writer->join();
+	delete writer;
+	writer = NULL;
+	for( unsigned long i = 0; i < ring_size; i++ )
+	    if( ring[i].line )
+	        delete[] ring[i].line;
+	delete[] ring;
+	ring = NULL;
+	ring_size = 0;
+}
+
+const char *Logger::get_stamp( time_t now )
+{
+	if( now != stamp_time )
+	{
+	    struct tm *hmm = gmtime( &now );
+	    snprintf( stamp, sizeof( stamp ), 
+		"%4.4d/%2.2d/%2.2d %2.2d:%2.2d:%2.2d UTC", 
+		hmm->tm_year + 1900,
+		hmm->tm_mon + 1,
+		hmm->tm_mday,
+		hmm->tm_hour,
+		hmm->tm_min,
+		hmm->tm_sec );
+	    stamp_time = now;
+	}
+	return stamp;
+}
+
+/* Re-opens a rotated (removed) log, looking at most once a second */
+
+int Logger::check_log( time_t now )
 {
 	if( !file )
 	    return 0;
 
 #ifndef _WIN32
+	if( now == checked )
+	    return fd != NULL;
+	checked = now;
 	STRUCTSTAT buf;
 	int i = stat( file, &buf );
 	if( i && errno == ENOENT )
 	{
-	    fclose( fd );
+	    if( fd )
+	        fclose( fd );
 	    fd = fopen( file, "a+" );
 	    if( !fd )
 	        return 0;
-	    log( 0, "Log re-opened" );
+	    fprintf( fd, "%s: Log re-opened\n", get_stamp( now ) );
 	}
-	return 1;
+	return fd != NULL;
 #else
 	fd = fopen( file, "a+" );
 	if( !fd )
@@ -97,17 +185,13 @@ int Logger::check_log()
 #endif
 }
 
-void Logger::log( int lvl, const char *msg, bool noflush )
+/* Caller holds lock */
+
+void Logger::write_line( time_t now, const char *line, bool noflush )
 {
-#ifndef _WIN32
-	if( !fd )
-	    return;
-#endif
-	if( lvl > level || !check_log() )
+	if( !check_log( now ) )
 	    return;
-	char *stamp = timestamp();
-	fprintf( fd, "%s: %s\n", stamp, msg );
-	delete[] stamp;
+	fprintf( fd, "%s: %s\n", get_stamp( now ), line );
 #ifndef _WIN32
 	if( !noflush )
 	    fflush( fd );
@@ -117,26 +201,147 @@ void Logger::log( int lvl, const char *msg, bool noflush )
 #endif
 }
 
-void Logger::log( int lvl, const char *fmt, const char *p1, bool noflush )
+void Logger::emit( const char *line, bool noflush )
+{
+	if( ring )
+	{
+	    queue( cp_string( line ) );
+	    return;
+	}
+	std::lock_guard<std::recursive_mutex> guard( lock );
+	write_line( time( NULL ), line, noflush );
+}
+
+/* Takes line; waits for room or drops it when the ring is full */
+
+void Logger::queue( char *line )
+{
+	time_t now = time( NULL );
+	unsigned long pos = head.load( std::memory_order_relaxed );
+	while( 1 )
+	{
+	    Slot *slot = &ring[pos & ( ring_size - 1 )];
+	    long diff = (long)
+		( slot->seq.load( std::memory_order_acquire ) - pos );
+	    if( !diff )
+	    {
+	        if( head.compare_exchange_weak( pos, pos + 1,
+					std::memory_order_relaxed ) )
+	        {
+	            slot->when = now;
+	            slot->line = line;
+	            slot->seq.store( pos + 1, std::memory_order_release );
+	            if( sleeping )
+	                wake.notify_one();
+	            return;
+	        }
+	    }
+	    else if( diff < 0 )
+	    {
+	        if( !block_when_full || stopping )
+	        {
+	            dropped++;
+	            delete[] line;
+	            return;
+	        }
+	        wake.notify_one();
+	        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+	        pos = head.load( std::memory_order_relaxed );
+	    }
+	    else
+	        pos = head.load( std::memory_order_relaxed );
+	}
+}
+
+/*
+	Writes out whatever is queued with one flush per batch, then sleeps
+	until woken by a caller or, at the latest, 100ms later.
+*/
+
+void Logger::writer_loop()
+{
+	while( 1 )
+	{
+	    int written = 0;
+	    {
+	        std::lock_guard<std::recursive_mutex> guard( lock );
+	        while( 1 )
+	        {
+	            Slot *slot = &ring[tail & ( ring_size - 1 )];
+	            if( slot->seq.load( std::memory_order_acquire ) != 
+			tail + 1 )
+	                break;
+	            write_line( slot->when, slot->line, 1 );
+	            delete[] slot->line;
+	            slot->line = NULL;
+	            slot->seq.store( tail + ring_size, 
+				std::memory_order_release );
+	            tail++;
+	            written++;
+	        }
+	        long lost = dropped.exchange( 0L );
+	        if( lost )
+	        {
+	            char msg[64];
+	            sprintf( msg, "Log queue full, dropped %ld lines", lost );
+	            write_line( time( NULL ), msg, 1 );
+	        }
+#ifndef _WIN32
+	        if( ( written || lost ) && fd )
+	            fflush( fd );
+#endif
+	    }
+	    if( written )
+	        continue;
+	    if( stopping )
+	        break;
+	    std::unique_lock<std::mutex> guard( wake_lock );
+	    sleeping = 1;
+	    wake.wait_for( guard, std::chrono::milliseconds( 100 ) );
+	    sleeping = 0;
+	}
+}
+
+/*
+	The level is tested before anything is formatted. Lines that do not
+	fit LOG_LINE are formatted again into a buffer of the right size.
+*/
+
+static char *format_line( char *buf, const char *fmt, 
+				const char *p1, const char *p2 )
+{
+	int n = snprintf( buf, LOG_LINE, fmt, p1, p2 );
+	if( n < LOG_LINE )
+	    return buf;
+	char *line = new char[n + 1];
+	snprintf( line, n + 1, fmt, p1, p2 );
+	return line;
+}
+
+void Logger::log( int lvl, const char *msg, bool noflush )
 {
 #ifndef _WIN32
 	if( !fd )
 	    return;
 #endif
-	if( lvl > level || !check_log() )
+	if( lvl > level )
 	    return;
-	char *stamp = timestamp();
-	fprintf( fd, "%s: ", stamp );
-	fprintf( fd, fmt, p1 );
-	fprintf( fd, "\n" );
-	delete[] stamp;
+	emit( msg, noflush );
+}
+
+void Logger::log( int lvl, const char *fmt, const char *p1, bool noflush )
+{
 #ifndef _WIN32
-	if( !noflush )
-	    fflush( fd );
-#else
-	fclose( fd );
-	fd = NULL;
+	if( !fd )
+	    return;
 #endif
+	if( lvl > level )
+	    return;
+	char buf[LOG_LINE];
+	char *line = format_line( buf, fmt, p1, NULL );
+	emit( line, noflush );
+	if( line != buf )
+	    delete[] line;
 }
 
 void Logger::log( int lvl, const char *fmt, 
@@ -147,18 +352,11 @@ void Logger::log( int lvl, const char *fmt,
 	if( !fd )
 	    return;
 #endif
-	if( lvl > level || !check_log() )
+	if( lvl > level )
 	    return;
-	char *stamp = timestamp();
-	fprintf( fd, "%s: ", stamp );
-	fprintf( fd, fmt, p1, p2 );
-	fprintf( fd, "\n" );
-	delete[] stamp;
-#ifndef _WIN32
-	if( !noflush )
-	    fflush( fd );
-#else
-	fclose( fd );
-	fd = NULL;
-#endif
+	char buf[LOG_LINE];
+	char *line = format_line( buf, fmt, p1, p2 );
+	emit( line, noflush );
+	if( line != buf )
+	    delete[] line;
 }
@@ -20,15 +20,55 @@
 #define LOGGING_HEADER
 
 #include <stdio.h>
+#include <time.h>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 
 class Logger 
 {
     protected:
 	FILE *fd;
 	char *file;
-	int level;
+	std::atomic<int> level;
+	std::recursive_mutex lock; // replication workers share one log
 
-	int check_log();
+	// Written with each line; rebuilt and the file checked once a second
+	time_t stamp_time;
+	char stamp[32];
+	time_t checked;
+
+	/*
+		Asynchronous mode: callers format their line and queue it in
+		a bounded ring; the writer thread writes the queue out in
+		batches. Each slot's seq says whose turn it is: i when free
+		for the caller claiming position i, i + 1 once filled.
+	*/
+	struct Slot {
+	    std::atomic<unsigned long> seq;
+	    time_t when;
+	    char *line;
+	};
+	Slot *ring;
+	unsigned long ring_size;	// a power of 2
+	std::atomic<unsigned long> head;	// next position to claim
+	unsigned long tail;		// next position to write
+	bool block_when_full;	// else drop the line
+	std::atomic<long> dropped;
+	std::atomic<bool> stopping;
+	std::atomic<bool> sleeping;
+	std::mutex wake_lock;
+	std::condition_variable wake;
+	std::thread *writer;
+
+	int check_log( time_t now );
+	const char *get_stamp( time_t now );
+	void write_line( time_t now, const char *line, bool noflush );
+	void emit( const char *line, bool noflush );
+	void queue( char *line );
+	void writer_loop();
+	void stop_async();
 
     public:
 	// level: 0 = errors, 1 = warnings, 2 = info
@@ -39,6 +79,9 @@ class Logger
 	void set_level( int use_level ) { level = use_level; };
 	int get_level() { return level; };
 
+	// queue_size 0 writes each line as it is logged
+	void set_async( int queue_size, bool block_when_full );
+
 	void log( int level, const char *msg, bool noflush = 0 );
 	void log( int level, const char *fmt, const char *p1, 
 			bool noflush = 0 );